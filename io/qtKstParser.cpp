@@ -6,9 +6,8 @@
 
 #include <QRegExp>
 
-#include <cerrno>
 #include <cmath>
-#include <cstdlib>
+#include <limits>
 
 #include "../core/qtMath.h"
 
@@ -16,10 +15,6 @@
 #define isspace { ERROR: isspace is broken on MSVC }
 #define isdigit { ERROR: isdigit is broken on MSVC }
 
-#ifdef Q_OS_WIN
-  #define strtoll _strtoi64
-#endif
-
 typedef const char* regex_pattern;
 
 #define XD "[\\dabcdef]"
@@ -89,23 +84,6 @@ static bool digitsValid(const QString& str, int base = 10)
   return true;
 }
 
-//-----------------------------------------------------------------------------
-static bool parseBasicLong(qint64& out, const QString& in)
-{
-  const QByteArray inLatin1 = in.toLatin1();
-
-  const int k = inLatin1.length();
-  if (k < 1 || !in[0].isDigit())
-    {
-    return false;
-    }
-
-  char* end;
-  errno = 0;
-  out = strtoll(inLatin1.constData(), &end, 10);
-  return (*end == 0 && errno == 0);
-}
-
 //-----------------------------------------------------------------------------
 static bool parseLong(qint64& out, const QString& ss, QString sip, QString sfp,
                       const QString& exp, const QString& b, int bmax = 36)
@@ -180,92 +158,6 @@ static bool parseLong(qint64& out, const QString& ss, QString sip, QString sfp,
   return okay;
 }
 
-//-----------------------------------------------------------------------------
-static bool parseBasicReal(double& out, const QString& in)
-{
-  const int k = in.length();
-  if (k < 1)
-    {
-    return false;
-    }
-
-  double result = 0.0;
-  double sign = 1.0;
-  double exp = 1.0;
-  int pos = 0;
-
-  // Test for sign
-  if (in[pos] == '-')
-    {
-    sign = -1.0;
-    ++pos; // skip sign
-    }
-  else if (in[pos] == '+')
-    {
-    ++pos; // skip sign
-    }
-
-  // Read integer part
-  while (pos < k)
-    {
-    const QChar d = in[pos];
-    if (!d.isDigit())
-      {
-      break;
-      }
-
-    result = 10.0 * result + d.digitValue();
-    ++pos;
-    }
-
-  // Check for decimal part
-  if (pos < k)
-    {
-    const QChar n = in[pos];
-    if (n == '.' || n == ',')
-      {
-      ++pos;
-
-      // Read fractional part
-      int dp = -1;
-      while (pos < k)
-        {
-        const QChar d = in[pos];
-        if (!d.isDigit())
-          {
-          break;
-          }
-
-        result += pow(10.0, dp) * d.digitValue();
-        ++pos;
-        --dp;
-        }
-      }
-
-    // Check for exponent
-    if (pos < k && result != 0.0 && in[pos].toLower() == 'e')
-      {
-      // Parse exponent part
-      qint64 e;
-      if (!parseBasicLong(e, in.mid(pos + 1)))
-        {
-        return false;
-        }
-      exp = pow(10.0, static_cast<double>(e));
-      }
-    }
-
-  // Either we're done, or ran into something we can't parse
-  if (pos < k)
-    {
-    return false;
-    }
-
-  // Success
-  out = sign * result * exp;
-  return true;
-}
-
 //-----------------------------------------------------------------------------
 static bool parseReal(double& out, const QString& ss, QString sip, QString sfp,
                       const QString& exp, const QString& b, int bmax = 36)
@@ -489,6 +381,271 @@ static bool parseArcReal(double& out, const QString& sign,
   return true;
 }
 
+//-----------------------------------------------------------------------------
+static const double powersOfTen[] = {
+  1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+  1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+static const quint64 maxLong =
+  static_cast<quint64>(std::numeric_limits<qint64>::max());
+
+// Bound on the magnitude of exponents used in arithmetic with digit counts;
+// exponents beyond this give values far outside the range of any result, so
+// they are clamped (or treated as overflowing) to keep the adjusted exponent
+// from overflowing
+static const qint64 maxExponent = Q_INT64_C(1) << 40;
+
+//-----------------------------------------------------------------------------
+static inline char toAscii(char c)
+{
+  return c;
+}
+
+//-----------------------------------------------------------------------------
+static inline char toAscii(QChar c)
+{
+  const ushort u = c.unicode();
+  return (u < 0x80 ? static_cast<char>(u) : '\0');
+}
+
+//-----------------------------------------------------------------------------
+static inline bool isAsciiDigit(char c)
+{
+  return c >= '0' && c <= '9';
+}
+
+//-----------------------------------------------------------------------------
+static inline QString toString(const char* in, int begin, int end)
+{
+  return QString::fromLatin1(in + begin, end - begin);
+}
+
+//-----------------------------------------------------------------------------
+static inline QString toString(const QChar* in, int begin, int end)
+{
+  return QString(in + begin, end - begin);
+}
+
+//-----------------------------------------------------------------------------
+// Location of the parts of a number in common decimal notation, i.e.
+// [+-][<digits>][[.,][<digits>]][e[+-]<digits>], within the input text
+struct DecimalNumber
+{
+  bool negative;
+  int integerBegin, integerEnd;
+  int fractionBegin, fractionEnd;
+  int exponentBegin, exponentEnd;
+  bool exponentNegative;
+  bool exponentOverflow;
+  qint64 exponent;
+
+  bool hasInteger() const
+    { return this->integerEnd > this->integerBegin; }
+
+  bool hasExponent() const
+    { return this->exponentEnd > this->exponentBegin; }
+
+  int digitCount() const
+    {
+    return (this->integerEnd - this->integerBegin) +
+           (this->fractionEnd - this->fractionBegin);
+    }
+};
+
+//-----------------------------------------------------------------------------
+template <typename Char>
+static unsigned digitAt(const Char* in, const DecimalNumber& n, int i)
+{
+  // Get i'th digit of the concatenated integer and fractional parts
+  const int ni = n.integerEnd - n.integerBegin;
+  const char c = toAscii(i < ni ? in[n.integerBegin + i]
+                                : in[n.fractionBegin + (i - ni)]);
+  return static_cast<unsigned>(c - '0');
+}
+
+//-----------------------------------------------------------------------------
+template <typename Char>
+static bool scanDecimal(DecimalNumber& n, const Char* in, int k)
+{
+  if (k < 1)
+    {
+    return false;
+    }
+
+  int pos = 0;
+
+  // Read sign
+  n.negative = false;
+  if (pos < k && (toAscii(in[pos]) == '-' || toAscii(in[pos]) == '+'))
+    {
+    n.negative = (toAscii(in[pos]) == '-');
+    ++pos;
+    }
+
+  // Read integer part
+  n.integerBegin = pos;
+  while (pos < k && isAsciiDigit(toAscii(in[pos])))
+    {
+    ++pos;
+    }
+  n.integerEnd = pos;
+
+  // Read fractional part, if any
+  n.fractionBegin = n.fractionEnd = pos;
+  if (pos < k && (toAscii(in[pos]) == '.' || toAscii(in[pos]) == ','))
+    {
+    n.fractionBegin = ++pos;
+    while (pos < k && isAsciiDigit(toAscii(in[pos])))
+      {
+      ++pos;
+      }
+    n.fractionEnd = pos;
+    }
+
+  // Read exponent, if any
+  n.exponent = 0;
+  n.exponentNegative = false;
+  n.exponentOverflow = false;
+  n.exponentBegin = n.exponentEnd = pos;
+  if (pos < k && (toAscii(in[pos]) == 'e' || toAscii(in[pos]) == 'E'))
+    {
+    n.exponentBegin = ++pos;
+    if (pos < k && (toAscii(in[pos]) == '-' || toAscii(in[pos]) == '+'))
+      {
+      n.exponentNegative = (toAscii(in[pos]) == '-');
+      ++pos;
+      }
+
+    const int digitsBegin = pos;
+    quint64 e = 0;
+    while (pos < k && isAsciiDigit(toAscii(in[pos])))
+      {
+      const unsigned d = static_cast<unsigned>(toAscii(in[pos]) - '0');
+      if (e > (maxLong - d) / 10)
+        {
+        n.exponentOverflow = true;
+        }
+      else
+        {
+        e = (10 * e) + d;
+        }
+      ++pos;
+      }
+    if (pos == digitsBegin)
+      {
+      return false;
+      }
+
+    n.exponentEnd = pos;
+    n.exponent = static_cast<qint64>(e);
+    if (n.exponentNegative)
+      {
+      n.exponent = -n.exponent;
+      }
+    }
+
+  // Anything else (e.g. a base suffix) must be handled by the full parser
+  return pos == k;
+}
+
+//-----------------------------------------------------------------------------
+template <typename Char>
+static bool evalLong(qint64& out, const Char* in, const DecimalNumber& n)
+{
+  if (n.exponentOverflow)
+    {
+    return false;
+    }
+
+  // Take digits up to the (exponent-adjusted) decimal point, padding with
+  // zeros if the exponent moves the point past the last digit; remaining
+  // fractional digits are discarded
+  const qint64 count = n.digitCount();
+  const qint64 exponent = qBound(-maxExponent, n.exponent, maxExponent);
+  const qint64 point = (n.integerEnd - n.integerBegin) + exponent;
+  const quint64 limit = maxLong + (n.negative ? 1 : 0);
+
+  quint64 acc = 0;
+  for (qint64 i = 0; i < point; ++i)
+    {
+    if (i >= count && acc == 0)
+      {
+      break; // only zeros remain
+      }
+
+    const unsigned d = (i < count ? digitAt(in, n, static_cast<int>(i)) : 0);
+    if (acc > (limit - d) / 10)
+      {
+      return false;
+      }
+    acc = (10 * acc) + d;
+    }
+
+  if (n.negative)
+    {
+    out = (acc ? -static_cast<qint64>(acc - 1) - 1 : 0);
+    }
+  else
+    {
+    out = static_cast<qint64>(acc);
+    }
+  return true;
+}
+
+//-----------------------------------------------------------------------------
+template <typename Char>
+static bool evalReal(double& out, const Char* in, const DecimalNumber& n)
+{
+  // Accumulate significant digits
+  const int count = n.digitCount();
+  quint64 m = 0;
+  int significant = 0;
+  for (int i = 0; i < count && significant <= 19; ++i)
+    {
+    const unsigned d = digitAt(in, n, i);
+    if (significant || d)
+      {
+      m = (10 * m) + d;
+      ++significant;
+      }
+    }
+
+  // A zero significand gives zero, whatever the exponent
+  if (!significant)
+    {
+    out = zero(n.negative);
+    return true;
+    }
+
+  // If the exponent is unreasonably large or small, return the respective
+  // overflow or underflow value, as the full parser would; this also keeps
+  // the adjustment of the exponent below from overflowing
+  if (n.exponentOverflow || qAbs(n.exponent) > maxExponent)
+    {
+    out = (n.exponentNegative ? zero(n.negative) : infinity(n.negative));
+    return true;
+    }
+
+  // If the significand and the power of ten are both exactly representable,
+  // a single multiplication or division gives a correctly rounded result
+  const qint64 e = n.exponent - (n.fractionEnd - n.fractionBegin);
+  if (significant <= 19 && m <= (1ULL << 53) && e >= -22 && e <= 22)
+    {
+    const double v = (e < 0 ? static_cast<double>(m) / powersOfTen[-e]
+                            : static_cast<double>(m) * powersOfTen[e]);
+    out = (n.negative ? -v : v);
+    return true;
+    }
+
+  // Otherwise, fall back to the arbitrary precision accumulator
+  return parseReal(out, QString(n.negative ? "-" : ""),
+                   toString(in, n.integerBegin, n.integerEnd),
+                   toString(in, n.fractionBegin, n.fractionEnd),
+                   toString(in, n.exponentBegin, n.exponentEnd),
+                   QString(), 10);
+}
+
 //-----------------------------------------------------------------------------
 #define PARSE_NUMBER(_pat, _func, ...) do { \
   QRegExp re(QString::fromUtf8(_pat)); \
@@ -497,14 +654,8 @@ static bool parseArcReal(double& out, const QString& sign,
   } while (0)
 
 //-----------------------------------------------------------------------------
-bool qtKstParser::parseLong(const QString& str, qint64& out)
+static bool parseExtendedLong(qint64& out, const QString& str)
 {
-  // Handle trivial case
-  if (parseBasicLong(out, str))
-    {
-    return true;
-    }
-
   // Handle common, hexadecimal and high-base numbers
   PARSE_NUMBER(reCommonNumber, parseLong,
                re.cap(1), re.cap(2), re.cap(4), re.cap(6), re.cap(8), 10);
@@ -524,16 +675,8 @@ bool qtKstParser::parseLong(const QString& str, qint64& out)
 }
 
 //-----------------------------------------------------------------------------
-bool qtKstParser::parseReal(const QString& str, double& out)
+static bool parseExtendedReal(double& out, const QString& str)
 {
-  // Handle trivial case
-  if (parseBasicReal(out, str))
-    {
-    return true;
-    }
-
-  QRegExp re;
-
   // Handle common, hexadecimal and high-base numbers
   PARSE_NUMBER(reCommonNumber, parseReal,
                re.cap(1), re.cap(2), re.cap(4), re.cap(6), re.cap(8), 10);
@@ -551,3 +694,56 @@ bool qtKstParser::parseReal(const QString& str, double& out)
   // No match
   return false;
 }
+
+//-----------------------------------------------------------------------------
+bool qtKstParser::parseLong(const QString& str, qint64& out)
+{
+  // Handle common case without allocations
+  DecimalNumber n;
+  if (scanDecimal(n, str.constData(), str.length()) && n.hasInteger())
+    {
+    return evalLong(out, str.constData(), n);
+    }
+
+  return parseExtendedLong(out, str.toLower());
+}
+
+//-----------------------------------------------------------------------------
+bool qtKstParser::parseReal(const QString& str, double& out)
+{
+  // Handle common case without allocations
+  DecimalNumber n;
+  if (scanDecimal(n, str.constData(), str.length()) &&
+      (n.hasInteger() || !n.hasExponent()))
+    {
+    return evalReal(out, str.constData(), n);
+    }
+
+  return parseExtendedReal(out, str.toLower());
+}
+
+//-----------------------------------------------------------------------------
+bool qtKstParser::parseLong(const char* str, int length, qint64& out)
+{
+  // Handle common case without allocations
+  DecimalNumber n;
+  if (scanDecimal(n, str, length) && n.hasInteger())
+    {
+    return evalLong(out, str, n);
+    }
+
+  return parseExtendedLong(out, QString::fromUtf8(str, length).toLower());
+}
+
+//-----------------------------------------------------------------------------
+bool qtKstParser::parseReal(const char* str, int length, double& out)
+{
+  // Handle common case without allocations
+  DecimalNumber n;
+  if (scanDecimal(n, str, length) && (n.hasInteger() || !n.hasExponent()))
+    {
+    return evalReal(out, str, n);
+    }
+
+  return parseExtendedReal(out, QString::fromUtf8(str, length).toLower());
+}
@@ -8,4 +8,8 @@ namespace qtKstParser
 {
   bool parseLong(const QString& str, qint64& out);
   bool parseReal(const QString& str, double& out);
+
+  // Parse from UTF-8 text
+  bool parseLong(const char* str, int length, qint64& out);
+  bool parseReal(const char* str, int length, double& out);
 }
@@ -7,40 +7,225 @@
 #include "qtKstParser.h"
 #include "qtKstSeparator.h"
 
-#include <QFile>
+#include <QCryptographicHash>
+#include <QDateTime>
 #include <QDebug>
-
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QIODevice>
+#include <QRunnable>
+#include <QSaveFile>
+#include <QSharedPointer>
+#include <QStandardPaths>
+#include <QTextCodec>
+#include <QThread>
+#include <QThreadPool>
+
+#include <cstring>
 #include <limits>
 
 QTE_IMPLEMENT_D_FUNC(qtKstReader)
 
+namespace // anonymous
+{
+
+// Number of bytes to read from the device at once when streaming
+const int streamChunkSize = 64 * 1024;
+
+// Minimum number of characters to keep buffered past the parse position when
+// streaming; this bounds the longest separator that can be reliably matched
+const int streamLookahead = 1024;
+
+// Minimum amount of data (in bytes) to be parsed by each task when loading in
+// parallel; smaller files are parsed sequentially
+const qint64 parallelChunkSize = 256 * 1024;
+
+// Number of chunks to create per thread when loading in parallel, so that
+// threads which finish early can pick up remaining work
+const int parallelChunksPerThread = 4;
+
+// Identifier and version of the binary cache format; the identifier also
+// serves to reject caches written on a machine of different endianness
+const quint32 cacheMagic = 0x4354534b; // "KSTC"
+const quint32 cacheVersion = 1;
+
+// Header of a binary cache file; this is followed by the key (padded to a
+// multiple of 8 bytes), then the nodes, then the text of all values
+struct CacheHeader
+{
+  quint32 magic;
+  quint32 version;
+  qint64 sourceSize;
+  qint64 sourceModified;
+  qint64 keySize;
+  qint64 nodeCount;
+  qint64 textSize;
+};
+
+// A record, or a value; records (and arrays) are followed by their values,
+// and the text of a value is a span in the text section (if offset is not
+// negative)
+struct CacheNode
+{
+  qint64 offset;
+  qint32 length;
+  qint32 count;
+};
+
+//-----------------------------------------------------------------------------
+qint64 cachePadding(qint64 size)
+{
+  return (8 - (size % 8)) % 8;
+}
+
+//-----------------------------------------------------------------------------
+QByteArray cacheKey(
+  const QString& path, const QRegExp& separator, const QRegExp& terminator)
+{
+  // The parse depends on the separators as well as the file contents, so
+  // they are part of the key
+  return QFileInfo(path).absoluteFilePath().toUtf8() + '\n' +
+         QByteArray::number(separator.patternSyntax()) + ':' +
+         separator.pattern().toUtf8() + '\n' +
+         QByteArray::number(terminator.patternSyntax()) + ':' +
+         terminator.pattern().toUtf8();
+}
+
+//-----------------------------------------------------------------------------
+QString cachePath(const QByteArray& key)
+{
+  const QString dir =
+    QStandardPaths::writableLocation(QStandardPaths::CacheLocation);
+  if (dir.isEmpty())
+    {
+    return QString();
+    }
+
+  const QByteArray hash =
+    QCryptographicHash::hash(key, QCryptographicHash::Sha1).toHex();
+  return dir + "/kst/" + QString::fromLatin1(hash) + ".kstc";
+}
+
+//-----------------------------------------------------------------------------
+template <typename Function>
+class FunctionTask : public QRunnable
+{
+public:
+  explicit FunctionTask(Function f) : function(f) {}
+  virtual void run() QTE_OVERRIDE { this->function(); }
+
+protected:
+  Function function;
+};
+
+//-----------------------------------------------------------------------------
+template <typename Function>
+QRunnable* makeTask(Function f)
+{
+  return new FunctionTask<Function>(f);
+}
+
+//-----------------------------------------------------------------------------
+bool matchesRaw(const char* data, qint64 size, qint64 pos,
+                const QByteArray& literal)
+{
+  const int n = literal.size();
+  return (size - pos >= n) && memcmp(data + pos, literal.constData(), n) == 0;
+}
+
+//-----------------------------------------------------------------------------
+uint takeRawCodePoint(const char* data, qint64 size, qint64& pos)
+{
+  const uchar lead = static_cast<uchar>(data[pos++]);
+  if (lead < 0x80)
+    {
+    return lead;
+    }
+
+  // Determine sequence length and initial bits from the lead byte
+  int n;
+  uint c;
+  if ((lead & 0xe0) == 0xc0)
+    {
+    n = 1;
+    c = lead & 0x1f;
+    }
+  else if ((lead & 0xf0) == 0xe0)
+    {
+    n = 2;
+    c = lead & 0x0f;
+    }
+  else if ((lead & 0xf8) == 0xf0)
+    {
+    n = 3;
+    c = lead & 0x07;
+    }
+  else
+    {
+    return QChar::ReplacementCharacter;
+    }
+
+  // Accumulate continuation bytes; stop at the first malformed byte
+  while (n--)
+    {
+    if (pos >= size || (static_cast<uchar>(data[pos]) & 0xc0) != 0x80)
+      {
+      return QChar::ReplacementCharacter;
+      }
+    c = (c << 6) | (static_cast<uchar>(data[pos++]) & 0x3f);
+    }
+  return c;
+}
+
+} // namespace <anonymous>
+
 //BEGIN qtKstReader value
 
 //-----------------------------------------------------------------------------
 class qtKstReader::Value
 {
 public:
+  Value() : offset(-1), length(0) {}
+
+  // If offset is not negative, the value's text is the span of length bytes
+  // at offset in the reader's raw (UTF-8) data, and value is empty
   QString value;
+  qint64 offset;
+  int length;
   qtKstReader::Record array;
 
   bool isEmpty() const;
-  bool readString(QString& out) const;
-  bool readInt(int& out) const;
-  bool readLong(qint64& out) const;
-  bool readReal(double& out) const;
-  bool readIntArray(QList<int>& out) const;
-  bool readLongArray(QList<qint64>& out) const;
-  bool readRealArray(QList<double>& out) const;
+  bool readString(QString& out, const char* raw) const;
+  bool readInt(int& out, const char* raw) const;
+  bool readLong(qint64& out, const char* raw) const;
+  bool readReal(double& out, const char* raw) const;
+
+  template <typename Container>
+  bool readIntArray(Container& out, const char* raw) const
+    { return this->readArray(out, raw, &Value::readInt); }
+
+  template <typename Container>
+  bool readLongArray(Container& out, const char* raw) const
+    { return this->readArray(out, raw, &Value::readLong); }
+
+  template <typename Container>
+  bool readRealArray(Container& out, const char* raw) const
+    { return this->readArray(out, raw, &Value::readReal); }
+
+  template <typename Container, typename T>
+  bool readArray(Container& out, const char* raw,
+                 bool (Value::*read)(T&, const char*) const) const;
 };
 
 //-----------------------------------------------------------------------------
 bool qtKstReader::Value::isEmpty() const
 {
-  return this->array.isEmpty() && this->value.isEmpty();
+  return this->array.isEmpty() && this->value.isEmpty() && this->offset < 0;
 }
 
 //-----------------------------------------------------------------------------
-bool qtKstReader::Value::readString(QString& out) const
+bool qtKstReader::Value::readString(QString& out, const char* raw) const
 {
   if (this->array.count() > 1)
     {
@@ -49,7 +234,13 @@ bool qtKstReader::Value::readString(QString& out) const
 
   if (this->array.count())
     {
-    return this->array[0].readString(out);
+    return this->array[0].readString(out, raw);
+    }
+
+  if (this->offset >= 0)
+    {
+    out = QString::fromUtf8(raw + this->offset, this->length);
+    return true;
     }
 
   out = this->value;
@@ -57,21 +248,31 @@ bool qtKstReader::Value::readString(QString& out) const
 }
 
 //-----------------------------------------------------------------------------
-bool qtKstReader::Value::readLong(qint64& out) const
+bool qtKstReader::Value::readLong(qint64& out, const char* raw) const
 {
-  QString v;
-  if (!this->readString(v))
+  if (this->array.count() > 1)
     {
     return false;
     }
-  return qtKstParser::parseLong(v.toLower(), out);
+
+  if (this->array.count())
+    {
+    return this->array[0].readLong(out, raw);
+    }
+
+  if (this->offset >= 0)
+    {
+    return qtKstParser::parseLong(raw + this->offset, this->length, out);
+    }
+
+  return qtKstParser::parseLong(this->value, out);
 }
 
 //-----------------------------------------------------------------------------
-bool qtKstReader::Value::readInt(int& out) const
+bool qtKstReader::Value::readInt(int& out, const char* raw) const
 {
   qint64 l;
-  if (!this->readLong(l))
+  if (!this->readLong(l, raw))
     {
     return false;
     }
@@ -88,214 +289,1088 @@ bool qtKstReader::Value::readInt(int& out) const
 }
 
 //-----------------------------------------------------------------------------
-bool qtKstReader::Value::readReal(double& out) const
+bool qtKstReader::Value::readReal(double& out, const char* raw) const
+{
+  if (this->array.count() > 1)
+    {
+    return false;
+    }
+
+  if (this->array.count())
+    {
+    return this->array[0].readReal(out, raw);
+    }
+
+  if (this->offset >= 0)
+    {
+    return qtKstParser::parseReal(raw + this->offset, this->length, out);
+    }
+
+  return qtKstParser::parseReal(this->value, out);
+}
+
+//-----------------------------------------------------------------------------
+template <typename Container, typename T>
+bool qtKstReader::Value::readArray(
+  Container& out, const char* raw,
+  bool (Value::*read)(T&, const char*) const) const
+{
+  if (this->array.isEmpty())
+    {
+    return false;
+    }
+
+  out.clear();
+  if (this->array.count() == 1 && this->array[0].isEmpty())
+    {
+    return true;
+    }
+
+  out.reserve(this->array.count());
+  foreach (auto const& v, this->array)
+    {
+    T e;
+    if (!(v.*read)(e, raw))
+      {
+      return false;
+      }
+    out.append(e);
+    }
+  return true;
+}
+
+//END qtKstReader value
+
+///////////////////////////////////////////////////////////////////////////////
+
+//BEGIN qtKstReader reader
+
+//-----------------------------------------------------------------------------
+class qtKstReaderPrivate
+{
+public:
+
+  explicit qtKstReaderPrivate(const QUrl& url,
+                              qtKstReader::LoadOptions options,
+                              const QRegExp& separator,
+                              const QRegExp& terminator);
+  explicit qtKstReaderPrivate(const QString& data,
+                              const QRegExp& separator,
+                              const QRegExp& terminator);
+  explicit qtKstReaderPrivate(QIODevice* device,
+                              const QRegExp& separator,
+                              const QRegExp& terminator);
+  explicit qtKstReaderPrivate(const qtKstReader::Record& record,
+                              const qtKstReaderPrivate& source);
+  explicit qtKstReaderPrivate(const QList<qtKstReader::Record>& records,
+                              const qtKstReaderPrivate& source);
+
+  bool isStreaming() const { return this->device_ != nullptr; }
+
+  bool loadCache(const QString& path,
+                 const QRegExp& separator, const QRegExp& terminator);
+  bool saveCache(const QString& path,
+                 const QRegExp& separator, const QRegExp& terminator) const;
+
+  int recordCount() const;
+  bool hasRecord(int record) const;
+  const qtKstReader::Record& record(int record) const;
+
+  bool fetchRecord();
+
+  template <typename T>
+  bool readColumn(QVector<T>& out, int value,
+                  bool (qtKstReader::Value::*read)(T&, const char*) const)
+    const;
+
+  bool valid_;
+  int record_;
+  int value_;
+
+  // Index of the first record in records_; this is always 0 unless streaming,
+  // in which case records_ holds only the current record
+  int base_;
+  QList<qtKstReader::Record> records_;
+
+  // Raw (UTF-8) data referenced by value spans, and the mapped file that owns
+  // it; these are shared with readers created by readArray / readTable
+  QSharedPointer<QFile> mapping_;
+  const char* raw_;
+
+protected:
+  void init(const QString& data,
+            const QRegExp& separator, const QRegExp& terminator);
+  bool initMapped(const QString& path, qtKstReader::LoadOptions options,
+                  const QRegExp& separator, const QRegExp& terminator);
+  bool findRawBoundaries(qint64 pos, QVector<qint64>& boundaries,
+                         const QByteArray& separator,
+                         const QByteArray& terminator) const;
+  bool skipRawRecord(qint64& pos, const QByteArray& separator,
+                     const QByteArray& terminator) const;
+  bool skipRawString(qint64& pos) const;
+  bool readRawParallel(const QVector<qint64>& boundaries,
+                       const QByteArray& separator,
+                       const QByteArray& terminator);
+  bool readRawRecords(qint64 pos, qint64 end,
+                      QList<qtKstReader::Record>& records,
+                      const QByteArray& separator,
+                      const QByteArray& terminator) const;
+  bool readRawRecord(qint64& pos, qtKstReader::Record& record,
+                     const QByteArray& separator,
+                     const QByteArray& terminator) const;
+  bool readRawString(qint64& pos, qtKstReader::Value& value) const;
+  bool readRawComment(qint64& pos) const;
+  void appendRaw(qtKstReader::Value& value,
+                 qint64 offset, qint64 length) const;
+
+  bool readCacheRecord(const CacheNode*& node, const CacheNode* end,
+                       int count, qtKstReader::Record& record) const;
+  void writeCacheRecord(const qtKstReader::Record& record,
+                        QByteArray& nodes, QByteArray& text) const;
+
+  bool hasData(int pos);
+  void fill(int pos);
+  bool readRecord(int& pos, qtKstReader::Record& record,
+                  qtKstSeparator& separator, qtKstSeparator& terminator);
+  bool readString(int& pos, QString& value);
+  bool readComment(int& pos);
+
+  qint64 rawSize_;
+
+  QString data_;
+  int pos_;
+
+  QIODevice* device_;
+  bool atEnd_;
+  QScopedPointer<QTextDecoder> decoder_;
+  QScopedPointer<qtKstSeparator> separator_;
+  QScopedPointer<qtKstSeparator> terminator_;
+};
+
+//-----------------------------------------------------------------------------
+qtKstReaderPrivate::qtKstReaderPrivate(
+  const QUrl& url, qtKstReader::LoadOptions options,
+  const QRegExp& separator, const QRegExp& terminator)
+  : valid_(false), record_(0), value_(0), base_(0), raw_(nullptr),
+    rawSize_(0), pos_(0), device_(nullptr), atEnd_(true)
+{
+  const QString path = url.toLocalFile();
+  const bool useCache = options.testFlag(qtKstReader::UseCache);
+  if (useCache && this->loadCache(path, separator, terminator))
+    {
+    return;
+    }
+
+  if (!this->initMapped(path, options, separator, terminator))
+    {
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text))
+      {
+      return;
+      }
+
+    init(QString::fromUtf8(file.readAll()), separator, terminator);
+    }
+
+  if (useCache && this->valid_)
+    {
+    this->saveCache(path, separator, terminator);
+    }
+}
+
+//-----------------------------------------------------------------------------
+qtKstReaderPrivate::qtKstReaderPrivate(
+  const QString& data, const QRegExp& separator, const QRegExp& terminator)
+  : valid_(false), record_(0), value_(0), base_(0), raw_(nullptr),
+    rawSize_(0), pos_(0), device_(nullptr), atEnd_(true)
+{
+  init(data, separator, terminator);
+}
+
+//-----------------------------------------------------------------------------
+qtKstReaderPrivate::qtKstReaderPrivate(
+  QIODevice* device, const QRegExp& separator, const QRegExp& terminator)
+  : valid_(false), record_(0), value_(0), base_(0), raw_(nullptr),
+    rawSize_(0), pos_(0), device_(device), atEnd_(false),
+    decoder_(QTextCodec::codecForName("UTF-8")->makeDecoder()),
+    separator_(new qtKstSeparator(separator)),
+    terminator_(new qtKstSeparator(terminator))
+{
+  if (!device || !device->isReadable())
+    {
+    this->device_ = nullptr;
+    this->atEnd_ = true;
+    return;
+    }
+
+  // Read only the first record; subsequent records are parsed on demand as
+  // the reader is advanced
+  this->valid_ = this->fetchRecord();
+}
+
+//-----------------------------------------------------------------------------
+qtKstReaderPrivate::qtKstReaderPrivate(
+  const qtKstReader::Record& record, const qtKstReaderPrivate& source)
+  : valid_(true), record_(0), value_(0), base_(0),
+    mapping_(source.mapping_), raw_(source.raw_), rawSize_(source.rawSize_),
+    pos_(0), device_(nullptr), atEnd_(true)
+{
+  this->records_.append(record);
+}
+
+//-----------------------------------------------------------------------------
+qtKstReaderPrivate::qtKstReaderPrivate(
+  const QList<qtKstReader::Record>& records, const qtKstReaderPrivate& source)
+  : valid_(true), record_(0), value_(0), base_(0), records_(records),
+    mapping_(source.mapping_), raw_(source.raw_), rawSize_(source.rawSize_),
+    pos_(0), device_(nullptr), atEnd_(true)
+{
+}
+
+//-----------------------------------------------------------------------------
+void qtKstReaderPrivate::init(
+  const QString& data, const QRegExp& separator, const QRegExp& terminator)
+{
+  if (data.isEmpty())
+    {
+    return;
+    }
+
+  this->data_ = data;
+
+  qtKstSeparator valueSeparator(separator);
+  qtKstSeparator recordTerminator(terminator);
+
+  int pos = 0;
+  while (pos < data.length())
+    {
+    qtKstReader::Record record;
+    if (!this->readRecord(pos, record, valueSeparator, recordTerminator))
+      {
+      this->data_.clear();
+      return;
+      }
+    if (record.count())
+      {
+      this->records_.append(record);
+      }
+    }
+  this->data_.clear();
+  this->valid_ = !this->records_.isEmpty();
+}
+
+//-----------------------------------------------------------------------------
+bool qtKstReaderPrivate::initMapped(
+  const QString& path, qtKstReader::LoadOptions options,
+  const QRegExp& separator, const QRegExp& terminator)
+{
+  // Raw parsing only supports literal separators; arbitrary regular
+  // expressions must be matched against decoded text
+  if (separator.patternSyntax() != QRegExp::FixedString ||
+      terminator.patternSyntax() != QRegExp::FixedString)
+    {
+    return false;
+    }
+
+  QSharedPointer<QFile> file(new QFile(path));
+  if (!file->open(QIODevice::ReadOnly))
+    {
+    return false;
+    }
+
+  const qint64 size = file->size();
+  uchar* const data = (size > 0 ? file->map(0, size) : nullptr);
+  if (!data)
+    {
+    return false;
+    }
+
+  this->mapping_ = file;
+  this->raw_ = reinterpret_cast<const char*>(data);
+  this->rawSize_ = size;
+
+  const QByteArray rawSeparator = separator.pattern().toUtf8();
+  const QByteArray rawTerminator = terminator.pattern().toUtf8();
+
+  // Skip byte order mark, if present
+  qint64 pos = 0;
+  if (size >= 3 && memcmp(this->raw_, "\xef\xbb\xbf", 3) == 0)
+    {
+    pos = 3;
+    }
+
+  // If requested, try to split the data into chunks that can be parsed in
+  // parallel; if this fails (i.e. the file is too small, or contains errors),
+  // fall back to parsing sequentially
+  QVector<qint64> boundaries;
+  const bool okay =
+    ((options & qtKstReader::ParallelLoad) &&
+     this->findRawBoundaries(pos, boundaries, rawSeparator, rawTerminator)
+     ? this->readRawParallel(boundaries, rawSeparator, rawTerminator)
+     : this->readRawRecords(pos, size, this->records_,
+                            rawSeparator, rawTerminator));
+
+  this->valid_ = okay && !this->records_.isEmpty();
+  if (!this->valid_)
+    {
+    this->records_.clear();
+    this->mapping_.clear();
+    this->raw_ = nullptr;
+    this->rawSize_ = 0;
+    }
+
+  return true;
+}
+
+//-----------------------------------------------------------------------------
+bool qtKstReaderPrivate::loadCache(
+  const QString& path, const QRegExp& separator, const QRegExp& terminator)
 {
-  QString v;
-  if (!this->readString(v))
+  const QFileInfo info(path);
+  const QByteArray key = cacheKey(path, separator, terminator);
+  const QString fileName = cachePath(key);
+  if (fileName.isEmpty() || !info.exists())
     {
     return false;
     }
-  return qtKstParser::parseReal(v.toLower(), out);
+
+  QSharedPointer<QFile> file(new QFile(fileName));
+  if (!file->open(QIODevice::ReadOnly))
+    {
+    return false;
+    }
+
+  const qint64 size = file->size();
+  if (size < static_cast<qint64>(sizeof(CacheHeader)))
+    {
+    return false;
+    }
+
+  const char* const data =
+    reinterpret_cast<const char*>(file->map(0, size));
+  if (!data)
+    {
+    return false;
+    }
+
+  // Check that the cache is current, and that its layout is consistent with
+  // its size (so that a truncated or corrupt cache is rejected)
+  CacheHeader header;
+  memcpy(&header, data, sizeof(header));
+  if (header.magic != cacheMagic || header.version != cacheVersion ||
+      header.sourceSize != info.size() ||
+      header.sourceModified != info.lastModified().toMSecsSinceEpoch() ||
+      header.keySize != key.size() || header.nodeCount < 0 ||
+      header.textSize < 0)
+    {
+    return false;
+    }
+
+  // Bound the section sizes by the file size before computing offsets from
+  // them, so that corrupt counts cannot overflow the arithmetic
+  const qint64 nodeOffset = static_cast<qint64>(sizeof(header)) +
+                            header.keySize + cachePadding(header.keySize);
+  if (nodeOffset > size || header.nodeCount >
+        (size - nodeOffset) / static_cast<qint64>(sizeof(CacheNode)))
+    {
+    return false;
+    }
+
+  const qint64 textOffset =
+    nodeOffset + header.nodeCount * static_cast<qint64>(sizeof(CacheNode));
+  if (header.textSize != size - textOffset ||
+      memcmp(data + sizeof(header), key.constData(), key.size()) != 0)
+    {
+    return false;
+    }
+
+  this->raw_ = data + textOffset;
+  this->rawSize_ = header.textSize;
+
+  // Rebuild the records; values refer to the cached text, so no text needs to
+  // be parsed or copied
+  const CacheNode* node =
+    reinterpret_cast<const CacheNode*>(data + nodeOffset);
+  const CacheNode* const end = node + header.nodeCount;
+  while (node < end)
+    {
+    const int count = (node++)->count;
+    qtKstReader::Record record;
+    if (!this->readCacheRecord(node, end, count, record))
+      {
+      this->records_.clear();
+      this->raw_ = nullptr;
+      this->rawSize_ = 0;
+      return false;
+      }
+    this->records_.append(record);
+    }
+
+  this->mapping_ = file;
+  this->valid_ = !this->records_.isEmpty();
+  return this->valid_;
+}
+
+//-----------------------------------------------------------------------------
+bool qtKstReaderPrivate::readCacheRecord(
+  const CacheNode*& node, const CacheNode* end,
+  int count, qtKstReader::Record& record) const
+{
+  if (count < 0 || end - node < count)
+    {
+    return false;
+    }
+
+  record.reserve(count);
+  while (count--)
+    {
+    if (node >= end)
+      {
+      return false;
+      }
+
+    const CacheNode& n = *(node++);
+    qtKstReader::Value value;
+    if (n.offset >= 0)
+      {
+      if (n.length < 0 || n.offset > this->rawSize_ ||
+          n.length > this->rawSize_ - n.offset)
+        {
+        return false;
+        }
+      value.offset = n.offset;
+      value.length = n.length;
+      }
+    if (n.count && !this->readCacheRecord(node, end, n.count, value.array))
+      {
+      return false;
+      }
+    record.append(value);
+    }
+
+  return true;
+}
+
+//-----------------------------------------------------------------------------
+bool qtKstReaderPrivate::saveCache(
+  const QString& path, const QRegExp& separator, const QRegExp& terminator)
+  const
+{
+  const QFileInfo info(path);
+  const QByteArray key = cacheKey(path, separator, terminator);
+  const QString fileName = cachePath(key);
+  if (fileName.isEmpty() ||
+      !QDir().mkpath(QFileInfo(fileName).absolutePath()))
+    {
+    return false;
+    }
+
+  QByteArray nodes;
+  QByteArray text;
+  foreach (auto const& record, this->records_)
+    {
+    CacheNode node = { -1, 0, record.count() };
+    nodes.append(reinterpret_cast<const char*>(&node), sizeof(node));
+    this->writeCacheRecord(record, nodes, text);
+    }
+
+  CacheHeader header;
+  header.magic = cacheMagic;
+  header.version = cacheVersion;
+  header.sourceSize = info.size();
+  header.sourceModified = info.lastModified().toMSecsSinceEpoch();
+  header.keySize = key.size();
+  header.nodeCount = nodes.size() / static_cast<int>(sizeof(CacheNode));
+  header.textSize = text.size();
+
+  // Write to a temporary file which replaces the cache only once complete,
+  // so that concurrent readers never see a partial cache
+  QSaveFile file(fileName);
+  if (!file.open(QIODevice::WriteOnly))
+    {
+    return false;
+    }
+
+  const QByteArray padding(cachePadding(key.size()), '\0');
+  file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+  file.write(key);
+  file.write(padding);
+  file.write(nodes);
+  file.write(text);
+  return file.commit();
+}
+
+//-----------------------------------------------------------------------------
+void qtKstReaderPrivate::writeCacheRecord(
+  const qtKstReader::Record& record, QByteArray& nodes, QByteArray& text) const
+{
+  foreach (auto const& value, record)
+    {
+    CacheNode node = { -1, 0, value.array.count() };
+    if (value.offset >= 0)
+      {
+      node.offset = text.size();
+      node.length = value.length;
+      text.append(this->raw_ + value.offset, value.length);
+      }
+    else if (!value.value.isEmpty())
+      {
+      const QByteArray utf8 = value.value.toUtf8();
+      node.offset = text.size();
+      node.length = utf8.size();
+      text.append(utf8);
+      }
+
+    nodes.append(reinterpret_cast<const char*>(&node), sizeof(node));
+    this->writeCacheRecord(value.array, nodes, text);
+    }
+}
+
+//-----------------------------------------------------------------------------
+int qtKstReaderPrivate::recordCount() const
+{
+  return this->base_ + this->records_.count();
+}
+
+//-----------------------------------------------------------------------------
+bool qtKstReaderPrivate::hasRecord(int record) const
+{
+  return record >= this->base_ && record < this->recordCount();
+}
+
+//-----------------------------------------------------------------------------
+const qtKstReader::Record& qtKstReaderPrivate::record(int record) const
+{
+  return this->records_[record - this->base_];
+}
+
+//-----------------------------------------------------------------------------
+bool qtKstReaderPrivate::fetchRecord()
+{
+  // Discard the previous record
+  this->base_ += this->records_.count();
+  this->records_.clear();
+
+  // Discard consumed data; this is only done once enough has accumulated, so
+  // that the cost of moving the unconsumed remainder is amortized
+  if (this->pos_ >= streamChunkSize)
+    {
+    this->data_.remove(0, this->pos_);
+    this->pos_ = 0;
+    }
+
+  while (this->hasData(this->pos_))
+    {
+    qtKstReader::Record record;
+    if (!this->readRecord(this->pos_, record,
+                          *this->separator_, *this->terminator_))
+      {
+      this->valid_ = false;
+      return false;
+      }
+    if (record.count())
+      {
+      this->records_.append(record);
+      return true;
+      }
+    }
+
+  return false;
+}
+
+//-----------------------------------------------------------------------------
+template <typename T>
+bool qtKstReaderPrivate::readColumn(
+  QVector<T>& out, int value,
+  bool (qtKstReader::Value::*read)(T&, const char*) const) const
+{
+  // Streaming readers retain only the current record, so cannot read a
+  // whole column
+  if (this->isStreaming())
+    {
+    out.clear();
+    return false;
+    }
+
+  // Convert directly into the output storage, in a single pass
+  const int count = this->records_.count();
+  out.resize(count);
+
+  T* const data = out.data();
+  for (int i = 0; i < count; ++i)
+    {
+    const qtKstReader::Record& r = this->records_[i];
+    if (value >= r.count() || !(r[value].*read)(data[i], this->raw_))
+      {
+      out.clear();
+      return false;
+      }
+    }
+
+  return true;
+}
+
+//-----------------------------------------------------------------------------
+bool qtKstReaderPrivate::hasData(int pos)
+{
+  // When streaming, ensure that there is enough buffered data past the
+  // current position that separators are not split across reads
+  if (!this->atEnd_ && this->data_.length() - pos < streamLookahead)
+    {
+    this->fill(pos);
+    }
+  return pos < this->data_.length();
+}
+
+//-----------------------------------------------------------------------------
+void qtKstReaderPrivate::fill(int pos)
+{
+  while (this->data_.length() - pos < streamLookahead)
+    {
+    const QByteArray& chunk = this->device_->read(streamChunkSize);
+    if (chunk.isEmpty())
+      {
+      // Wait for more data from sequential devices (e.g. pipes); anything
+      // else has no more data to give
+      if (this->device_->isSequential() &&
+          this->device_->waitForReadyRead(-1))
+        {
+        continue;
+        }
+      this->atEnd_ = true;
+      return;
+      }
+    this->data_ += this->decoder_->toUnicode(chunk);
+    }
+}
+
+//-----------------------------------------------------------------------------
+bool qtKstReaderPrivate::readRecord(
+  int& pos, qtKstReader::Record& record,
+  qtKstSeparator& separator, qtKstSeparator& terminator)
+{
+  const QString& data = this->data_;
+
+  // If the separator and terminator can only begin with specific characters,
+  // runs of value characters can be consumed in bulk, without attempting to
+  // match either at every position
+  const QChar separatorLead = separator.leadCharacter();
+  const QChar terminatorLead = terminator.leadCharacter();
+  const bool canSkip = !separatorLead.isNull() && !terminatorLead.isNull();
+
+  bool acceptString = true;
+  bool acceptValue = true;
+  bool acceptArray = true;
+
+  qtKstReader::Value value;
+  while (this->hasData(pos))
+    {
+    // Check for end of record
+    if (terminator.matches(data, pos))
+      {
+      pos += terminator.matchedLength();
+      record.append(value);
+      return true;
+      }
+
+    // Check for end of value
+    if (separator.matches(data, pos))
+      {
+      pos += separator.matchedLength();
+      record.append(value);
+      value = qtKstReader::Value();
+      acceptString = true;
+      acceptValue = true;
+      acceptArray = true;
+      continue;
+      }
+
+    // Take character
+    QChar c = data[pos++];
+    if (c.isSpace())
+      {
+      acceptString = true;
+      continue;
+      }
+
+    // Check for comment
+    if (c == '#')
+      {
+      if (!this->readComment(pos))
+        {
+        return false;
+        }
+      continue;
+      }
+
+    // Check for array
+    if (acceptArray && c == '[')
+      {
+      qtKstSeparator arrayTerminator(
+        QRegExp("]", Qt::CaseSensitive, QRegExp::FixedString));
+      if (!this->readRecord(pos, value.array,
+                            separator, arrayTerminator))
+        {
+        return false;
+        }
+      if (value.array.isEmpty())
+        {
+        qDebug() << "KST parse error: end of file encountered"
+                    " while looking for record terminator" << QChar(']');
+        return false;
+        }
+      acceptValue = false;
+      acceptArray = false;
+      continue;
+      }
+
+    // Check for value after array
+    if (!acceptValue)
+      {
+      qDebug() << "KST parse error at" << pos
+               << ": value not expected at this time";
+      return false;
+      }
+
+    // Check for string
+    if (acceptString && c == '"')
+      {
+      if (!this->readString(pos, value.value))
+        {
+        return false;
+        }
+      acceptArray = false;
+      continue;
+      }
+
+    // Value; note that, once in a value, quotes and brackets are no longer
+    // special, so a run ends only at whitespace, a comment, or a possible
+    // separator or terminator
+    acceptString = false;
+    acceptArray = false;
+
+    const int start = pos - 1;
+    if (canSkip)
+      {
+      const QChar* const chars = data.constData();
+      const int end = data.length();
+      while (pos < end)
+        {
+        const QChar n = chars[pos];
+        if (n == separatorLead || n == terminatorLead ||
+            n == '#' || n.isSpace())
+          {
+          break;
+          }
+        ++pos;
+        }
+      }
+    value.value.append(data.constData() + start, pos - start);
+    }
+
+  // A file may end with a comment or extra whitespace
+  if (acceptValue && record.isEmpty() &&
+      value.value.isEmpty() && this->recordCount())
+    {
+    return true;
+    }
+
+  qDebug() << "KST parse error: end of file encountered"
+              " while looking for record terminator"
+           << terminator.pattern();
+  return false;
+}
+
+//-----------------------------------------------------------------------------
+bool qtKstReaderPrivate::readString(int& pos, QString& value)
+{
+  const QString& data = this->data_;
+
+  while (this->hasData(pos))
+    {
+    // Take character
+    QChar c = data[pos++];
+
+    // Check for escape
+    if (c == '\\')
+      {
+      if (!this->hasData(pos + 1))
+        {
+        qDebug() << "KST parse error: escape character occurred at end of file";
+        return false;
+        }
+      c = data[pos++];
+      // Treat escaped newline as line continuation
+      if (c == '\n')
+        {
+        continue;
+        }
+      }
+    // Check for end of string
+    else if (c == '"')
+      {
+      return true;
+      }
+    value += c;
+    }
+
+  qDebug() << "KST parse error: end of file encountered"
+              " while looking for string terminator" << QChar('"');
+  return false;
 }
 
 //-----------------------------------------------------------------------------
-bool qtKstReader::Value::readIntArray(QList<int>& out) const
+bool qtKstReaderPrivate::readComment(int& pos)
 {
-  if (this->array.isEmpty())
-    {
-    return false;
-    }
+  const QString& data = this->data_;
 
-  out.clear();
-  if (this->array.count() == 1 && this->array[0].isEmpty())
+  while (this->hasData(pos))
     {
-    return true;
-    }
+    // Take character
+    QChar c = data[pos++];
 
-  foreach (auto const& v, this->array)
-    {
-    int e;
-    if (!v.readInt(e))
+    // Check for end of line
+    if (c == '\n')
       {
-      return false;
+      return true;
       }
-    out.append(e);
     }
-  return true;
+
+  qDebug() << "KST parse error: end of file encountered"
+              " while looking end of line following comment";
+  return false;
 }
 
 //-----------------------------------------------------------------------------
-bool qtKstReader::Value::readLongArray(QList<qint64>& out) const
+bool qtKstReaderPrivate::findRawBoundaries(
+  qint64 pos, QVector<qint64>& boundaries,
+  const QByteArray& separator, const QByteArray& terminator) const
 {
-  if (this->array.isEmpty())
-    {
-    return false;
-    }
+  const qint64 size = this->rawSize_;
+  const int threads = QThread::idealThreadCount();
+  const qint64 step =
+    qMax(parallelChunkSize,
+         (size - pos) / (qMax(1, threads) * parallelChunksPerThread));
 
-  out.clear();
-  if (this->array.count() == 1 && this->array[0].isEmpty())
+  if (threads < 2 || size - pos < 2 * step)
     {
-    return true;
+    return false;
     }
 
-  foreach (auto const& v, this->array)
+  // Record boundaries can only be found by scanning the data, since separators
+  // may appear in strings and comments; this uses the same grammar as the
+  // parser, but without building any values, so it is much cheaper
+  boundaries.append(pos);
+  qint64 next = pos + step;
+  while (pos < size)
     {
-    qint64 e;
-    if (!v.readLong(e))
+    if (!this->skipRawRecord(pos, separator, terminator))
       {
       return false;
       }
-    out.append(e);
+    if (pos >= next && pos < size)
+      {
+      boundaries.append(pos);
+      next = pos + step;
+      }
     }
-  return true;
+  boundaries.append(size);
+
+  return boundaries.count() > 2;
 }
 
 //-----------------------------------------------------------------------------
-bool qtKstReader::Value::readRealArray(QList<double>& out) const
+bool qtKstReaderPrivate::skipRawRecord(
+  qint64& pos, const QByteArray& separator, const QByteArray& terminator) const
 {
-  if (this->array.isEmpty())
-    {
-    return false;
-    }
+  const char* const data = this->raw_;
+  const qint64 size = this->rawSize_;
 
-  out.clear();
-  if (this->array.count() == 1 && this->array[0].isEmpty())
-    {
-    return true;
-    }
+  bool acceptString = true;
+  bool acceptValue = true;
+  bool acceptArray = true;
 
-  foreach (auto const& v, this->array)
+  // This must exactly mirror readRawRecord, except that errors are not
+  // reported; a failure causes the data to be re-parsed sequentially, which
+  // will report the error, while anything unexpected at the end of the data
+  // is reported by the task which parses the last chunk
+  while (pos < size)
     {
-    double e;
-    if (!v.readReal(e))
+    if (matchesRaw(data, size, pos, terminator))
       {
-      return false;
+      pos += terminator.size();
+      return true;
       }
-    out.append(e);
-    }
-  return true;
-}
 
-//END qtKstReader value
+    if (matchesRaw(data, size, pos, separator))
+      {
+      pos += separator.size();
+      acceptString = true;
+      acceptValue = true;
+      acceptArray = true;
+      continue;
+      }
 
-///////////////////////////////////////////////////////////////////////////////
+    const uint c = takeRawCodePoint(data, size, pos);
+    if (QChar::isSpace(c))
+      {
+      acceptString = true;
+      continue;
+      }
 
-//BEGIN qtKstReader reader
+    if (c == '#')
+      {
+      const char* const p =
+        static_cast<const char*>(memchr(data + pos, '\n', static_cast<size_t>(size - pos)));
+      pos = (p ? (p - data) + 1 : size);
+      continue;
+      }
 
-//-----------------------------------------------------------------------------
-class qtKstReaderPrivate
-{
-public:
+    if (acceptArray && c == '[')
+      {
+      static const QByteArray arrayTerminator{"]"};
+      if (!this->skipRawRecord(pos, separator, arrayTerminator))
+        {
+        return false;
+        }
+      acceptValue = false;
+      acceptArray = false;
+      continue;
+      }
 
-  explicit qtKstReaderPrivate(const QUrl& url,
-                              const QRegExp& separator,
-                              const QRegExp& terminator);
-  explicit qtKstReaderPrivate(const QString& data,
-                              const QRegExp& separator,
-                              const QRegExp& terminator);
-  explicit qtKstReaderPrivate(const qtKstReader::Record& record);
-  explicit qtKstReaderPrivate(const QList<qtKstReader::Record>& records);
+    if (!acceptValue)
+      {
+      return false;
+      }
 
-  bool valid_;
-  int record_;
-  int value_;
+    if (acceptString && c == '"')
+      {
+      if (!this->skipRawString(pos))
+        {
+        return false;
+        }
+      acceptArray = false;
+      continue;
+      }
 
-  QList<qtKstReader::Record> records_;
+    acceptString = false;
+    acceptArray = false;
+    }
 
-protected:
-  void init(const QString& data,
-            const QRegExp& separator, const QRegExp& terminator);
-  bool readRecord(const QString& data, int& pos, qtKstReader::Record& record,
-                  qtKstSeparator separator, qtKstSeparator terminator) const;
-  bool readString(const QString& data, int& pos, QString& value) const;
-  bool readComment(const QString& data, int& pos) const;
-};
+  return true;
+}
 
 //-----------------------------------------------------------------------------
-qtKstReaderPrivate::qtKstReaderPrivate(
-  const QUrl& url, const QRegExp& separator, const QRegExp& terminator)
-  : valid_(false), record_(0), value_(0)
+bool qtKstReaderPrivate::skipRawString(qint64& pos) const
 {
-  QFile file(url.toLocalFile());
-  if (!file.open(QIODevice::ReadOnly | QIODevice::Text))
+  const char* const data = this->raw_;
+  const qint64 size = this->rawSize_;
+
+  while (pos < size)
     {
-    return;
+    const char c = data[pos++];
+    if (c == '\\')
+      {
+      if (pos + 1 >= size)
+        {
+        return false;
+        }
+      ++pos;
+      }
+    else if (c == '"')
+      {
+      return true;
+      }
     }
 
-  init(QString::fromUtf8(file.readAll()), separator, terminator);
+  return false;
 }
 
 //-----------------------------------------------------------------------------
-qtKstReaderPrivate::qtKstReaderPrivate(
-  const QString& data, const QRegExp& separator, const QRegExp& terminator)
-  : valid_(false), record_(0), value_(0)
+bool qtKstReaderPrivate::readRawParallel(
+  const QVector<qint64>& boundaries,
+  const QByteArray& separator, const QByteArray& terminator)
 {
-  init(data, separator, terminator);
-}
+  const int chunks = boundaries.count() - 1;
+  QVector<QList<qtKstReader::Record>> results(chunks);
+  QVector<bool> okay(chunks, false);
 
-//-----------------------------------------------------------------------------
-qtKstReaderPrivate::qtKstReaderPrivate(const qtKstReader::Record& record)
-  : valid_(true), record_(0), value_(0)
-{
-  this->records_.append(record);
-}
+  // Get pointers to the result storage up front, so that the tasks do not
+  // touch the containers themselves (which are not thread safe)
+  QList<qtKstReader::Record>* const resultData = results.data();
+  bool* const okayData = okay.data();
 
-//-----------------------------------------------------------------------------
-qtKstReaderPrivate::qtKstReaderPrivate(
-  const QList<qtKstReader::Record>& records)
-  : valid_(true), record_(0), value_(0), records_(records)
-{
-}
+  QThreadPool pool;
+  for (int i = 0; i < chunks; ++i)
+    {
+    pool.start(makeTask([=, &boundaries, &separator, &terminator]{
+      okayData[i] = this->readRawRecords(boundaries[i], boundaries[i + 1],
+                                         resultData[i], separator, terminator);
+      }));
+    }
+  pool.waitForDone();
 
-//-----------------------------------------------------------------------------
-void qtKstReaderPrivate::init(
-  const QString& data, const QRegExp& separator, const QRegExp& terminator)
-{
-  if (data.isEmpty())
+  // Merge results in order
+  for (int i = 0; i < chunks; ++i)
     {
-    return;
+    if (!okay[i])
+      {
+      return false;
+      }
+    this->records_ += results[i];
     }
 
-  int pos = 0;
-  while (pos < data.length())
+  return true;
+}
+
+//-----------------------------------------------------------------------------
+bool qtKstReaderPrivate::readRawRecords(
+  qint64 pos, qint64 end, QList<qtKstReader::Record>& records,
+  const QByteArray& separator, const QByteArray& terminator) const
+{
+  while (pos < end)
     {
     qtKstReader::Record record;
-    if (!this->readRecord(data, pos, record, separator, terminator))
+    if (!this->readRawRecord(pos, record, separator, terminator))
       {
-      return;
+      return false;
       }
     if (record.count())
       {
-      this->records_.append(record);
+      records.append(record);
       }
     }
-  this->valid_ = !this->records_.isEmpty();
+
+  return true;
 }
 
 //-----------------------------------------------------------------------------
-bool qtKstReaderPrivate::readRecord(
-  const QString& data, int& pos, qtKstReader::Record& record,
-  qtKstSeparator separator, qtKstSeparator terminator) const
+bool qtKstReaderPrivate::readRawRecord(
+  qint64& pos, qtKstReader::Record& record,
+  const QByteArray& separator, const QByteArray& terminator) const
 {
+  const char* const data = this->raw_;
+  const qint64 size = this->rawSize_;
+
   bool acceptString = true;
   bool acceptValue = true;
   bool acceptArray = true;
 
   qtKstReader::Value value;
-  while (pos < data.length())
+  while (pos < size)
     {
     // Check for end of record
-    if (terminator.matches(data, pos))
+    if (matchesRaw(data, size, pos, terminator))
       {
-      pos += terminator.matchedLength();
+      pos += terminator.size();
       record.append(value);
       return true;
       }
 
     // Check for end of value
-    if (separator.matches(data, pos))
+    if (matchesRaw(data, size, pos, separator))
       {
-      pos += separator.matchedLength();
+      pos += separator.size();
       record.append(value);
       value = qtKstReader::Value();
       acceptString = true;
@@ -305,8 +1380,9 @@ bool qtKstReaderPrivate::readRecord(
       }
 
     // Take character
-    QChar c = data[pos++];
-    if (c.isSpace())
+    const qint64 start = pos;
+    const uint c = takeRawCodePoint(data, size, pos);
+    if (QChar::isSpace(c))
       {
       acceptString = true;
       continue;
@@ -315,7 +1391,7 @@ bool qtKstReaderPrivate::readRecord(
     // Check for comment
     if (c == '#')
       {
-      if (!this->readComment(data, pos))
+      if (!this->readRawComment(pos))
         {
         return false;
         }
@@ -325,10 +1401,8 @@ bool qtKstReaderPrivate::readRecord(
     // Check for array
     if (acceptArray && c == '[')
       {
-      const QRegExp arrayTerminator("]", Qt::CaseSensitive,
-                                    QRegExp::FixedString);
-      if (!this->readRecord(data, pos, value.array,
-                            separator, arrayTerminator))
+      static const QByteArray arrayTerminator{"]"};
+      if (!this->readRawRecord(pos, value.array, separator, arrayTerminator))
         {
         return false;
         }
@@ -354,7 +1428,7 @@ bool qtKstReaderPrivate::readRecord(
     // Check for string
     if (acceptString && c == '"')
       {
-      if (!this->readString(data, pos, value.value))
+      if (!this->readRawString(pos, value))
         {
         return false;
         }
@@ -365,52 +1439,75 @@ bool qtKstReaderPrivate::readRecord(
     // Value
     acceptString = false;
     acceptArray = false;
-    value.value += c;
+    this->appendRaw(value, start, pos - start);
     }
 
-  // A file may end with a comment or extra whitespace
-  if (acceptValue && record.isEmpty() &&
-      value.value.isEmpty() && this->records_.count())
+  // A file may end with a comment or extra whitespace (an empty file, or an
+  // unterminated array, is rejected by the caller)
+  if (acceptValue && record.isEmpty() && value.isEmpty())
     {
     return true;
     }
 
   qDebug() << "KST parse error: end of file encountered"
               " while looking for record terminator"
-           << terminator.pattern();
+           << QString::fromUtf8(terminator);
   return false;
 }
 
 //-----------------------------------------------------------------------------
-bool qtKstReaderPrivate::readString(const QString& data, int& pos,
-                                    QString& value) const
+bool qtKstReaderPrivate::readRawString(
+  qint64& pos, qtKstReader::Value& value) const
 {
-  while (pos < data.length())
+  const char* const data = this->raw_;
+  const qint64 size = this->rawSize_;
+
+  // Runs of unescaped characters are appended as spans of the raw data, so
+  // that strings without escapes need not be copied
+  qint64 start = pos;
+  while (pos < size)
     {
-    // Take character
-    QChar c = data[pos++];
+    // Take character (continuation bytes of multi-byte characters can never
+    // be mistaken for the ASCII characters we care about)
+    const char c = data[pos++];
 
     // Check for escape
     if (c == '\\')
       {
-      if (pos + 1 >= data.length())
+      if (pos + 1 >= size)
         {
         qDebug() << "KST parse error: escape character occurred at end of file";
         return false;
         }
-      c = data[pos++];
+      this->appendRaw(value, start, pos - 1 - start);
+
       // Treat escaped newline as line continuation
-      if (c == '\n')
+      if (data[pos] == '\n')
         {
-        continue;
+        start = ++pos;
+        }
+      else if (data[pos] == '\r' && data[pos + 1] == '\n')
+        {
+        start = (pos += 2);
+        }
+      else
+        {
+        // The escaped character begins the next run
+        start = pos++;
         }
       }
     // Check for end of string
     else if (c == '"')
       {
+      this->appendRaw(value, start, pos - 1 - start);
       return true;
       }
-    value += c;
+    // Drop carriage return from CR-LF, as reading in text mode would
+    else if (c == '\r' && pos < size && data[pos] == '\n')
+      {
+      this->appendRaw(value, start, pos - 1 - start);
+      start = pos;
+      }
     }
 
   qDebug() << "KST parse error: end of file encountered"
@@ -419,25 +1516,59 @@ bool qtKstReaderPrivate::readString(const QString& data, int& pos,
 }
 
 //-----------------------------------------------------------------------------
-bool qtKstReaderPrivate::readComment(const QString& data, int& pos) const
+bool qtKstReaderPrivate::readRawComment(qint64& pos) const
 {
-  while (pos < data.length())
-    {
-    // Take character
-    QChar c = data[pos++];
+  const size_t n = static_cast<size_t>(this->rawSize_ - pos);
+  const char* const p =
+    static_cast<const char*>(memchr(this->raw_ + pos, '\n', n));
 
-    // Check for end of line
-    if (c == '\n')
-      {
-      return true;
-      }
+  if (p)
+    {
+    pos = (p - this->raw_) + 1;
+    return true;
     }
 
+  pos = this->rawSize_;
   qDebug() << "KST parse error: end of file encountered"
               " while looking end of line following comment";
   return false;
 }
 
+//-----------------------------------------------------------------------------
+void qtKstReaderPrivate::appendRaw(
+  qtKstReader::Value& value, qint64 offset, qint64 length) const
+{
+  if (length <= 0)
+    {
+    return;
+    }
+
+  // Start a new span if the value is empty, or extend the existing span if the
+  // new text immediately follows it
+  if (value.offset < 0 && value.value.isEmpty())
+    {
+    value.offset = offset;
+    value.length = static_cast<int>(length);
+    return;
+    }
+  if (value.offset >= 0 && value.offset + value.length == offset)
+    {
+    value.length += static_cast<int>(length);
+    return;
+    }
+
+  // Otherwise, the value is discontiguous in the raw data and must be stored
+  // as materialized text
+  if (value.offset >= 0)
+    {
+    value.value = QString::fromUtf8(this->raw_ + value.offset, value.length);
+    value.offset = -1;
+    value.length = 0;
+    }
+  value.value += QString::fromUtf8(this->raw_ + offset,
+                                   static_cast<int>(length));
+}
+
 //END qtKstReader reader
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -456,6 +1587,13 @@ QRegExp qtKstReader::defaultTerminator()
   return QRegExp{";", Qt::CaseSensitive, QRegExp::FixedString};
 }
 
+//-----------------------------------------------------------------------------
+QString qtKstReader::cacheFile(
+  const QUrl& url, const QRegExp& separator, const QRegExp& terminator)
+{
+  return cachePath(cacheKey(url.toLocalFile(), separator, terminator));
+}
+
 //-----------------------------------------------------------------------------
 qtKstReader::qtKstReader() : d_ptr{nullptr}
 {
@@ -464,7 +1602,15 @@ qtKstReader::qtKstReader() : d_ptr{nullptr}
 //-----------------------------------------------------------------------------
 qtKstReader::qtKstReader(
   const QUrl& url, const QRegExp& separator, const QRegExp& terminator)
-  : d_ptr(new qtKstReaderPrivate(url, separator, terminator))
+  : d_ptr(new qtKstReaderPrivate(url, LoadOptions(), separator, terminator))
+{
+}
+
+//-----------------------------------------------------------------------------
+qtKstReader::qtKstReader(
+  const QUrl& url, LoadOptions options,
+  const QRegExp& separator, const QRegExp& terminator)
+  : d_ptr(new qtKstReaderPrivate(url, options, separator, terminator))
 {
 }
 
@@ -475,6 +1621,13 @@ qtKstReader::qtKstReader(
 {
 }
 
+//-----------------------------------------------------------------------------
+qtKstReader::qtKstReader(
+  QIODevice* device, const QRegExp& separator, const QRegExp& terminator)
+  : d_ptr(new qtKstReaderPrivate(device, separator, terminator))
+{
+}
+
 //-----------------------------------------------------------------------------
 qtKstReader::~qtKstReader()
 {
@@ -491,7 +1644,7 @@ bool qtKstReader::isValid() const
 #define TEST_RECORD_POINTER() do { \
   if (record < 0) \
     record = this->currentRecord(); \
-  if (this->isEndOfFile(record)) \
+  if (this->isEndOfFile(record) || !this->d_func()->hasRecord(record)) \
     return false; \
   } while(0)
 
@@ -516,7 +1669,7 @@ int qtKstReader::recordCount() const
     }
 
   QTE_D_CONST(qtKstReader);
-  return d->records_.count();
+  return d->recordCount();
 }
 
 //-----------------------------------------------------------------------------
@@ -534,7 +1687,12 @@ int qtKstReader::valueCount(int record) const
     record = d->record_;
     }
 
-  return d->records_[record].count();
+  if (!d->hasRecord(record))
+    {
+    return -1;
+    }
+
+  return d->record(record).count();
 }
 
 //-----------------------------------------------------------------------------
@@ -585,6 +1743,12 @@ bool qtKstReader::nextRecord()
   QTE_D(qtKstReader);
   d->record_++;
   d->value_ = 0;
+
+  if (d->isStreaming())
+    {
+    d->fetchRecord();
+    }
+
   return true;
 }
 
@@ -634,7 +1798,7 @@ bool qtKstReader::isValueEmpty(int value, int record) const
   TEST_POINTER();
 
   QTE_D_CONST(qtKstReader);
-  return d->records_[record][value].isEmpty();
+  return d->record(record)[value].isEmpty();
 }
 
 //-----------------------------------------------------------------------------
@@ -648,11 +1812,11 @@ bool qtKstReader::isArrayEmpty(int value, int record) const
   TEST_POINTER();
 
   QTE_D_CONST(qtKstReader);
-  const Record& r = d->records_[record][value].array;
+  const Record& r = d->record(record)[value].array;
 
   if (r.count() == 0)
     {
-    return d->records_[record][value].value.isEmpty();
+    return d->record(record)[value].isEmpty();
     }
 
   if (r.count() > 1)
@@ -669,10 +1833,22 @@ bool qtKstReader::isArrayEmpty(int value, int record) const
     { \
     TEST_POINTER(); \
     QTE_D_CONST(qtKstReader); \
-    return d->records_[record][value].read##_name(out); \
+    return d->record(record)[value].read##_name(out, d->raw_); \
     }
 #define READ_TYPE_ARRAY(_name, _type) \
-  READ_TYPE(_name##Array, QList<_type>)
+  READ_TYPE(_name##Array, QList<_type>) \
+  READ_TYPE(_name##Array, QVector<_type>)
+#define READ_TYPE_COLUMN(_name, _type) \
+  bool qtKstReader::read##_name##Column( \
+    QVector<_type>& out, int value) const \
+    { \
+    if (!this->isValid()) \
+      return false; \
+    if (value < 0) \
+      value = this->currentValue(); \
+    QTE_D_CONST(qtKstReader); \
+    return d->readColumn(out, value, &Value::read##_name); \
+    }
 
 READ_TYPE(String, QString)
 READ_TYPE(Int,    int)
@@ -681,6 +1857,9 @@ READ_TYPE(Real,   double)
 READ_TYPE_ARRAY(Int,  int)
 READ_TYPE_ARRAY(Long, qint64)
 READ_TYPE_ARRAY(Real, double)
+READ_TYPE_COLUMN(Int,  int)
+READ_TYPE_COLUMN(Long, qint64)
+READ_TYPE_COLUMN(Real, double)
 
 //-----------------------------------------------------------------------------
 bool qtKstReader::readArray(qtKstReader& out, int value, int record) const
@@ -694,13 +1873,13 @@ bool qtKstReader::readArray(qtKstReader& out, int value, int record) const
 
   TEST_POINTER();
 
-  const qtKstReader::Value& v = d->records_[record][value];
+  const qtKstReader::Value& v = d->record(record)[value];
   if (v.array.isEmpty())
     {
     return false;
     }
 
-  out.d_ptr.reset(new qtKstReaderPrivate(v.array));
+  out.d_ptr.reset(new qtKstReaderPrivate(v.array, *d));
   return true;
 }
 
@@ -716,7 +1895,7 @@ bool qtKstReader::readTable(qtKstReader& out, int value, int record) const
 
   QTE_D_CONST(qtKstReader);
 
-  const qtKstReader::Value& v = d->records_[record][value];
+  const qtKstReader::Value& v = d->record(record)[value];
   if (v.array.isEmpty())
     {
     return false;
@@ -732,7 +1911,7 @@ bool qtKstReader::readTable(qtKstReader& out, int value, int record) const
     records.append(r.array);
     }
 
-  out.d_ptr.reset(new qtKstReaderPrivate(records));
+  out.d_ptr.reset(new qtKstReaderPrivate(records, *d));
   return true;
 }
 
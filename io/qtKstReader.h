@@ -12,24 +12,53 @@
 #include <QScopedPointer>
 #include <QString>
 #include <QUrl>
+#include <QVector>
+
+class QIODevice;
 
 class qtKstReaderPrivate;
 
 class QTE_EXPORT qtKstReader
 {
 public:
+  enum LoadOption
+    {
+    // Parse the file using multiple threads; this is only used for local
+    // files with literal separators, and only when the file is large enough
+    // to benefit
+    ParallelLoad = 0x1,
+    // Store the parsed records in a binary cache, and load from the cache
+    // (rather than parsing) if the file has not changed since it was cached
+    UseCache = 0x2
+    };
+  Q_DECLARE_FLAGS(LoadOptions, LoadOption)
+
   qtKstReader();
   explicit qtKstReader(const QUrl& url,
                        const QRegExp& separator = defaultSeparator(),
                        const QRegExp& terminator = defaultTerminator());
+  qtKstReader(const QUrl& url, LoadOptions options,
+              const QRegExp& separator = defaultSeparator(),
+              const QRegExp& terminator = defaultTerminator());
   explicit qtKstReader(const QString& data,
                        const QRegExp& separator = defaultSeparator(),
                        const QRegExp& terminator = defaultTerminator());
+
+  // Streaming reader; records are parsed incrementally from the device as
+  // the reader advances, and only the current record is retained
+  explicit qtKstReader(QIODevice* device,
+                       const QRegExp& separator = defaultSeparator(),
+                       const QRegExp& terminator = defaultTerminator());
   ~qtKstReader();
 
   static QRegExp defaultSeparator();
   static QRegExp defaultTerminator();
 
+  // Location of the binary cache for a file (see UseCache)
+  static QString cacheFile(const QUrl& url,
+                           const QRegExp& separator = defaultSeparator(),
+                           const QRegExp& terminator = defaultTerminator());
+
   bool isValid() const;
 
   int recordCount() const;
@@ -54,6 +83,17 @@ public:
   bool readIntArray(QList<int>& out, int value = -1, int record = -1) const;
   bool readLongArray(QList<qint64>& out, int value = -1, int record = -1) const;
   bool readRealArray(QList<double>& out, int value = -1, int record = -1) const;
+  bool readIntArray(QVector<int>& out, int value = -1, int record = -1) const;
+  bool readLongArray(QVector<qint64>& out,
+                     int value = -1, int record = -1) const;
+  bool readRealArray(QVector<double>& out,
+                     int value = -1, int record = -1) const;
+
+  // Read the same value from every record (e.g. a column of a table); this
+  // fails for streaming readers, which do not retain every record
+  bool readIntColumn(QVector<int>& out, int value = -1) const;
+  bool readLongColumn(QVector<qint64>& out, int value = -1) const;
+  bool readRealColumn(QVector<double>& out, int value = -1) const;
 
   bool readArray(qtKstReader& out, int value = -1, int record = -1) const;
   bool readTable(qtKstReader& out, int value = -1, int record = -1) const;
@@ -68,4 +108,6 @@ private:
 
 };
 
+Q_DECLARE_OPERATORS_FOR_FLAGS(qtKstReader::LoadOptions)
+
 #endif
@@ -5,6 +5,7 @@
 #include "qtKstSeparator.h"
 
 #include <QRegExp>
+#include <QStringRef>
 
 QTE_IMPLEMENT_D_FUNC(qtKstSeparator)
 
@@ -21,6 +22,7 @@ public:
 
   virtual bool matches(const QString& data, int pos) = 0;
   virtual int matchedLength() const = 0;
+  virtual QChar leadCharacter() const { return QChar(); }
 
   const QString pattern;
 
@@ -39,14 +41,42 @@ public:
     { return new qtKstBasicSeparator(*this); }
 
   virtual bool matches(const QString& data, int pos)
-    { return data.mid(pos, this->patternLength) == this->pattern; }
+    {
+    return data.length() - pos >= this->patternLength &&
+           QStringRef(&data, pos, this->patternLength) == this->pattern;
+    }
 
   virtual int matchedLength() const
     { return this->patternLength; }
 
+  virtual QChar leadCharacter() const
+    { return (this->patternLength ? this->pattern.at(0) : QChar()); }
+
   const int patternLength;
 };
 
+//-----------------------------------------------------------------------------
+class qtKstCharacterSeparator : public qtKstSeparatorPrivate
+{
+public:
+  qtKstCharacterSeparator(const QString& pattern)
+    : qtKstSeparatorPrivate(pattern), character(pattern.at(0)) {}
+
+  virtual qtKstSeparatorPrivate* clone() const
+    { return new qtKstCharacterSeparator(*this); }
+
+  virtual bool matches(const QString& data, int pos)
+    { return pos < data.length() && data.at(pos) == this->character; }
+
+  virtual int matchedLength() const
+    { return 1; }
+
+  virtual QChar leadCharacter() const
+    { return this->character; }
+
+  const QChar character;
+};
+
 //-----------------------------------------------------------------------------
 class qtKstRegExpSeparator : public qtKstSeparatorPrivate
 {
@@ -80,7 +110,12 @@ qtKstSeparatorPrivate* qtKstSeparatorPrivate::create(const QRegExp& exp)
 {
   if (exp.patternSyntax() == QRegExp::FixedString)
     {
-    return new qtKstBasicSeparator(exp.pattern());
+    const QString& pattern = exp.pattern();
+    if (pattern.length() == 1)
+      {
+      return new qtKstCharacterSeparator(pattern);
+      }
+    return new qtKstBasicSeparator(pattern);
     }
   return new qtKstRegExpSeparator(exp);
 }
@@ -124,6 +159,13 @@ int qtKstSeparator::matchedLength() const
   return d->matchedLength();
 }
 
+//-----------------------------------------------------------------------------
+QChar qtKstSeparator::leadCharacter() const
+{
+  QTE_D_CONST(qtKstSeparator);
+  return d->leadCharacter();
+}
+
 //-----------------------------------------------------------------------------
 QString qtKstSeparator::pattern() const
 {
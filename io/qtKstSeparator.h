@@ -4,6 +4,8 @@
 
 #include "../core/qtGlobal.h"
 
+#include <QChar>
+
 class QRegExp;
 class QString;
 
@@ -19,6 +21,10 @@ public:
   bool matches(const QString& data, int pos);
   int matchedLength() const;
 
+  // Character with which every match begins, or a null character if a match
+  // may begin with any character
+  QChar leadCharacter() const;
+
   QString pattern() const;
 
 private:
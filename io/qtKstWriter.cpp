@@ -0,0 +1,356 @@
+// This file is part of qtExtensions, and is distributed under the
+// OSI-approved BSD 3-Clause License. See top-level LICENSE file or
+// https://github.com/Kitware/qtExtensions/blob/master/LICENSE for details.
+
+#include "qtKstWriter.h"
+
+#include "qtKstReader.h"
+
+#include <QIODevice>
+#include <QLocale>
+
+#include <cmath>
+
+QTE_IMPLEMENT_D_FUNC(qtKstWriter)
+
+namespace // anonymous
+{
+
+// Number of bytes to accumulate before writing to the device
+const int bufferSize = 64 * 1024;
+
+// Largest magnitude below which every integer is exactly representable as a
+// double
+const double maxExactInteger = 9007199254740992.0; // 2^53
+
+} // namespace <anonymous>
+
+//-----------------------------------------------------------------------------
+class qtKstWriterPrivate
+{
+public:
+  qtKstWriterPrivate(QIODevice* device,
+                     const QString& separator, const QString& terminator);
+
+  void beginValue();
+  void appendLong(qint64 value);
+  void appendReal(double value);
+  void appendString(const QString& value);
+  bool flushIfFull();
+  bool flush();
+
+  template <typename Container, typename T>
+  void writeArray(const Container& values,
+                  void (qtKstWriterPrivate::*append)(T));
+
+  QIODevice* const device;
+  bool valid;
+
+  QByteArray separator;
+  QByteArray terminator;
+
+  QByteArray buffer;
+  int depth;
+  bool needSeparator;
+};
+
+//-----------------------------------------------------------------------------
+qtKstWriterPrivate::qtKstWriterPrivate(
+  QIODevice* device, const QString& separator, const QString& terminator)
+  : device(device), valid(device && device->isWritable()),
+    separator(separator.toUtf8()), terminator(terminator.toUtf8()),
+    depth(0), needSeparator(false)
+{
+  // Pad separators for readability, unless they are already whitespace
+  if (!separator.isEmpty() && !separator.at(separator.length() - 1).isSpace())
+    {
+    this->separator += ' ';
+    }
+  if (!terminator.endsWith('\n'))
+    {
+    this->terminator += '\n';
+    }
+
+  this->buffer.reserve(bufferSize);
+}
+
+//-----------------------------------------------------------------------------
+void qtKstWriterPrivate::beginValue()
+{
+  if (this->needSeparator)
+    {
+    this->buffer.append(this->separator);
+    }
+  this->needSeparator = true;
+}
+
+//-----------------------------------------------------------------------------
+void qtKstWriterPrivate::appendLong(qint64 value)
+{
+  // Format digits in reverse into a local buffer; the magnitude is computed as
+  // unsigned so that the most negative value does not overflow
+  char digits[24];
+  char* p = digits + sizeof(digits);
+  quint64 n = (value < 0 ? 0 - static_cast<quint64>(value)
+                         : static_cast<quint64>(value));
+  do
+    {
+    *(--p) = static_cast<char>('0' + (n % 10));
+    n /= 10;
+    }
+  while (n);
+
+  if (value < 0)
+    {
+    *(--p) = '-';
+    }
+
+  this->buffer.append(p, static_cast<int>(digits + sizeof(digits) - p));
+}
+
+//-----------------------------------------------------------------------------
+void qtKstWriterPrivate::appendReal(double value)
+{
+  if (!qIsFinite(value))
+    {
+    // KST has no literal for infinity, but an exponent that is out of range
+    // is parsed as such; NaN is written as an empty value, which the reader
+    // does not accept as a number
+    if (qIsInf(value))
+      {
+      this->buffer.append(value < 0.0 ? "-1e999" : "1e999");
+      }
+    return;
+    }
+
+  // Integral values (other than negative zero) are written exactly without
+  // going through the general formatting
+  if (std::fabs(value) < maxExactInteger && value == std::trunc(value) &&
+      !(value == 0.0 && std::signbit(value)))
+    {
+    this->appendLong(static_cast<qint64>(value));
+    return;
+    }
+
+  // Otherwise, use the shortest representation that parses back to the same
+  // value
+  this->buffer.append(
+    QByteArray::number(value, 'g', QLocale::FloatingPointShortest));
+}
+
+//-----------------------------------------------------------------------------
+void qtKstWriterPrivate::appendString(const QString& value)
+{
+  // Encode directly into the buffer, escaping the characters that are special
+  // within a KST string
+  const QChar* p = value.constData();
+  const QChar* const end = p + value.length();
+
+  this->buffer.append('"');
+  while (p < end)
+    {
+    uint c = (p++)->unicode();
+    if (c < 0x80)
+      {
+      if (c == '"' || c == '\\')
+        {
+        this->buffer.append('\\');
+        }
+      this->buffer.append(static_cast<char>(c));
+      continue;
+      }
+
+    // Combine surrogate pairs; an unpaired surrogate is replaced
+    if (QChar::isHighSurrogate(c) && p < end && p->isLowSurrogate())
+      {
+      c = QChar::surrogateToUcs4(static_cast<ushort>(c), (p++)->unicode());
+      }
+    else if (QChar::isSurrogate(c))
+      {
+      c = QChar::ReplacementCharacter;
+      }
+
+    // Write lead byte, then continuation bytes
+    const int n = (c < 0x800 ? 1 : c < 0x10000 ? 2 : 3);
+    static const uchar leads[] = { 0x00, 0xc0, 0xe0, 0xf0 };
+    this->buffer.append(static_cast<char>(leads[n] | (c >> (6 * n))));
+    for (int k = n - 1; k >= 0; --k)
+      {
+      this->buffer.append(static_cast<char>(0x80 | ((c >> (6 * k)) & 0x3f)));
+      }
+    }
+  this->buffer.append('"');
+}
+
+//-----------------------------------------------------------------------------
+template <typename Container, typename T>
+void qtKstWriterPrivate::writeArray(
+  const Container& values, void (qtKstWriterPrivate::*append)(T))
+{
+  this->beginValue();
+  this->buffer.append('[');
+
+  bool first = true;
+  foreach (auto const value, values)
+    {
+    if (!first)
+      {
+      this->buffer.append(this->separator);
+      }
+    (this->*append)(value);
+    first = false;
+    }
+
+  this->buffer.append(']');
+  this->flushIfFull();
+}
+
+//-----------------------------------------------------------------------------
+bool qtKstWriterPrivate::flushIfFull()
+{
+  return (this->buffer.size() < bufferSize) || this->flush();
+}
+
+//-----------------------------------------------------------------------------
+bool qtKstWriterPrivate::flush()
+{
+  if (this->buffer.isEmpty())
+    {
+    return this->valid;
+    }
+
+  if (this->valid)
+    {
+    const qint64 n = this->device->write(this->buffer);
+    this->valid = (n == this->buffer.size());
+    }
+
+  // Keep the allocation for reuse
+  this->buffer.resize(0);
+  return this->valid;
+}
+
+//-----------------------------------------------------------------------------
+qtKstWriter::qtKstWriter(
+  QIODevice* device, const QString& separator, const QString& terminator)
+  : d_ptr(new qtKstWriterPrivate(device, separator, terminator))
+{
+}
+
+//-----------------------------------------------------------------------------
+qtKstWriter::~qtKstWriter()
+{
+  this->flush();
+}
+
+//-----------------------------------------------------------------------------
+QString qtKstWriter::defaultSeparator()
+{
+  return qtKstReader::defaultSeparator().pattern();
+}
+
+//-----------------------------------------------------------------------------
+QString qtKstWriter::defaultTerminator()
+{
+  return qtKstReader::defaultTerminator().pattern();
+}
+
+//-----------------------------------------------------------------------------
+bool qtKstWriter::isValid() const
+{
+  QTE_D_CONST(qtKstWriter);
+  return d->valid;
+}
+
+//-----------------------------------------------------------------------------
+void qtKstWriter::writeInt(int value)
+{
+  this->writeLong(value);
+}
+
+//-----------------------------------------------------------------------------
+void qtKstWriter::writeLong(qint64 value)
+{
+  QTE_D(qtKstWriter);
+  d->beginValue();
+  d->appendLong(value);
+  d->flushIfFull();
+}
+
+//-----------------------------------------------------------------------------
+void qtKstWriter::writeReal(double value)
+{
+  QTE_D(qtKstWriter);
+  d->beginValue();
+  d->appendReal(value);
+  d->flushIfFull();
+}
+
+//-----------------------------------------------------------------------------
+void qtKstWriter::writeString(const QString& value)
+{
+  QTE_D(qtKstWriter);
+  d->beginValue();
+  d->appendString(value);
+  d->flushIfFull();
+}
+
+//-----------------------------------------------------------------------------
+#define WRITE_TYPE_ARRAY(_name, _type, _append) \
+  void qtKstWriter::write##_name##Array(const QList<_type>& values) \
+  { \
+    QTE_D(qtKstWriter); \
+    d->writeArray(values, &qtKstWriterPrivate::_append); \
+  } \
+  void qtKstWriter::write##_name##Array(const QVector<_type>& values) \
+  { \
+    QTE_D(qtKstWriter); \
+    d->writeArray(values, &qtKstWriterPrivate::_append); \
+  }
+
+WRITE_TYPE_ARRAY(Int, int, appendLong)
+WRITE_TYPE_ARRAY(Long, qint64, appendLong)
+WRITE_TYPE_ARRAY(Real, double, appendReal)
+
+//-----------------------------------------------------------------------------
+void qtKstWriter::beginArray()
+{
+  QTE_D(qtKstWriter);
+  d->beginValue();
+  d->buffer.append('[');
+  d->needSeparator = false;
+  ++d->depth;
+}
+
+//-----------------------------------------------------------------------------
+void qtKstWriter::endArray()
+{
+  QTE_D(qtKstWriter);
+  if (d->depth > 0)
+    {
+    d->buffer.append(']');
+    d->needSeparator = true;
+    --d->depth;
+    }
+}
+
+//-----------------------------------------------------------------------------
+void qtKstWriter::endRecord()
+{
+  QTE_D(qtKstWriter);
+  while (d->depth > 0)
+    {
+    d->buffer.append(']');
+    --d->depth;
+    }
+  d->buffer.append(d->terminator);
+  d->needSeparator = false;
+  d->flushIfFull();
+}
+
+//-----------------------------------------------------------------------------
+bool qtKstWriter::flush()
+{
+  QTE_D(qtKstWriter);
+  return d->flush();
+}
@@ -0,0 +1,61 @@
+// This file is part of qtExtensions, and is distributed under the
+// OSI-approved BSD 3-Clause License. See top-level LICENSE file or
+// https://github.com/Kitware/qtExtensions/blob/master/LICENSE for details.
+
+#ifndef __qtKstWriter_h
+#define __qtKstWriter_h
+
+#include "../core/qtGlobal.h"
+
+#include <QList>
+#include <QScopedPointer>
+#include <QString>
+#include <QVector>
+
+class QIODevice;
+
+class qtKstWriterPrivate;
+
+class QTE_EXPORT qtKstWriter
+{
+public:
+  // Output is buffered, and written to the device when the buffer fills, when
+  // flush() is called, or when the writer is destroyed
+  explicit qtKstWriter(QIODevice* device,
+                       const QString& separator = defaultSeparator(),
+                       const QString& terminator = defaultTerminator());
+  ~qtKstWriter();
+
+  // Literal forms of qtKstReader::defaultSeparator() and defaultTerminator()
+  static QString defaultSeparator();
+  static QString defaultTerminator();
+
+  bool isValid() const;
+
+  void writeInt(int value);
+  void writeLong(qint64 value);
+  void writeReal(double value);
+  void writeString(const QString& value);
+  void writeIntArray(const QList<int>& values);
+  void writeLongArray(const QList<qint64>& values);
+  void writeRealArray(const QList<double>& values);
+  void writeIntArray(const QVector<int>& values);
+  void writeLongArray(const QVector<qint64>& values);
+  void writeRealArray(const QVector<double>& values);
+
+  // Write an array value; arrays may be nested (e.g. to write a table), and
+  // any arrays still open at the end of a record are closed automatically
+  void beginArray();
+  void endArray();
+
+  void endRecord();
+
+  bool flush();
+
+private:
+  QTE_DECLARE_PRIVATE(qtKstWriter)
+  QTE_DECLARE_PRIVATE_RPTR(qtKstWriter)
+  QTE_DISABLE_COPY(qtKstWriter)
+};
+
+#endif
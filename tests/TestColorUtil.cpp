@@ -0,0 +1,363 @@
+// This file is part of qtExtensions, and is distributed under the
+// OSI-approved BSD 3-Clause License. See top-level LICENSE file or
+// https://github.com/Kitware/qtExtensions/blob/master/LICENSE for details.
+
+#define TEST_OBJECT_NAME t_obj
+
+#include "../core/qtTest.h"
+
+#include "../util/qtColorUtil.h"
+
+#include <QColor>
+#include <QVector>
+
+#include <cmath>
+
+using qtColorUtil::ColorArray;
+
+const QColor::Spec specs[] = {
+  QColor::Rgb, QColor::Hsv, QColor::Hsl, QColor::Cmyk
+};
+
+//-----------------------------------------------------------------------------
+QVector<QColor> testColors()
+{
+  // Every combination of a few channel levels, which includes black, white
+  // and grays, and colors with more than one maximal channel
+  const int levels[] = { 0, 51, 128, 200, 255 };
+  QVector<QColor> colors;
+  for (auto const r : levels)
+    {
+    for (auto const g : levels)
+      {
+      for (auto const b : levels)
+        {
+        const int a = levels[(colors.count() / 3) % 5];
+        colors.append(QColor(r, g, b, a));
+        }
+      }
+    }
+  return colors;
+}
+
+//-----------------------------------------------------------------------------
+// Test if a color is black; QColor's CMYK components of black differ between
+// Qt versions, so they are not compared
+bool isBlack(const QColor& color)
+{
+  return (color.rgb() & RGB_MASK) == 0;
+}
+
+//-----------------------------------------------------------------------------
+// Test if two colors are equal to within the error of converting to 8 bits
+bool isClose(QRgb actual, QRgb expected)
+{
+  return std::abs(qRed(actual) - qRed(expected)) <= 1 &&
+         std::abs(qGreen(actual) - qGreen(expected)) <= 1 &&
+         std::abs(qBlue(actual) - qBlue(expected)) <= 1 &&
+         std::abs(qAlpha(actual) - qAlpha(expected)) <= 1;
+}
+
+//-----------------------------------------------------------------------------
+// Get the components of a color in a color space, in the order of a color
+// array's channels, followed by alpha
+void components(const QColor& color, QColor::Spec spec, qreal (&out)[5])
+{
+  const QColor c = color.convertTo(spec);
+  out[3] = 0.0;
+  switch (spec)
+    {
+    case QColor::Hsv:
+      out[0] = c.hsvHueF();
+      out[1] = c.hsvSaturationF();
+      out[2] = c.valueF();
+      break;
+    case QColor::Hsl:
+      out[0] = c.hslHueF();
+      out[1] = c.hslSaturationF();
+      out[2] = c.lightnessF();
+      break;
+    case QColor::Cmyk:
+      out[0] = c.cyanF();
+      out[1] = c.magentaF();
+      out[2] = c.yellowF();
+      out[3] = c.blackF();
+      break;
+    default: // RGB
+      out[0] = c.redF();
+      out[1] = c.greenF();
+      out[2] = c.blueF();
+      break;
+    }
+  out[4] = c.alphaF();
+}
+
+//-----------------------------------------------------------------------------
+void components(const ColorArray& colors, int i, qreal (&out)[5])
+{
+  for (int k = 0; k < 4; ++k)
+    {
+    const QVector<float>& channel = colors.channels[k];
+    out[k] = (i < channel.count() ? static_cast<qreal>(channel[i]) : 0.0);
+    }
+  out[4] = colors.alpha[i];
+}
+
+//-----------------------------------------------------------------------------
+// Compare a color in an array to the components of a color in the array's
+// color space, allowing for the precision of QColor's components
+int compareColor(qtTest& t_obj, const ColorArray& colors, int i,
+                 const QColor& expected)
+{
+  qreal actual[5], reference[5];
+  components(colors, i, actual);
+  components(expected, colors.spec, reference);
+
+  for (int k = 0; k < 5; ++k)
+    {
+    if (TEST(std::fabs(actual[k] - reference[k]) <= 2e-3))
+      {
+      t_obj.out() << "  component " << k << " of color " << i << " is "
+                  << actual[k] << " (expected " << reference[k] << ")\n";
+      return 1;
+      }
+    }
+
+  return 0;
+}
+
+//-----------------------------------------------------------------------------
+int testConversion(qtTest& t_obj)
+{
+  const QVector<QColor> colors = testColors();
+  const int count = colors.count();
+
+  QVector<QRgb> rgb(count);
+  for (int i = 0; i < count; ++i)
+    {
+    rgb[i] = colors[i].rgba();
+    }
+
+  for (auto const spec : specs)
+    {
+    // Converting to arrays matches QColor's conversion, from either colors
+    // or packed values
+    ColorArray fromColors(spec), fromRgb(spec);
+    qtColorUtil::convert(colors.constData(), count, fromColors);
+    qtColorUtil::convert(rgb.constData(), count, fromRgb);
+    if (TEST_EQUAL(fromColors.count(), count) ||
+        TEST_EQUAL(fromRgb.count(), count))
+      {
+      return 1;
+      }
+
+    for (int i = 0; i < count; ++i)
+      {
+      if (spec == QColor::Cmyk && isBlack(colors[i]))
+        continue;
+
+      if (compareColor(t_obj, fromColors, i, colors[i]) ||
+          compareColor(t_obj, fromRgb, i, colors[i]))
+        {
+        t_obj.out() << "  converting to color space " << spec << '\n';
+        return 1;
+        }
+      }
+
+    // Converting between arrays matches converting directly
+    for (auto const other : specs)
+      {
+      ColorArray converted(other);
+      qtColorUtil::convert(fromColors, converted);
+      if (TEST_EQUAL(converted.count(), count))
+        return 1;
+
+      for (int i = 0; i < count; ++i)
+        {
+        if (other == QColor::Cmyk && isBlack(colors[i]))
+          continue;
+
+        if (compareColor(t_obj, converted, i, colors[i]))
+          {
+          t_obj.out() << "  converting from color space " << spec
+                      << " to color space " << other << '\n';
+          return 1;
+          }
+        }
+      }
+
+    // Converting back gives the original colors, in the array's color space
+    QVector<QColor> outColors(count);
+    QVector<QRgb> outRgb(count);
+    qtColorUtil::convert(fromColors, outColors.data());
+    qtColorUtil::convert(fromColors, outRgb.data());
+    for (int i = 0; i < count; ++i)
+      {
+      if (TEST_EQUAL(outColors[i].spec(), spec) ||
+          TEST(isClose(outColors[i].rgba(), rgb[i])) ||
+          TEST(isClose(outRgb[i], rgb[i])))
+        {
+        t_obj.out() << "  converting color " << i << " from color space "
+                    << spec << '\n';
+        return 1;
+        }
+      }
+    }
+
+  return 0;
+}
+
+//-----------------------------------------------------------------------------
+int testBlend(qtTest& t_obj)
+{
+  const QVector<QColor> colors = testColors();
+  const int count = colors.count();
+
+  // Blend each color with others, at varying positions
+  QVector<QColor> c0(count), c1(count), c2(count), c3(count);
+  QVector<float> t(count);
+  for (int i = 0; i < count; ++i)
+    {
+    c0[i] = colors[((7 * i) + 3) % count];
+    c1[i] = colors[i];
+    c2[i] = colors[((11 * i) + 5) % count];
+    c3[i] = colors[((13 * i) + 1) % count];
+    t[i] = static_cast<float>(i % 11) / 10.0f;
+    }
+
+  for (auto const spec : specs)
+    {
+    ColorArray a0(spec), a1(spec), a2(spec), a3(spec);
+    qtColorUtil::convert(c0.constData(), count, a0);
+    qtColorUtil::convert(c1.constData(), count, a1);
+    qtColorUtil::convert(c2.constData(), count, a2);
+    qtColorUtil::convert(c3.constData(), count, a3);
+
+    ColorArray linear, cubic;
+    if (TEST(qtColorUtil::blend(a1, a2, t.constData(), linear)) ||
+        TEST(qtColorUtil::blend(a0, a1, a2, a3, t.constData(), cubic)) ||
+        TEST_EQUAL(linear.count(), count) || TEST_EQUAL(cubic.count(), count))
+      {
+      return 1;
+      }
+
+    // Array blends match the scalar blends
+    for (int i = 0; i < count; ++i)
+      {
+      if (spec == QColor::Cmyk &&
+          (isBlack(c0[i]) || isBlack(c1[i]) ||
+           isBlack(c2[i]) || isBlack(c3[i])))
+        {
+        continue;
+        }
+
+      const QColor expectedLinear =
+        qtColorUtil::blend(c1[i], c2[i], t[i], spec);
+      const QColor expectedCubic =
+        qtColorUtil::blend(c0[i], c1[i], c2[i], c3[i], t[i], spec);
+      if (TEST(expectedLinear.isValid()) || TEST(expectedCubic.isValid()) ||
+          compareColor(t_obj, linear, i, expectedLinear) ||
+          compareColor(t_obj, cubic, i, expectedCubic))
+        {
+        t_obj.out() << "  blending in color space " << spec << '\n';
+        return 1;
+        }
+      }
+    }
+
+  return 0;
+}
+
+//-----------------------------------------------------------------------------
+int testAchromatic(qtTest& t_obj)
+{
+  const QColor red = Qt::red, gray = Qt::gray;
+  const QColor black = Qt::black, white = Qt::white;
+
+  for (auto const spec : { QColor::Hsv, QColor::Hsl })
+    {
+    qreal c[5];
+
+    // Blending with a gray keeps the hue of the other color...
+    const QColor pink = qtColorUtil::blend(gray, red, 0.25, spec);
+    components(pink, spec, c);
+    TEST(pink.isValid());
+    TEST_EQUAL(c[0], 0.0);
+
+    const QColor cubicPink =
+      qtColorUtil::blend(black, gray, red, white, 0.5, spec);
+    components(cubicPink, spec, c);
+    TEST(cubicPink.isValid());
+    TEST_EQUAL(c[0], 0.0);
+
+    // ...while blending grays gives a gray
+    const QColor mid = qtColorUtil::blend(black, white, 0.5, spec);
+    components(mid, spec, c);
+    TEST(mid.isValid());
+    TEST_EQUAL(c[0], -1.0);
+    TEST(isClose(mid.rgba(), qRgb(128, 128, 128)) ||
+         isClose(mid.rgba(), qRgb(127, 127, 127)));
+
+    // Array blends do the same
+    const QColor from[] = { gray, black };
+    const QColor to[] = { red, white };
+    const float t[] = { 0.25f, 0.5f };
+
+    ColorArray a(spec), b(spec), out;
+    qtColorUtil::convert(from, 2, a);
+    qtColorUtil::convert(to, 2, b);
+    if (TEST(qtColorUtil::blend(a, b, t, out)))
+      return 1;
+    TEST_EQUAL(out.channels[0][0], 0.0f);
+    TEST_EQUAL(out.channels[0][1], -1.0f);
+    TEST_CALL(compareColor, out, 0, pink);
+    TEST_CALL(compareColor, out, 1, mid);
+    }
+
+  return 0;
+}
+
+//-----------------------------------------------------------------------------
+int testMismatch(qtTest& t_obj)
+{
+  const float t[] = { 0.0f, 0.25f, 0.5f, 1.0f };
+  const ColorArray rgb(QColor::Rgb, 4), hsv(QColor::Hsv, 4);
+  const ColorArray shorter(QColor::Rgb, 3);
+  ColorArray out(QColor::Rgb, 2);
+
+  // Arrays must have the same color space and count
+  TEST(!qtColorUtil::blend(rgb, hsv, t, out));
+  TEST_EQUAL(out.count(), 0);
+  TEST(!qtColorUtil::blend(rgb, shorter, t, out));
+  TEST(!qtColorUtil::blend(shorter, rgb, t, out));
+  TEST(!qtColorUtil::blend(rgb, rgb, rgb, hsv, t, out));
+  TEST(!qtColorUtil::blend(rgb, rgb, shorter, rgb, t, out));
+  TEST_EQUAL(out.count(), 0);
+
+  // ...and channels that match their color space
+  ColorArray relabeled(QColor::Rgb, 4);
+  relabeled.spec = QColor::Cmyk;
+  const ColorArray cmyk(QColor::Cmyk, 4);
+  TEST(!qtColorUtil::blend(cmyk, relabeled, t, out));
+  TEST(!qtColorUtil::blend(relabeled, relabeled, t, out));
+
+  TEST(qtColorUtil::blend(rgb, rgb, t, out));
+  TEST_EQUAL(out.count(), 4);
+  TEST(qtColorUtil::blend(cmyk, cmyk, cmyk, cmyk, t, out));
+  TEST_EQUAL(out.count(), 4);
+  TEST_EQUAL(out.channels[3].count(), 4);
+
+  return 0;
+}
+
+//-----------------------------------------------------------------------------
+int main()
+{
+  qtTest t_obj;
+
+  t_obj.runSuite("Conversion", testConversion);
+  t_obj.runSuite("Blending", testBlend);
+  t_obj.runSuite("Achromatic Colors", testAchromatic);
+  t_obj.runSuite("Mismatched Arrays", testMismatch);
+  return t_obj.result();
+}
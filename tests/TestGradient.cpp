@@ -0,0 +1,514 @@
+// This file is part of qtExtensions, and is distributed under the
+// OSI-approved BSD 3-Clause License. See top-level LICENSE file or
+// https://github.com/Kitware/qtExtensions/blob/master/LICENSE for details.
+
+#define TEST_OBJECT_NAME t_obj
+
+#include "../core/qtTest.h"
+
+#include "../util/qtColorUtil.h"
+#include "../util/qtGradient.h"
+
+#include <QColor>
+#include <QImage>
+
+#include <cmath>
+#include <limits>
+
+//-----------------------------------------------------------------------------
+qtGradient testGradient(qtGradient::Spread spread = QGradient::PadSpread)
+{
+  QList<qtGradient::Stop> stops;
+  stops.append(qtGradient::Stop(0.0, QColor(255, 0, 0, 0)));
+  stops.append(qtGradient::Stop(0.3, QColor(0, 255, 0, 128), 0.3));
+  stops.append(qtGradient::Stop(1.0, QColor(0, 0, 255)));
+  return qtGradient(stops, qtGradient::InterpolateLinear, spread);
+}
+
+//-----------------------------------------------------------------------------
+// Test if two colors are equal to within the error of sampling a table
+bool isClose(QRgb actual, QRgb expected, int tolerance = 2)
+{
+  return std::abs(qRed(actual) - qRed(expected)) <= tolerance &&
+         std::abs(qGreen(actual) - qGreen(expected)) <= tolerance &&
+         std::abs(qBlue(actual) - qBlue(expected)) <= tolerance &&
+         std::abs(qAlpha(actual) - qAlpha(expected)) <= tolerance;
+}
+
+//-----------------------------------------------------------------------------
+// Test if a color is the composite of a color over an opaque background
+bool isComposite(QRgb actual, QRgb fg, QRgb bg)
+{
+  const qreal a = qAlpha(fg) / 255.0;
+  const auto channel = [a](int f, int b) {
+    return qRound((f * a) + (b * (1.0 - a)));
+  };
+  const QRgb expected = qRgb(channel(qRed(fg), qRed(bg)),
+                             channel(qGreen(fg), qGreen(bg)),
+                             channel(qBlue(fg), qBlue(bg)));
+  return isClose(actual, expected, 1);
+}
+
+//-----------------------------------------------------------------------------
+QRgb pixel(const QImage& image, int x, int y)
+{
+  return reinterpret_cast<const QRgb*>(image.constScanLine(y))[x];
+}
+
+//-----------------------------------------------------------------------------
+int testStops(qtTest& t_obj)
+{
+  const QColor red = Qt::red, green = Qt::green, blue = Qt::blue;
+  const QColor transparent = Qt::transparent;
+  const qtGradient::NormalizeMode modes[] = {
+    qtGradient::NormalizeStops, qtGradient::PadStops
+  };
+
+  // Without stops, the gradient is transparent
+  QList<qtGradient::Stop> stops;
+  qtGradient gradient(stops);
+  TEST(gradient.stops().isEmpty());
+  TEST_EQUAL(gradient.at(0.0), transparent);
+  TEST_EQUAL(gradient.at(0.5), transparent);
+  TEST_EQUAL(gradient.bake(4).data()[3], transparent.rgba());
+
+  // A single stop is moved to the start, and colors the whole gradient
+  stops.append(qtGradient::Stop(0.7, red, 1.5));
+  for (auto const nm : modes)
+    {
+    gradient.setStops(stops, nm);
+    const auto single = gradient.stops();
+    if (TEST_EQUAL(single.count(), 1))
+      return 1;
+    TEST_EQUAL(single.firstKey(), 0.0);
+    TEST_EQUAL(single.first().position, 0.0);
+    TEST_EQUAL(single.first().weight, 1.0);
+    TEST_EQUAL(single.first().color, red);
+    TEST_EQUAL(gradient.at(0.0), red);
+    TEST_EQUAL(gradient.at(0.5), red);
+    TEST_EQUAL(gradient.at(1.0), red);
+    }
+
+  // Multiple stops are sorted (later stops replacing earlier ones at the
+  // same position), and scaled to span [0, 1]...
+  stops.clear();
+  stops.append(qtGradient::Stop(6.0, blue));
+  stops.append(qtGradient::Stop(2.0, red));
+  stops.append(qtGradient::Stop(4.0, transparent));
+  stops.append(qtGradient::Stop(4.0, green, -1.0));
+  gradient.setStops(stops);
+
+  const auto normalized = gradient.stops();
+  TEST_EQUAL(normalized.keys(), (QList<qreal>{0.0, 0.5, 1.0}));
+  TEST_EQUAL(normalized.value(0.0).color, red);
+  TEST_EQUAL(normalized.value(0.5).color, green);
+  TEST_EQUAL(normalized.value(0.5).position, 0.5);
+  TEST_EQUAL(normalized.value(0.5).weight, 0.0);
+  TEST_EQUAL(normalized.value(1.0).color, blue);
+  TEST_EQUAL(gradient.at(0.5), green);
+
+  // ...or truncated to [0, 1], and padded to span it
+  stops.clear();
+  stops.append(qtGradient::Stop(-0.5, transparent));
+  stops.append(qtGradient::Stop(0.25, red));
+  stops.append(qtGradient::Stop(0.75, blue));
+  stops.append(qtGradient::Stop(1.5, transparent));
+  gradient.setStops(stops, qtGradient::PadStops);
+
+  const auto padded = gradient.stops();
+  TEST_EQUAL(padded.keys(), (QList<qreal>{0.0, 0.25, 0.75, 1.0}));
+  TEST_EQUAL(padded.value(0.0).position, 0.0);
+  TEST_EQUAL(padded.value(0.0).color, red);
+  TEST_EQUAL(padded.value(1.0).position, 1.0);
+  TEST_EQUAL(padded.value(1.0).color, blue);
+  TEST(isClose(gradient.at(0.1).rgba(), red.rgba()));
+  TEST(isClose(gradient.at(0.9).rgba(), blue.rgba()));
+
+  // Stops can only be inserted in [0, 1]
+  stops.clear();
+  stops.append(qtGradient::Stop(0.0, red));
+  stops.append(qtGradient::Stop(0.5, blue));
+  stops.append(qtGradient::Stop(1.0, blue));
+  gradient.setStops(stops);
+  TEST(!gradient.insertStop(-0.5, red));
+  TEST(!gradient.insertStop(1.5, red));
+  TEST(gradient.insertStop(0.5, green, 2.0));
+  TEST_EQUAL(gradient.stops().count(), 3);
+  TEST_EQUAL(gradient.stops().value(0.5).color, green);
+  TEST_EQUAL(gradient.stops().value(0.5).weight, 1.0);
+
+  // Removing end stops leaves positions beyond the remaining stops with the
+  // color of the nearest stop
+  TEST(!gradient.removeStop(0.3));
+  TEST(gradient.removeStop(0.0));
+  TEST_EQUAL(gradient.at(0.0), green);
+  TEST_EQUAL(gradient.at(0.25), green);
+  TEST_EQUAL(gradient.at(1.0), blue);
+
+  TEST(gradient.removeStop(1.0));
+  TEST_EQUAL(gradient.stops().keys(), QList<qreal>{0.5});
+  TEST_EQUAL(gradient.at(0.0), green);
+  TEST_EQUAL(gradient.at(1.0), green);
+  TEST_EQUAL(gradient.bake(8).data()[0], green.rgba());
+  TEST_EQUAL(gradient.bake(8).data()[7], green.rgba());
+
+  TEST(gradient.removeStop(0.5));
+  TEST(!gradient.removeStop(0.5));
+  TEST(gradient.stops().isEmpty());
+  TEST_EQUAL(gradient.at(0.5), transparent);
+
+  return 0;
+}
+
+//-----------------------------------------------------------------------------
+int testInterpolationMode(qtTest& t_obj, const qtGradient& gradient,
+                          QColor::Spec spec)
+{
+  // The gradient has stops at 0.0, 0.4 (with weight 0.25) and 1.0; the
+  // weights put the midpoints of the segments at 0.2 and 0.55
+  const auto stops = gradient.stops();
+  const QColor c0 = stops.value(0.0).color;
+  const QColor c1 = stops.value(0.4).color;
+  const QColor c2 = stops.value(1.0).color;
+
+  // Stop positions have the exact stop colors
+  TEST_EQUAL(gradient.at(0.0), c0);
+  TEST_EQUAL(gradient.at(0.4), c1);
+  TEST_EQUAL(gradient.at(1.0), c2);
+
+  const int function =
+    gradient.interpolationMode() & qtGradient::InterpolateFunctionMask;
+  if (function == qtGradient::InterpolateDiscrete)
+    {
+    // Discrete interpolation switches colors at the midpoints
+    TEST_EQUAL(gradient.at(0.1), c0);
+    TEST_EQUAL(gradient.at(0.3), c1);
+    TEST_EQUAL(gradient.at(0.5), c1);
+    TEST_EQUAL(gradient.at(0.7), c2);
+    }
+  else
+    {
+    // Linear and cubic interpolation give the mean of the stop colors at the
+    // midpoints
+    const QRgb mid01 = qtColorUtil::blend(c0, c1, 0.5, spec).rgba();
+    const QRgb mid12 = qtColorUtil::blend(c1, c2, 0.5, spec).rgba();
+    TEST(isClose(gradient.at(0.2).rgba(), mid01));
+    TEST(isClose(gradient.at(0.55).rgba(), mid12));
+
+    if (function == qtGradient::InterpolateLinear)
+      {
+      // Halfway to the midpoint is a quarter of the way between the stops
+      const QRgb quarter = qtColorUtil::blend(c0, c1, 0.25, spec).rgba();
+      TEST(isClose(gradient.at(0.1).rgba(), quarter));
+      }
+    }
+
+  // Baked tables match sampling the gradient
+  const int entries = 65;
+  const qtGradientLut lut = gradient.bake(entries);
+  for (int i = 0; i < entries; ++i)
+    {
+    const qreal pos = i / (entries - 1.0);
+    if (TEST_EQUAL(lut.data()[i], gradient.at(pos).rgba()))
+      {
+      t_obj.out() << "  at entry " << i << '\n';
+      return 1;
+      }
+    }
+
+  return 0;
+}
+
+//-----------------------------------------------------------------------------
+int testInterpolation(qtTest& t_obj)
+{
+  QList<qtGradient::Stop> stops;
+  stops.append(qtGradient::Stop(0.0, Qt::red));
+  stops.append(qtGradient::Stop(0.4, QColor(0, 255, 0, 128), 0.25));
+  stops.append(qtGradient::Stop(1.0, Qt::blue));
+  qtGradient gradient(stops);
+
+  const qtGradient::InterpolationFlag functions[] = {
+    qtGradient::InterpolateDiscrete,
+    qtGradient::InterpolateLinear,
+    qtGradient::InterpolateCubic
+  };
+
+  struct Space
+  {
+    qtGradient::InterpolationFlag flag;
+    QColor::Spec spec;
+  };
+  const Space spaces[] = {
+    { qtGradient::InterpolateRgb, QColor::Rgb },
+    { qtGradient::InterpolateHsv, QColor::Hsv },
+    { qtGradient::InterpolateHsl, QColor::Hsl },
+    { qtGradient::InterpolateCmyk, QColor::Cmyk }
+  };
+
+  for (auto const function : functions)
+    {
+    for (auto const& space : spaces)
+      {
+      gradient.setInterpolationMode(function | space.flag);
+      if (testInterpolationMode(t_obj, gradient, space.spec))
+        {
+        t_obj.out() << "  with interpolation mode "
+                    << static_cast<int>(gradient.interpolationMode()) << '\n';
+        return 1;
+        }
+      }
+    }
+
+  return 0;
+}
+
+//-----------------------------------------------------------------------------
+int testLut(qtTest& t_obj)
+{
+  const qtGradient gradient = testGradient();
+
+  // Entries sample the gradient evenly over the normalized range
+  const int entries = 33;
+  const qtGradientLut lut = gradient.bake(entries, true);
+  TEST_EQUAL(lut.size(), entries);
+  TEST(lut.floatData());
+
+  for (int i = 0; i < entries; ++i)
+    {
+    const qreal pos = i / (entries - 1.0);
+    const QColor expected = gradient.at(pos);
+    const float* const f = lut.sampleF(pos);
+    if (TEST_EQUAL(lut.data()[i], expected.rgba()) ||
+        TEST_EQUAL(lut.sample(pos), expected.rgba()) || TEST(f))
+      {
+      t_obj.out() << "  at entry " << i << '\n';
+      return 1;
+      }
+    TEST_EQUAL(f[0], static_cast<float>(expected.redF()));
+    TEST_EQUAL(f[1], static_cast<float>(expected.greenF()));
+    TEST_EQUAL(f[2], static_cast<float>(expected.blueF()));
+    TEST_EQUAL(f[3], static_cast<float>(expected.alphaF()));
+    }
+
+  // Positions outside the normalized range are padded
+  const qreal nan = std::numeric_limits<qreal>::quiet_NaN();
+  TEST_EQUAL(lut.spread(), QGradient::PadSpread);
+  TEST_EQUAL(lut.sample(-0.5), lut.data()[0]);
+  TEST_EQUAL(lut.sample(1.5), lut.data()[entries - 1]);
+  TEST_EQUAL(lut.sample(nan), lut.data()[0]);
+
+  // ...or follow the gradient's spread
+  const qtGradient repeat = testGradient(QGradient::RepeatSpread);
+  const qtGradientLut repeatLut = repeat.bake(entries);
+  TEST_EQUAL(repeatLut.spread(), QGradient::RepeatSpread);
+  TEST_EQUAL(repeatLut.sample(1.25), repeat.at(1.25).rgba());
+  TEST_EQUAL(repeatLut.sample(-0.25), repeat.at(-0.25).rgba());
+  TEST_EQUAL(repeatLut.sample(-0.25), repeatLut.sample(0.75));
+
+  const qtGradient reflect = testGradient(QGradient::ReflectSpread);
+  const qtGradientLut reflectLut = reflect.bake(entries);
+  TEST_EQUAL(reflectLut.sample(1.25), reflect.at(1.25).rgba());
+  TEST_EQUAL(reflectLut.sample(1.25), reflectLut.sample(0.75));
+  TEST_EQUAL(reflectLut.sample(-0.25), reflectLut.sample(0.25));
+
+  // Floating point colors are only available if requested
+  const qtGradientLut rgbLut = gradient.bake(entries);
+  TEST(!rgbLut.floatData());
+  TEST(!rgbLut.sampleF(0.5));
+
+  // Tables have at least two entries
+  TEST_EQUAL(gradient.bake(0).size(), 2);
+
+  // Empty tables have no colors
+  const qtGradientLut empty;
+  TEST(empty.isEmpty());
+  TEST(!empty.floatData());
+  TEST(!empty.sampleF(0.5));
+
+  return 0;
+}
+
+//-----------------------------------------------------------------------------
+template <typename T>
+int testMapValues(qtTest& t_obj, qtGradient::Spread spread)
+{
+  const qtGradient gradient = testGradient(spread);
+  const qtGradientLut lut = gradient.bake(1024);
+
+  // Values span (and exceed) the mapped range, and include NaN
+  const int count = 1000;
+  const qreal lo = -5.0, hi = 15.0;
+  const QRgb nanColor = qRgba(1, 2, 3, 4);
+
+  QVector<T> values(count);
+  for (int i = 0; i < count; ++i)
+    {
+    values[i] = static_cast<T>(lo + ((hi - lo) * ((i - 100.37) / 800.0)));
+    }
+  values[0] = values[500] = std::numeric_limits<T>::quiet_NaN();
+
+  QVector<QRgb> colors(count), lutColors(count);
+  gradient.map(values.constData(), count, lo, hi, colors.data(), nanColor);
+  lut.map(values.constData(), count, lo, hi, lutColors.data(), nanColor);
+
+  const qreal k = 1.0 / (hi - lo);
+  for (int i = 0; i < count; ++i)
+    {
+    const qreal v = static_cast<qreal>(values[i]);
+    const QRgb expected =
+      (std::isnan(v) ? nanColor : gradient.at((v - lo) * k).rgba());
+    if (TEST(isClose(colors[i], expected)) ||
+        TEST(isClose(lutColors[i], expected)))
+      {
+      t_obj.out() << "  mapping value " << i << " (" << v << ")\n";
+      return 1;
+      }
+    }
+
+  // Mapping into images converts to the image format
+  QImage image(count / 2, 2, QImage::Format_ARGB32_Premultiplied);
+  TEST(lut.map(values.constData(), count, lo, hi, image, 1, nanColor));
+  for (int i = 0; i < image.width(); ++i)
+    {
+    if (TEST_EQUAL(pixel(image, i, 1), qPremultiply(lutColors[i])))
+      {
+      return 1;
+      }
+    }
+
+  QImage opaque(count, 1, QImage::Format_RGB32);
+  TEST(lut.map(values.constData(), count, lo, hi, opaque, 0, nanColor));
+  TEST_EQUAL(pixel(opaque, 0, 0), nanColor | 0xff000000u);
+  TEST_EQUAL(pixel(opaque, 1, 0), lutColors[1] | 0xff000000u);
+
+  // Unsupported formats and lines outside the image are rejected
+  QImage indexed(count, 1, QImage::Format_Indexed8);
+  TEST(!lut.map(values.constData(), count, lo, hi, indexed, 0));
+  TEST(!lut.map(values.constData(), count, lo, hi, image, 2));
+
+  // An empty table maps everything to the NaN color
+  lutColors.fill(0);
+  qtGradientLut().map(values.constData(), count, lo, hi,
+                      lutColors.data(), nanColor);
+  TEST_EQUAL(lutColors.count(nanColor), count);
+
+  return 0;
+}
+
+//-----------------------------------------------------------------------------
+int testMap(qtTest& t_obj)
+{
+  return testMapValues<float>(t_obj, QGradient::PadSpread) ||
+         testMapValues<double>(t_obj, QGradient::PadSpread) ||
+         testMapValues<float>(t_obj, QGradient::RepeatSpread) ||
+         testMapValues<double>(t_obj, QGradient::ReflectSpread);
+}
+
+//-----------------------------------------------------------------------------
+int testRenderImage(qtTest& t_obj, Qt::Orientation orientation, QSize size,
+                    int checkerSize,
+                    qtGradient::Spread spread = QGradient::PadSpread)
+{
+  const qtGradient gradient = testGradient(spread);
+  const bool horizontal = (orientation == Qt::Horizontal);
+  const int length = (horizontal ? size.width() : size.height());
+  const QColor checker1 = Qt::white;
+  const QColor checker2 = Qt::darkGray;
+
+  const QImage image =
+    (checkerSize > 0
+     ? gradient.renderImage(size, orientation, checker1, checker2,
+                            checkerSize)
+     : gradient.renderImage(size, orientation));
+  TEST_EQUAL(image.size(), size);
+  TEST_EQUAL(image.format(), QImage::Format_ARGB32_Premultiplied);
+
+  QVector<QRgb> colors(length);
+  for (int i = 0; i < length; ++i)
+    {
+    colors[i] = gradient.at(i / (length - 1.0)).rgba();
+    }
+
+  // Without checkers, pixels are the premultiplied gradient color; with
+  // them, the color is composited over the second checker color where the
+  // parity of the cell's row and column match, and over the first elsewhere
+  for (int y = 0; y < size.height(); ++y)
+    {
+    for (int x = 0; x < size.width(); ++x)
+      {
+      const QRgb color = colors[horizontal ? x : y];
+      const QRgb actual = pixel(image, x, y);
+
+      bool okay;
+      if (checkerSize > 0)
+        {
+        const bool odd = ((x / checkerSize) + (y / checkerSize)) & 1;
+        okay = isComposite(actual, color,
+                           (odd ? checker1 : checker2).rgb());
+        }
+      else
+        {
+        okay = (actual == qPremultiply(color));
+        }
+
+      if (TEST(okay))
+        {
+        t_obj.out() << "  at pixel " << x << ", " << y << '\n';
+        return 1;
+        }
+      }
+    }
+
+  return 0;
+}
+
+//-----------------------------------------------------------------------------
+int testRender(qtTest& t_obj)
+{
+  // Rendering matches the gradient, with or without checkers, and also when
+  // the image is large enough to be rendered in parallel
+  const QSize small(50, 23), large(1100, 1000);
+  if (testRenderImage(t_obj, Qt::Horizontal, small, 0) ||
+      testRenderImage(t_obj, Qt::Vertical, small, 0) ||
+      testRenderImage(t_obj, Qt::Horizontal, small, 4) ||
+      testRenderImage(t_obj, Qt::Vertical, small, 4) ||
+      testRenderImage(t_obj, Qt::Horizontal, large, 0) ||
+      testRenderImage(t_obj, Qt::Vertical, large, 7))
+    {
+    return 1;
+    }
+
+  // Spread applies to the end of the gradient, as in sampling it directly,
+  // so the last pixel of a repeating gradient is the color at the start
+  const qtGradient::Spread repeat = QGradient::RepeatSpread;
+  if (testRenderImage(t_obj, Qt::Horizontal, small, 0, repeat) ||
+      testRenderImage(t_obj, Qt::Vertical, small, 4, repeat))
+    {
+    return 1;
+    }
+
+  const qtGradient repeating = testGradient(repeat);
+  const QImage image = repeating.renderImage(small);
+  TEST_EQUAL(repeating.at(1.0), repeating.at(0.0));
+  TEST_EQUAL(pixel(image, small.width() - 1, 0), pixel(image, 0, 0));
+  TEST_EQUAL(repeating.render(small.width()).last(), repeating.at(1.0));
+
+  // Empty sizes give a null image
+  TEST(testGradient().renderImage(QSize(0, 10)).isNull());
+
+  return 0;
+}
+
+//-----------------------------------------------------------------------------
+int main()
+{
+  qtTest t_obj;
+
+  t_obj.runSuite("Stops", testStops);
+  t_obj.runSuite("Interpolation", testInterpolation);
+  t_obj.runSuite("Lookup Tables", testLut);
+  t_obj.runSuite("Value Mapping", testMap);
+  t_obj.runSuite("Image Rendering", testRender);
+  return t_obj.result();
+}
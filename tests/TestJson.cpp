@@ -0,0 +1,578 @@
+// This file is part of qtExtensions, and is distributed under the
+// OSI-approved BSD 3-Clause License. See top-level LICENSE file or
+// https://github.com/Kitware/qtExtensions/blob/master/LICENSE for details.
+
+#define TEST_OBJECT_NAME t_obj
+
+#include "../core/qtTest.h"
+
+#include "../util/qtJson.h"
+#include "../util/qtRand.h"
+
+#include <QBuffer>
+#include <QElapsedTimer>
+
+#include <cmath>
+#include <limits>
+
+// Size of the chunks in which qtJson::Reader reads a device
+const int readChunkSize = 64 * 1024;
+
+//-----------------------------------------------------------------------------
+double readReal(const qtJson::JsonData& data)
+{
+  qtJson::Reader reader(data);
+  reader.readNext();
+  return reader.number();
+}
+
+//-----------------------------------------------------------------------------
+// Read the single value in a document through a device, positioned so that
+// the first \p split bytes of the value are in the first chunk read
+qtJson::Value readSplit(const QByteArray& json, int split,
+                        qtJson::Reader::TokenType& next)
+{
+  QByteArray data(readChunkSize - split, ' ');
+  data += json;
+  QBuffer device(&data);
+  device.open(QIODevice::ReadOnly);
+
+  qtJson::Reader reader(&device);
+  reader.readNext();
+  const qtJson::Value value = reader.readValue();
+  next = reader.readNext();
+  return value;
+}
+
+//-----------------------------------------------------------------------------
+int testReals(qtTest& t_obj)
+{
+  using qtJson::JsonData;
+  using qtJson::encode;
+
+  const double inf = std::numeric_limits<double>::infinity();
+
+  // Special and integral values
+  TEST_EQUAL(encode(inf), JsonData("null"));
+  TEST_EQUAL(encode(qQNaN()), JsonData("null"));
+  TEST_EQUAL(encode(42.0), JsonData("42"));
+  TEST_EQUAL(encode(-0.0), JsonData("-0"));
+  TEST_EQUAL(encode(QVariant::fromValue(-3.0f)), JsonData("-3"));
+
+  // Shortest representations
+  TEST_EQUAL(encode(0.1), JsonData("0.1"));
+  TEST_EQUAL(encode(1e300), JsonData("1e+300"));
+  TEST_EQUAL(encode(QVariant::fromValue(0.1f)), JsonData("0.1"));
+  TEST_EQUAL(encode(QVariant::fromValue(16777217.0f)), JsonData("16777216"));
+  TEST_EQUAL(encode(-77.03653486), JsonData("-77.03653486"));
+
+  // Legacy format
+  TEST_EQUAL(encode(-77.03653486, qtJson::LegacyReal),
+             JsonData("-77.036535"));
+  TEST_EQUAL(encode(QVariant::fromValue(0.1f), qtJson::LegacyReal),
+             JsonData("0.1"));
+
+  // Random values must read back exactly
+  qsrand(7);
+  for (int i = 0; i < 20000; ++i)
+    {
+    const double scale = std::pow(10.0, qtRand(-30, 30));
+    const double dv = (qtRandD() - 0.5) * scale;
+    const double dr = readReal(encode(dv));
+    if (TEST(dr == dv))
+      {
+      t_obj.out() << "  value " << QByteArray::number(dv, 'g', 17)
+                  << " encoded as " << encode(dv) << '\n';
+      return 1;
+      }
+
+    const float fv = static_cast<float>(dv);
+    const float fr =
+      static_cast<float>(readReal(encode(QVariant::fromValue(fv))));
+    if (TEST(fr == fv))
+      {
+      t_obj.out() << "  value " << QByteArray::number(fv, 'g', 9)
+                  << " encoded as " << encode(QVariant::fromValue(fv))
+                  << '\n';
+      return 1;
+      }
+    }
+
+  return 0;
+}
+
+//-----------------------------------------------------------------------------
+int testWriter(qtTest& t_obj)
+{
+  using qtJson::JsonData;
+
+  // Nesting, and separators between values and after keys
+  JsonData data;
+  qtJson::Writer writer(&data);
+  writer.beginObject();
+  writer.writeKey("a");
+  writer.beginArray();
+  writer.writeInteger(1);
+  writer.writeNull();
+  writer.beginObject();
+  writer.endObject();
+  writer.beginArray();
+  writer.endArray();
+  writer.writeString("x");
+  writer.endArray();
+  writer.writeKey("b");
+  writer.writeBool(true);
+  writer.writeKey("c");
+  writer.beginObject();
+  writer.writeKey("d");
+  writer.writeUnsignedInteger(Q_UINT64_C(18446744073709551615));
+  writer.endObject();
+  writer.endObject();
+  TEST_EQUAL(data, JsonData("{\"a\":[1,null,{},[],\"x\"],\"b\":true,"
+                            "\"c\":{\"d\":18446744073709551615}}"));
+
+  // Consecutive top-level values are separated
+  JsonData values;
+  qtJson::Writer valueWriter(&values);
+  valueWriter.writeInteger(-5);
+  valueWriter.writeEncoded("{}");
+  TEST_EQUAL(values, JsonData("-5,{}"));
+
+  // A device receives output while a long run of scalars is written, rather
+  // than only when the enclosing container is closed
+  const int count = 100000;
+  QByteArray deviceData;
+  QBuffer device(&deviceData);
+  device.open(QIODevice::WriteOnly);
+
+  JsonData expected;
+  qtJson::Writer deviceWriter(&device);
+  qtJson::Writer reference(&expected);
+  deviceWriter.beginArray();
+  reference.beginArray();
+  for (int i = 0; i < count; ++i)
+    {
+    deviceWriter.writeInteger(i);
+    reference.writeInteger(i);
+    }
+  TEST(device.size() > 0);
+  TEST(expected.size() - device.size() <= 64 * 1024);
+
+  deviceWriter.endArray();
+  reference.endArray();
+  TEST(deviceWriter.flush());
+
+  TEST(deviceData.size() > 64 * 1024);
+  TEST(deviceData == expected);
+
+  return 0;
+}
+
+//-----------------------------------------------------------------------------
+int testStrings(qtTest& t_obj)
+{
+  using qtJson::JsonData;
+  using qtJson::encode;
+
+  // Escaped characters
+  TEST_EQUAL(encode(QString("a\"b\\c/d")), JsonData("\"a\\\"b\\\\c/d\""));
+  TEST_EQUAL(encode(QString("1\n2\t3\x01")),
+             JsonData("\"1\\n2\\t3\\u0001\""));
+  TEST_EQUAL(encode(QString("x\x7f")), JsonData("\"x\\u007f\""));
+
+  // Non-ASCII characters, including surrogate pairs, are encoded as UTF-8;
+  // unpaired surrogates are replaced
+  TEST_EQUAL(encode(QString::fromUtf8("caf\xc3\xa9 \xe2\x82\xac")),
+             JsonData("\"caf\xc3\xa9 \xe2\x82\xac\""));
+  TEST_EQUAL(encode(QString::fromUtf8("<\xf0\x9f\x98\x80>")),
+             JsonData("\"<\xf0\x9f\x98\x80>\""));
+  TEST_EQUAL(encode(QString(QChar(0xd800)) + "a"),
+             JsonData("\"\xef\xbf\xbd" "a\""));
+
+  // Non-printable non-ASCII characters are escaped
+  TEST_EQUAL(encode(QString(QChar(0x2028))), JsonData("\"\\u2028\""));
+
+  // Random strings must read back unaltered
+  qsrand(13);
+  for (int i = 0; i < 2000; ++i)
+    {
+    QString text;
+    const int length = qtRand(64);
+    for (int k = 0; k < length; ++k)
+      {
+      switch (qtRand(4))
+        {
+        case 0:
+          text += QChar(qtRand(0x20));
+          break;
+        case 1:
+          text += QChar(qtRand(0x80, 0xd800));
+          break;
+        case 2:
+          text += QString::fromUcs4(QVector<uint>{
+            static_cast<uint>(qtRand(0x10000, 0x20000))}.constData(), 1);
+          break;
+        default:
+          text += QChar(qtRand(0x20, 0x80));
+          break;
+        }
+      }
+
+    qtJson::Reader reader(encode(text));
+    reader.readNext();
+    const QString result = reader.string();
+    if (TEST_EQUAL(result, text))
+      {
+      return 1;
+      }
+    }
+
+  return 0;
+}
+
+//-----------------------------------------------------------------------------
+int testReaderChunks(qtTest& t_obj)
+{
+  using qtJson::Array;
+  using qtJson::Object;
+  using qtJson::Reader;
+  using qtJson::Value;
+
+  const QList<QPair<QByteArray, Value>> cases{
+    {"\"abcdefghij\"", QString("abcdefghij")},
+    {"\"a\\\"b\\u00e9c\\n\"", QString::fromUtf8("a\"b\xc3\xa9" "c\n")},
+    {"\"\\ud83d\\ude00x\"", QString::fromUtf8("\xf0\x9f\x98\x80x")},
+    {"\"\\ud83dx\"", QString(QChar(QChar::ReplacementCharacter)) + "x"},
+    {"-12345678901234", qint64(-12345678901234)},
+    {"6.02214076e23", 6.02214076e23},
+    {"-0.125", -0.125},
+    {"true", true},
+    {"false", false},
+    {"null", Value()},
+    {"[1,[2,{\"k\":\"v\"}],{}]",
+     Array{qint64(1), Array{qint64(2), Object{{"k", QString("v")}}},
+           Object()}},
+  };
+
+  // Every token must read correctly wherever the chunk boundary falls in it,
+  // including immediately before and after it
+  foreach (auto const& c, cases)
+    {
+    for (int split = 0; split <= c.first.size(); ++split)
+      {
+      Reader::TokenType next;
+      const Value value = readSplit(c.first, split, next);
+      if (TEST_EQUAL(value, c.second) ||
+          TEST_EQUAL(next, Reader::EndDocument))
+        {
+        t_obj.out() << "  reading " << c.first.constData()
+                    << " split after " << split << " bytes\n";
+        return 1;
+        }
+      }
+    }
+
+  // Invalid tokens split across the boundary are still reported
+  const QList<QByteArray> invalid{
+    "\"abc", "\"a\\x\"", "\"\\u12g4\"", "01", "1.e5", "-", "tru", "nul"};
+  foreach (auto const& json, invalid)
+    {
+    for (int split = 0; split <= json.size(); ++split)
+      {
+      Reader::TokenType next;
+      const Value value = readSplit(json, split, next);
+      if (TEST(!value.isValid()) || TEST_EQUAL(next, Reader::Invalid))
+        {
+        t_obj.out() << "  reading " << json.constData()
+                    << " split after " << split << " bytes\n";
+        return 1;
+        }
+      }
+    }
+
+  // Large documents are read in full
+  Array items;
+  QByteArray json = "{\"after\":true,\"items\":[";
+  for (int i = 0; i < 20000; ++i)
+    {
+    json += (i ? "," : "") + QByteArray::number(i);
+    items.append(qint64(i));
+    }
+  json += "]}";
+  TEST(json.size() > 2 * readChunkSize);
+
+  QBuffer device(&json);
+  device.open(QIODevice::ReadOnly);
+  Reader reader(&device);
+  TEST_EQUAL(reader.readNext(), Reader::StartObject);
+  TEST_EQUAL(reader.readValue(),
+             Value(Object{{"after", true}, {"items", items}}));
+  TEST_EQUAL(reader.readNext(), Reader::EndDocument);
+  TEST(!reader.hasError());
+
+  return 0;
+}
+
+//-----------------------------------------------------------------------------
+int testReaderErrors(qtTest& t_obj)
+{
+  using qtJson::Reader;
+
+  // Errors report the offset of the offending input
+  const QList<QPair<QByteArray, qint64>> cases{
+    {"", 0},
+    {"  \n", 3},
+    {"[1,2", 4},
+    {"[1,]", 3},
+    {"[1 2]", 3},
+    {"[}", 1},
+    {"{1:2}", 1},
+    {"{\"a\" 1}", 5},
+    {"{\"a\":}", 5},
+    {"\"ab\x01\"", 3},
+    {"+1", 0},
+    {"[0.]", 1},
+    {"1 2", 2},
+    {"{} x", 3},
+    {"[]]", 2},
+  };
+  foreach (auto const& c, cases)
+    {
+    Reader reader(c.first);
+    while (!reader.atEnd())
+      {
+      reader.readNext();
+      }
+
+    if (TEST(reader.hasError()) || TEST_EQUAL(reader.offset(), c.second))
+      {
+      t_obj.out() << "  reading " << c.first.constData() << '\n';
+      return 1;
+      }
+    TEST(!reader.errorString().isEmpty());
+
+    // Further reads repeat the error
+    TEST_EQUAL(reader.readNext(), Reader::Invalid);
+    TEST_EQUAL(reader.offset(), c.second);
+    }
+
+  // Trailing whitespace is permitted
+  Reader trailing("true \r\n\t");
+  TEST_EQUAL(trailing.readNext(), Reader::Bool);
+  TEST_EQUAL(trailing.readNext(), Reader::EndDocument);
+  TEST_EQUAL(trailing.offset(), qint64(8));
+  TEST(trailing.atEnd());
+  TEST(!trailing.hasError());
+
+  // Offsets past the first chunk of a device are absolute
+  const int padding = readChunkSize + 1000;
+  QByteArray data = "[" + QByteArray(padding, ' ') + "1,]";
+  QBuffer device(&data);
+  device.open(QIODevice::ReadOnly);
+
+  Reader reader(&device);
+  TEST_EQUAL(reader.readNext(), Reader::StartArray);
+  TEST_EQUAL(reader.offset(), qint64(0));
+  TEST_EQUAL(reader.readNext(), Reader::Number);
+  TEST_EQUAL(reader.offset(), qint64(padding + 1));
+  TEST_EQUAL(reader.readNext(), Reader::Invalid);
+  TEST_EQUAL(reader.offset(), qint64(padding + 3));
+  TEST(reader.atEnd());
+
+  data = "{}" + QByteArray(padding, ' ') + "x";
+  QBuffer trailingDevice(&data);
+  trailingDevice.open(QIODevice::ReadOnly);
+
+  Reader trailingReader(&trailingDevice);
+  TEST_EQUAL(trailingReader.readNext(), Reader::StartObject);
+  TEST_EQUAL(trailingReader.readNext(), Reader::EndObject);
+  TEST_EQUAL(trailingReader.readNext(), Reader::Invalid);
+  TEST_EQUAL(trailingReader.offset(), qint64(padding + 2));
+
+  return 0;
+}
+
+//-----------------------------------------------------------------------------
+int testReaderNavigation(qtTest& t_obj)
+{
+  using qtJson::Array;
+  using qtJson::Object;
+  using qtJson::Reader;
+  using qtJson::Value;
+
+  const QByteArray json = "{\"a\":[1,[2,3],{\"b\":{}}],\"c\":4,\"d\":[5]}";
+
+  // Skipping containers, and tracking depth
+  Reader reader(json);
+  TEST_EQUAL(reader.depth(), 0);
+  TEST_EQUAL(reader.readNext(), Reader::StartObject);
+  TEST_EQUAL(reader.depth(), 1);
+  TEST_EQUAL(reader.readNext(), Reader::Key);
+  TEST_EQUAL(reader.string(), QString("a"));
+  TEST_EQUAL(reader.readNext(), Reader::StartArray);
+  TEST_EQUAL(reader.depth(), 2);
+  TEST(reader.skipValue());
+  TEST_EQUAL(reader.tokenType(), Reader::EndArray);
+  TEST_EQUAL(reader.depth(), 1);
+
+  TEST_EQUAL(reader.readNext(), Reader::Key);
+  TEST_EQUAL(reader.string(), QString("c"));
+  TEST_EQUAL(reader.readNext(), Reader::Number);
+
+  // Skipping a simple value does nothing
+  TEST(reader.skipValue());
+  TEST_EQUAL(reader.tokenType(), Reader::Number);
+  TEST(reader.isInteger());
+  TEST_EQUAL(reader.integer(), qint64(4));
+
+  // Reading a nested value consumes it entirely
+  TEST_EQUAL(reader.readNext(), Reader::Key);
+  TEST_EQUAL(reader.readNext(), Reader::StartArray);
+  TEST_EQUAL(reader.readValue(), Value(Array{qint64(5)}));
+  TEST_EQUAL(reader.tokenType(), Reader::EndArray);
+  TEST_EQUAL(reader.depth(), 1);
+  TEST_EQUAL(reader.readNext(), Reader::EndObject);
+  TEST_EQUAL(reader.depth(), 0);
+  TEST_EQUAL(reader.readNext(), Reader::EndDocument);
+  TEST(reader.atEnd());
+  TEST(!reader.hasError());
+
+  // Reading the whole document
+  Reader whole(json);
+  whole.readNext();
+  const Object b{{"b", Object()}};
+  const Array a{qint64(1), Array{qint64(2), qint64(3)}, b};
+  const Array d{qint64(5)};
+  TEST_EQUAL(whole.readValue(),
+             Value(Object{{"a", a}, {"c", qint64(4)}, {"d", d}}));
+
+  // Errors inside a skipped or read value are reported
+  Reader skipped("[[1,]]");
+  skipped.readNext();
+  TEST(!skipped.skipValue());
+  TEST(skipped.hasError());
+
+  Reader read("[1,{\"a\":}]");
+  read.readNext();
+  TEST(!read.readValue().isValid());
+  TEST(read.hasError());
+
+  return 0;
+}
+
+//-----------------------------------------------------------------------------
+int testDocuments(qtTest& t_obj)
+{
+  using qtJson::Document;
+
+  qtJson::Object object;
+  object.insert("name", QString("point"));
+  object.insert("id", QVariant::fromValue(Q_UINT64_C(9007199254740993)));
+  object.insert("scale", QVariant::fromValue(0.1f));
+  object.insert("visible", true);
+  object.insert("raw", qtJson::JsonData("{\"a\":1}"));
+  object.insert("coordinates", qtJson::Array{1.5, -2, QVariant()});
+  const QVariant value = object;
+
+  // Conversion to and from QVariant, and encoding, must match the QVariant
+  // based representation
+  const Document document = Document::fromValue(value);
+  TEST_EQUAL(document.toValue(), value);
+  TEST_EQUAL(qtJson::encode(document), qtJson::encode(value));
+
+  // Members are found by key
+  const Document::Node root = document.root();
+  TEST_EQUAL(document.type(root), Document::ObjectType);
+  TEST_EQUAL(document.count(root), 6);
+  TEST_EQUAL(document.toString(document.find(root, "name")),
+             QString("point"));
+  TEST_EQUAL(document.find(root, "missing"), -1);
+
+  const Document::Node coordinates = document.find(root, "coordinates");
+  TEST_EQUAL(document.count(coordinates), 3);
+  TEST(document.toReal(document.item(coordinates, 0)) == 1.5);
+  TEST_EQUAL(document.toInteger(document.item(coordinates, 1)), qint64(-2));
+  TEST_EQUAL(document.type(document.item(coordinates, 2)),
+             Document::NullType);
+
+  // Building bottom-up; members are sorted, and the last duplicate is used
+  Document built;
+  const Document::Node a = built.addInteger(1);
+  const Document::Node b = built.addString("two");
+  const Document::Node c = built.addBool(false);
+  built.setRoot(built.addObject({{"b", b}, {"a", a}, {"b", c}}));
+  TEST_EQUAL(qtJson::encode(built), qtJson::JsonData("{\"a\":1,\"b\":false}"));
+  TEST_EQUAL(built.key(built.root(), 0), QString("a"));
+
+  // Containers may only reference existing nodes
+  const int nodeCount = built.nodeCount();
+  TEST_EQUAL(built.addArray({a, nodeCount}), -1);
+  TEST_EQUAL(built.addArray({-1}), -1);
+  TEST_EQUAL(built.addObject({{"a", a}, {"b", nodeCount + 5}}), -1);
+  TEST_EQUAL(built.nodeCount(), nodeCount);
+  TEST_EQUAL(built.addArray({}), nodeCount);
+
+  // Reading from text
+  qtJson::Reader reader(qtJson::encode(value));
+  reader.readNext();
+  const Document parsed = Document::read(reader);
+  TEST(!parsed.isEmpty());
+  TEST_EQUAL(qtJson::encode(parsed), qtJson::encode(value));
+
+  // Empty documents encode as null
+  TEST_EQUAL(qtJson::encode(Document()), qtJson::JsonData("null"));
+
+  return 0;
+}
+
+//-----------------------------------------------------------------------------
+int testBenchmark(qtTest& t_obj)
+{
+  // Numeric-heavy document: an array of geospatial coordinates
+  qtJson::Array coordinates;
+  qsrand(11);
+  for (int i = 0; i < 200000; ++i)
+    {
+    qtJson::Array point;
+    point.append((qtRandD() * 180.0) - 90.0);
+    point.append((qtRandD() * 360.0) - 180.0);
+    coordinates.append(QVariant(point));
+    }
+
+  QElapsedTimer timer;
+  const auto measure = [&](qtJson::RealFormat format, qint64& bytes) {
+    timer.start();
+    bytes = qtJson::encode(coordinates, format).size();
+    const qint64 ns = qMax(timer.nsecsElapsed(), qint64(1));
+    return (static_cast<double>(bytes) * 1e3) / static_cast<double>(ns);
+  };
+
+  qint64 legacyBytes, shortestBytes;
+  const double legacyRate = measure(qtJson::LegacyReal, legacyBytes);
+  const double shortestRate = measure(qtJson::ShortestReal, shortestBytes);
+
+  TEST(legacyBytes > 0);
+  TEST(shortestBytes > 0);
+
+  t_obj.out() << "  legacy: " << legacyRate << " MB/s (" << legacyBytes
+              << " bytes), shortest: " << shortestRate << " MB/s ("
+              << shortestBytes << " bytes)\n";
+
+  return 0;
+}
+
+//-----------------------------------------------------------------------------
+int main()
+{
+  qtTest t_obj;
+
+  t_obj.runSuite("Writer", testWriter);
+  t_obj.runSuite("Real Formatting", testReals);
+  t_obj.runSuite("String Escaping", testStrings);
+  t_obj.runSuite("Reader Chunks", testReaderChunks);
+  t_obj.runSuite("Reader Errors", testReaderErrors);
+  t_obj.runSuite("Reader Navigation", testReaderNavigation);
+  t_obj.runSuite("Documents", testDocuments);
+  t_obj.runSuite("Benchmark", testBenchmark);
+  return t_obj.result();
+}
@@ -11,8 +11,16 @@
 
 #include "../io/qtKstParser.h"
 #include "../io/qtKstReader.h"
+#include "../io/qtKstWriter.h"
 #include "../io/qtStringStream.h"
 
+#include <QBuffer>
+#include <QFile>
+#include <QStandardPaths>
+#include <QTemporaryFile>
+
+#include <limits>
+
 QUrl testFile;
 
 //-----------------------------------------------------------------------------
@@ -162,6 +170,8 @@ int testBasicLong(qtTest& t_obj)
   TEST_CALL(testLong, "-z,xq551^7@36", -2816160313680LL);
   TEST_CALL(testLong, "zzz^-1@36", 1295);
   TEST_CALL(testLong, "1e010", 10000000000);
+  TEST_CALL(testLong, "12.75e1", 127);
+  TEST_CALL(testLong, "-1E+3", -1000);
   return 0;
 }
 
@@ -182,6 +192,9 @@ int testBasicReal(qtTest& t_obj)
   TEST_CALL(testReal, "-z,xq551^3@36", -1676669.139660494);
   TEST_CALL(testReal, "zzz^-1@36", 1295.972222222222);
   TEST_CALL(testReal, "1e010", 1e10);
+  TEST_CALL(testReal, "-.5", -0.5);
+  TEST_CALL(testReal, "2.5E-3", 0.0025);
+  TEST_CALL(testReal, "123456789012345678901234567890", 1.2345678901234568e29);
   return 0;
 }
 
@@ -279,6 +292,9 @@ int testOverflowUnderflow(qtTest& t_obj)
   TEST_CALL(testLong,  "9223372036854775808", 0, false);
   TEST_CALL(testLong, "-9223372036854775808", 0x8000000000000000LL);
   TEST_CALL(testLong, "-9223372036854775809", 0, false);
+  TEST_CALL(testLong, "123e9223372036854775807", 0, false);
+  TEST_CALL(testLong, "0e9223372036854775807", 0);
+  TEST_CALL(testLong, "123e-9223372036854775807", 0);
   // Real
   TEST_CALL(testReal,  "1e400",  qInf());
   TEST_CALL(testReal, "-1e400", -qInf());
@@ -286,6 +302,10 @@ int testOverflowUnderflow(qtTest& t_obj)
   TEST_CALL(testReal, "-1e2000b8", -qInf());
   TEST_CALL(testReal,  "1e-400", 0.0);
   TEST_CALL(testReal, "-1e-400", 0.0);
+  TEST_CALL(testReal,  "1.25e9223372036854775807",  qInf());
+  TEST_CALL(testReal, "-1.25e9223372036854775807", -qInf());
+  TEST_CALL(testReal,  "1.25e-9223372036854775807", 0.0);
+  TEST_CALL(testReal,  "0.0e9223372036854775807", 0.0);
   QString bigNum = QString().fill('9', 400);
   TEST_CALL(testReal,       bigNum,  qInf());
   TEST_CALL(testReal, "-" + bigNum, -qInf());
@@ -589,6 +609,62 @@ int testFileValues(qtTest& t_obj)
   return 0;
 }
 
+//-----------------------------------------------------------------------------
+int testColumns(qtTest& t_obj)
+{
+  qtKstReader r("[ [ 1, 2.5 ], [ 2, 3.5, x ], [ 3, 4.5 ] ], [ 6, 7, 8 ];");
+  if (TEST(r.isValid()))
+    return 1;
+
+  qtKstReader rt;
+  if (TEST(r.readTable(rt)))
+    return 1;
+
+  QVector<int> ic;
+  QVector<double> rc;
+
+  // Reading columns of table
+  TEST(rt.readIntColumn(ic, 0));
+  TEST_EQUAL(ic.count(), 3);
+  TEST_EQUAL(ic[0], 1);
+  TEST_EQUAL(ic[1], 2);
+  TEST_EQUAL(ic[2], 3);
+  TEST(rt.readRealColumn(rc, 1));
+  TEST_EQUAL(rc.count(), 3);
+  TEST_EQUAL(rc[0], 2.5);
+  TEST_EQUAL(rc[1], 3.5);
+  TEST_EQUAL(rc[2], 4.5);
+
+  // Can't read column that is missing from some records
+  TEST(!rt.readRealColumn(rc, 2));
+  TEST(rc.isEmpty());
+
+  // Can't read columns when streaming, as only the current record is kept
+  QByteArray data("1, 2.5; 2, 3.5; 3, 4.5;");
+  QBuffer buffer(&data);
+  buffer.open(QIODevice::ReadOnly);
+
+  qtKstReader sr(&buffer);
+  if (TEST(sr.isValid()))
+    return 1;
+  TEST(sr.nextRecord());
+  TEST(!sr.readIntColumn(ic, 0));
+  TEST(ic.isEmpty());
+  TEST(!sr.readRealColumn(rc, 1));
+  TEST(rc.isEmpty());
+
+  // Reading array into vector
+  QVector<qint64> la;
+  TEST(r.nextValue());
+  TEST(r.readLongArray(la));
+  TEST_EQUAL(la.count(), 3);
+  TEST_EQUAL(la[0], Q_INT64_C(6));
+  TEST_EQUAL(la[1], Q_INT64_C(7));
+  TEST_EQUAL(la[2], Q_INT64_C(8));
+
+  return 0;
+}
+
 //-----------------------------------------------------------------------------
 int testSeparator(qtTest& t_obj)
 {
@@ -600,6 +676,543 @@ int testSeparator(qtTest& t_obj)
   TEST_EQUAL(r.valueCount(0), 3);
   TEST_EQUAL(r.valueCount(1), 2);
 
+  // Multi-character literals, including partial matches and characters that
+  // are only special at the start of a value
+  const QRegExp::PatternSyntax fixed = QRegExp::FixedString;
+  qtKstReader lr("a:b::c\"d[e:: f#x\n;;g;;",
+                 QRegExp("::", Qt::CaseSensitive, fixed),
+                 QRegExp(";;", Qt::CaseSensitive, fixed));
+  if (TEST(lr.isValid()))
+    return 1;
+
+  QString sv;
+  TEST_EQUAL(lr.recordCount(), 2);
+  TEST_EQUAL(lr.valueCount(0), 3);
+  TEST(lr.readString(sv, 0, 0));
+  TEST_EQUAL(sv, QString("a:b"));
+  TEST(lr.readString(sv, 1, 0));
+  TEST_EQUAL(sv, QString("c\"d[e"));
+  TEST(lr.readString(sv, 2, 0));
+  TEST_EQUAL(sv, QString("f"));
+  TEST(lr.readString(sv, 0, 1));
+  TEST_EQUAL(sv, QString("g"));
+
+  return 0;
+}
+
+//-----------------------------------------------------------------------------
+int testStreaming(qtTest& t_obj)
+{
+  QByteArray data("1, 2; 3; # comment\n [ 4, 5 ], \"six\";");
+  QBuffer buffer(&data);
+  buffer.open(QIODevice::ReadOnly);
+
+  qtKstReader r(&buffer);
+  if (TEST(r.isValid()))
+    return 1;
+
+  int iv;
+  QString sv;
+  QList<int> ia;
+
+  // Only records read so far are counted
+  TEST_EQUAL(r.recordCount(), 1);
+  TEST_EQUAL(r.valueCount(), 2);
+  TEST(r.readInt(iv));
+  TEST_EQUAL(iv, 1);
+  TEST(r.nextValue());
+  TEST(r.readInt(iv));
+  TEST_EQUAL(iv, 2);
+
+  TEST(r.nextRecord());
+  TEST_EQUAL(r.currentRecord(), 1);
+  TEST_EQUAL(r.recordCount(), 2);
+  TEST(r.readInt(iv));
+  TEST_EQUAL(iv, 3);
+
+  // Previous records are discarded when the reader advances
+  TEST(!r.seek(0));
+  TEST(!r.readInt(iv, 0, 0));
+  TEST_EQUAL(r.valueCount(0), -1);
+  TEST_EQUAL(r.currentRecord(), 1);
+
+  TEST(r.nextRecord());
+  TEST(r.readIntArray(ia));
+  TEST_EQUAL(ia.count(), 2);
+  TEST_EQUAL(ia[0], 4);
+  TEST_EQUAL(ia[1], 5);
+  TEST(r.nextValue());
+  TEST(r.readString(sv));
+  TEST_EQUAL(sv, QString("six"));
+
+  TEST(r.nextRecord());
+  TEST(r.isEndOfFile());
+  TEST(!r.nextRecord());
+  TEST(r.isValid());
+
+  return 0;
+}
+
+//-----------------------------------------------------------------------------
+int testStreamingLarge(qtTest& t_obj)
+{
+  // Generate enough data to span many reads, with strings and separators
+  // falling across read boundaries
+  const int count = 20000;
+  QByteArray data;
+  for (int i = 0; i < count; ++i)
+    {
+    data += QByteArray::number(i) + ", \"value\\\" " +
+            QByteArray::number(i) + "\"; # comment\n";
+    }
+  QBuffer buffer(&data);
+  buffer.open(QIODevice::ReadOnly);
+
+  qtKstReader r(&buffer);
+  if (TEST(r.isValid()))
+    return 1;
+
+  for (int i = 0; i < count; ++i)
+    {
+    int iv;
+    QString sv;
+    if (TEST(r.readInt(iv, 0)) || TEST_EQUAL(iv, i) ||
+        TEST(r.readString(sv, 1)) ||
+        TEST_EQUAL(sv, QString("value\" %1").arg(i)))
+      {
+      return 1;
+      }
+    r.nextRecord();
+    }
+
+  TEST(r.isEndOfFile());
+  TEST(r.isValid());
+
+  return 0;
+}
+
+//-----------------------------------------------------------------------------
+int testStreamingFile(qtTest& t_obj)
+{
+  QFile file(testFile.toLocalFile());
+  if (TEST(file.open(QIODevice::ReadOnly | QIODevice::Text)))
+    return 1;
+
+  qtKstReader r(&file);
+  if (TEST(r.isValid()))
+    return 1;
+
+  double rv;
+  QList<qint64> la;
+
+  TEST_EQUAL(r.valueCount(), 3);
+  TEST(r.nextRecord());
+  TEST_EQUAL(r.valueCount(), 2);
+  TEST(r.nextRecord());
+  TEST(r.readReal(rv));
+  TEST_EQUAL(rv, 55.202558333333333);
+  TEST(r.nextRecord());
+  TEST(r.readLongArray(la));
+  TEST_EQUAL(la.count(), 2);
+  TEST(r.nextRecord());
+  TEST_EQUAL(r.valueCount(), 1);
+  TEST(r.nextRecord());
+  TEST(r.isEndOfFile());
+  TEST_EQUAL(r.recordCount(), 5);
+
+  return 0;
+}
+
+//-----------------------------------------------------------------------------
+int testStreamingInvalid(qtTest& t_obj)
+{
+  qtTest::StreamPointer stream(new qtStringStream);
+  uint token = t_obj.pushMessageStream(stream);
+
+  QByteArray data("1; 2; [3;");
+  QBuffer buffer(&data);
+  buffer.open(QIODevice::ReadOnly);
+
+  // Errors are not detected until the reader reaches the bad record
+  qtKstReader r(&buffer);
+  TEST(r.isValid());
+  TEST(r.nextRecord());
+  TEST(r.isValid());
+  TEST(r.nextRecord());
+  TEST(!r.isValid());
+
+  t_obj.popMessageStream(token);
+  return 0;
+}
+
+//-----------------------------------------------------------------------------
+int compareReaders(qtTest& t_obj, qtKstReader& a, qtKstReader& b)
+{
+  if (TEST_EQUAL(a.recordCount(), b.recordCount()))
+    return 1;
+
+  for (int i = 0; i < a.recordCount(); ++i)
+    {
+    if (TEST_EQUAL(a.valueCount(i), b.valueCount(i)))
+      return 1;
+
+    for (int j = 0; j < a.valueCount(i); ++j)
+      {
+      QString as, bs;
+      qint64 al, bl;
+      double ar, br;
+      TEST_EQUAL(a.isValueEmpty(j, i), b.isValueEmpty(j, i));
+      TEST_EQUAL(a.isArrayEmpty(j, i), b.isArrayEmpty(j, i));
+      TEST_EQUAL(a.readString(as, j, i), b.readString(bs, j, i));
+      TEST_EQUAL(as, bs);
+      TEST_EQUAL(a.readLong(al, j, i), b.readLong(bl, j, i));
+      if (b.readLong(bl, j, i))
+        TEST_EQUAL(al, bl);
+      TEST_EQUAL(a.readReal(ar, j, i), b.readReal(br, j, i));
+      if (b.readReal(br, j, i))
+        TEST_EQUAL(ar, br);
+
+      qtKstReader aa, ba;
+      if (b.readArray(ba, j, i))
+        {
+        if (TEST(a.readArray(aa, j, i)))
+          return 1;
+        TEST_CALL(compareReaders, aa, ba);
+        }
+      }
+    }
+
+  return 0;
+}
+
+//-----------------------------------------------------------------------------
+int testMapped(qtTest& t_obj)
+{
+  // Exercise the raw parsing path with data that covers spans, escapes, CR-LF
+  // line endings and discontiguous values, and compare the result against
+  // parsing the same data as decoded text
+  const QByteArray data =
+    "\xef\xbb\xbf# header\r\n"
+    "1, -2.5, 1e3, 0x1f, 55\xc2\xb0" "12\xe2\x80\xb2;\r\n"
+    "\"plain\", \"esc\\\"aped\", \"cr\r\nlf\", \"cont\\\r\ninued\";\r\n"
+    "1 2 3, \"a\" \"b\", x\"y\", [ 4, [ 5 ], \"\\q\" ], [];\r\n"
+    "\xe2\x80\x83spaced\xe2\x80\x83value\xe2\x80\x83;\r\n";
+
+  QTemporaryFile file;
+  if (TEST(file.open()))
+    return 1;
+  file.write(data);
+  file.close();
+
+  qtKstReader mapped(QUrl::fromLocalFile(file.fileName()));
+  if (TEST(mapped.isValid()))
+    return 1;
+
+  QString text = QString::fromUtf8(data.mid(3));
+  text.replace("\r\n", "\n");
+
+  qtKstReader decoded(text);
+  if (TEST(decoded.isValid()))
+    return 1;
+
+  TEST_CALL(compareReaders, mapped, decoded);
+
+  QString sv;
+  TEST(mapped.readString(sv, 1, 1));
+  TEST_EQUAL(sv, QString("esc\"aped"));
+  TEST(mapped.readString(sv, 2, 1));
+  TEST_EQUAL(sv, QString("cr\nlf"));
+  TEST(mapped.readString(sv, 3, 1));
+  TEST_EQUAL(sv, QString("continued"));
+  TEST(mapped.readString(sv, 0, 2));
+  TEST_EQUAL(sv, QString("123"));
+  TEST(mapped.readString(sv, 0, 3));
+  TEST_EQUAL(sv, QString("spacedvalue"));
+
+  return 0;
+}
+
+//-----------------------------------------------------------------------------
+int testParallel(qtTest& t_obj)
+{
+  // Generate enough data to be split into several chunks, with terminators
+  // appearing inside strings, comments and arrays so that chunk boundaries
+  // can only be found by correctly scanning the data
+  QByteArray data;
+  for (int i = 0; i < 40000; ++i)
+    {
+    data += QByteArray::number(i) + ", " + QByteArray::number(i * 0.25);
+    switch (i % 4)
+      {
+      case 0:
+        data += ", \"semi;colon\";\n";
+        break;
+      case 1:
+        data += ", \"multi\nline;\\\"\"; # comment;\n";
+        break;
+      case 2:
+        data += ", [ 1; 2, [ 3 ] ];\n";
+        break;
+      default:
+        data += ";\n";
+        break;
+      }
+    }
+
+  QTemporaryFile file;
+  if (TEST(file.open()))
+    return 1;
+  file.write(data);
+  file.close();
+
+  const QUrl url = QUrl::fromLocalFile(file.fileName());
+  qtKstReader parallel(url, qtKstReader::ParallelLoad);
+  if (TEST(parallel.isValid()))
+    return 1;
+
+  qtKstReader sequential(url);
+  if (TEST(sequential.isValid()))
+    return 1;
+
+  TEST_EQUAL(parallel.recordCount(), 40000);
+  TEST_CALL(compareReaders, parallel, sequential);
+
+  // Errors must be detected regardless of where they occur
+  QTemporaryFile invalidFile;
+  if (TEST(invalidFile.open()))
+    return 1;
+  invalidFile.write(data);
+  invalidFile.write("1, \"unterminated;\n");
+  invalidFile.close();
+
+  const QUrl invalidUrl = QUrl::fromLocalFile(invalidFile.fileName());
+  TEST(!qtKstReader(invalidUrl, qtKstReader::ParallelLoad).isValid());
+
+  return 0;
+}
+
+//-----------------------------------------------------------------------------
+int testCache(qtTest& t_obj)
+{
+  QStandardPaths::setTestModeEnabled(true);
+
+  QTemporaryFile file;
+  if (TEST(file.open()))
+    return 1;
+  file.write("1, \"two\", [ 3, [ 4.5 ] ], ;\n"
+             "# comment\n"
+             "\"esc\\\"aped\", x y;\n");
+  file.close();
+
+  const QUrl url = QUrl::fromLocalFile(file.fileName());
+  const QString cache = qtKstReader::cacheFile(url);
+  QFile::remove(cache);
+
+  // First load parses the file and writes the cache
+  qtKstReader parsed(url, qtKstReader::UseCache);
+  if (TEST(parsed.isValid()))
+    return 1;
+  TEST(QFile::exists(cache));
+
+  // Second load reads the cache
+  qtKstReader cached(url, qtKstReader::UseCache);
+  if (TEST(cached.isValid()))
+    return 1;
+
+  qtKstReader reference(url);
+  TEST_CALL(compareReaders, cached, reference);
+
+  // Corrupt cache must not be used; overwrite the node count in the header
+  // (which follows two 32-bit and three 64-bit fields) with a count whose
+  // section size would overflow
+  QFile corrupt(cache);
+  if (TEST(corrupt.open(QIODevice::ReadWrite)))
+    return 1;
+  const qint64 nodeCount = Q_INT64_C(0x4000000000000001);
+  TEST(corrupt.seek(32));
+  TEST_EQUAL(corrupt.write(reinterpret_cast<const char*>(&nodeCount),
+                           sizeof(nodeCount)),
+             static_cast<qint64>(sizeof(nodeCount)));
+  corrupt.close();
+
+  qtKstReader recovered(url, qtKstReader::UseCache);
+  if (TEST(recovered.isValid()))
+    return 1;
+  TEST_CALL(compareReaders, recovered, reference);
+
+  // Likewise for a value whose text offset would overflow when added to its
+  // length; the cache was rewritten by the previous load, and the first
+  // value follows the first record's node (the nodes follow the header and
+  // the key, which is padded to a multiple of 8 bytes)
+  if (TEST(corrupt.open(QIODevice::ReadWrite)))
+    return 1;
+  qint64 keySize = 0;
+  TEST(corrupt.seek(24));
+  TEST_EQUAL(corrupt.read(reinterpret_cast<char*>(&keySize),
+                          sizeof(keySize)),
+             static_cast<qint64>(sizeof(keySize)));
+  const qint64 valueNode = 48 + ((keySize + 7) / 8 * 8) + 16;
+  const qint64 offset = std::numeric_limits<qint64>::max();
+  TEST(corrupt.seek(valueNode));
+  TEST_EQUAL(corrupt.write(reinterpret_cast<const char*>(&offset),
+                           sizeof(offset)),
+             static_cast<qint64>(sizeof(offset)));
+  corrupt.close();
+
+  qtKstReader reparsed(url, qtKstReader::UseCache);
+  if (TEST(reparsed.isValid()))
+    return 1;
+  TEST_CALL(compareReaders, reparsed, reference);
+
+  // Parsing depends on the separators, so they must not share a cache
+  const QRegExp separator(";", Qt::CaseSensitive, QRegExp::FixedString);
+  TEST(qtKstReader::cacheFile(url, separator) != cache);
+
+  // Stale cache must not be used
+  QFile modified(file.fileName());
+  if (TEST(modified.open(QIODevice::WriteOnly | QIODevice::Truncate)))
+    return 1;
+  modified.write("5, 6;\n");
+  modified.close();
+
+  int iv;
+  qtKstReader updated(url, qtKstReader::UseCache);
+  TEST(updated.isValid());
+  TEST_EQUAL(updated.recordCount(), 1);
+  TEST(updated.readInt(iv, 0, 0));
+  TEST_EQUAL(iv, 5);
+
+  QFile::remove(cache);
+  return 0;
+}
+
+//-----------------------------------------------------------------------------
+int testWriter(qtTest& t_obj)
+{
+  const double reals[] = {
+    0.1, 1.0 / 3.0, -2.5e-8, 6.02214076e23, 1e300, 123456789.125, 4.0, -0.0,
+    std::numeric_limits<double>::infinity()
+  };
+  const int realCount = static_cast<int>(sizeof(reals) / sizeof(double));
+
+  const QString strings[] = {
+    QString(), QString("plain"), QString("has, separator; and terminator"),
+    QString("quote \" and \\ backslash"), QString("multi\nline"),
+    QString::fromUtf8("\xc2\xb0 \xe2\x80\xb2 \xf0\x9f\x98\x80")
+  };
+  const int stringCount = static_cast<int>(sizeof(strings) / sizeof(QString));
+
+  const qint64 minLong = std::numeric_limits<qint64>::min();
+  const qint64 maxLong = std::numeric_limits<qint64>::max();
+
+  QByteArray data;
+  QBuffer buffer(&data);
+  buffer.open(QIODevice::WriteOnly);
+  {
+    qtKstWriter w(&buffer);
+    if (TEST(w.isValid()))
+      return 1;
+
+    w.writeInt(42);
+    w.writeLong(minLong);
+    w.writeLong(maxLong);
+    w.endRecord();
+
+    for (int i = 0; i < realCount; ++i)
+      w.writeReal(reals[i]);
+    w.endRecord();
+
+    for (int i = 0; i < stringCount; ++i)
+      w.writeString(strings[i]);
+    w.endRecord();
+
+    w.writeIntArray(QList<int>() << 1 << -2 << 3);
+    w.writeRealArray(QVector<double>() << 0.5 << 1e-3);
+    w.beginArray();
+    w.writeIntArray(QVector<int>() << 1 << 2);
+    w.writeIntArray(QVector<int>() << 3 << 4);
+    w.endArray();
+    w.writeString("after");
+    w.endRecord();
+  }
+
+  qtKstReader r(QString::fromUtf8(data));
+  if (TEST(r.isValid()))
+    return 1;
+
+  TEST_EQUAL(r.recordCount(), 4);
+
+  int iv;
+  qint64 lv;
+  double rv;
+  QString sv;
+  TEST(r.readInt(iv, 0, 0));
+  TEST_EQUAL(iv, 42);
+  TEST(r.readLong(lv, 1, 0));
+  TEST_EQUAL(lv, minLong);
+  TEST(r.readLong(lv, 2, 0));
+  TEST_EQUAL(lv, maxLong);
+
+  TEST_EQUAL(r.valueCount(1), realCount);
+  for (int i = 0; i < realCount; ++i)
+    {
+    // Values must round trip exactly (TEST_EQUAL is fuzzy for reals)
+    TEST(r.readReal(rv, i, 1));
+    TEST(rv == reals[i]);
+    }
+
+  TEST_EQUAL(r.valueCount(2), stringCount);
+  for (int i = 0; i < stringCount; ++i)
+    {
+    TEST(r.readString(sv, i, 2));
+    TEST_EQUAL(sv, strings[i]);
+    }
+
+  QList<int> ia;
+  QVector<double> ra;
+  TEST(r.readIntArray(ia, 0, 3));
+  TEST_EQUAL(ia, QList<int>() << 1 << -2 << 3);
+  TEST(r.readRealArray(ra, 1, 3));
+  TEST_EQUAL(ra, QVector<double>() << 0.5 << 1e-3);
+
+  qtKstReader table;
+  if (!TEST(r.readTable(table, 2, 3)))
+    {
+    TEST_EQUAL(table.recordCount(), 2);
+    TEST(table.readInt(iv, 1, 1));
+    TEST_EQUAL(iv, 4);
+    }
+  TEST(r.readString(sv, 3, 3));
+  TEST_EQUAL(sv, QString("after"));
+
+  // Custom separators; arrays left open are closed at the end of the record
+  QByteArray custom;
+  QBuffer customBuffer(&custom);
+  customBuffer.open(QIODevice::WriteOnly);
+  {
+    qtKstWriter w(&customBuffer, "|", "\n");
+    w.writeInt(1);
+    w.beginArray();
+    w.writeInt(2);
+    w.writeInt(3);
+    w.endRecord();
+    w.writeString("x|y");
+    w.endRecord();
+  }
+
+  const QRegExp::PatternSyntax fixed = QRegExp::FixedString;
+  qtKstReader cr(QString::fromUtf8(custom),
+                 QRegExp("|", Qt::CaseSensitive, fixed),
+                 QRegExp("\n", Qt::CaseSensitive, fixed));
+  if (TEST(cr.isValid()))
+    return 1;
+
+  TEST_EQUAL(cr.recordCount(), 2);
+  TEST(cr.readIntArray(ia, 1, 0));
+  TEST_EQUAL(ia, QList<int>() << 2 << 3);
+  TEST(cr.readString(sv, 0, 1));
+  TEST_EQUAL(sv, QString("x|y"));
+
   return 0;
 }
 
@@ -630,6 +1243,15 @@ int main(int argc, const char* argv[])
   t_obj.runSuite("Reader Array Tests", testArray);
   t_obj.runSuite("Reader Empty Tests", testEmpty);
   t_obj.runSuite("Reader File Value Tests", testFileValues);
+  t_obj.runSuite("Reader Column Tests", testColumns);
   t_obj.runSuite("Reader Separator Tests", testSeparator);
+  t_obj.runSuite("Reader Mapped Data Tests", testMapped);
+  t_obj.runSuite("Reader Parallel Load Tests", testParallel);
+  t_obj.runSuite("Reader Cache Tests", testCache);
+  t_obj.runSuite("Writer Round Trip Tests", testWriter);
+  t_obj.runSuite("Reader Streaming Tests", testStreaming);
+  t_obj.runSuite("Reader Streaming Large Data Tests", testStreamingLarge);
+  t_obj.runSuite("Reader Streaming File Tests", testStreamingFile);
+  t_obj.runSuite("Reader Streaming Invalid Data Tests", testStreamingInvalid);
   return t_obj.result();
 }
@@ -6,10 +6,14 @@
 
 #include "../core/qtTest.h"
 #include "../util/qtNaturalSort.h"
+#include "../util/qtRand.h"
 
 #include <QDebug>
+#include <QElapsedTimer>
 #include <QTextCodec>
 
+#include <algorithm>
+
 using namespace qtNaturalSort;
 
 // U+1D7FB mathematical monospace digit '5'
@@ -127,6 +131,16 @@ void testCompVar(qtTest& t_obj, QString const& s1, QString const& s2,
 
     TEST_EQUAL(c(v2, v1), x);
     TEST_EQUAL(c(v1, v2), !x);
+
+    const auto& k1 = sortKey(v1);
+    const auto& k2 = sortKey(v2);
+
+    TEST_EQUAL(k2 < k1, x);
+    TEST_EQUAL(k1 < k2, !x);
+
+    TEST_EQUAL(compareStreaming(v1, v1), 0);
+    TEST_EQUAL(compareStreaming(v2, v1) < 0, x);
+    TEST_EQUAL(compareStreaming(v1, v2) < 0, !x);
 }
 
 //-----------------------------------------------------------------------------
@@ -168,6 +182,108 @@ int testCompare(qtTest& t_obj)
     return 0;
 }
 
+//-----------------------------------------------------------------------------
+int testSort(qtTest& t_obj)
+{
+    QStringList list;
+    list << "frame10.png" << "frame9.png" << "frame010.png" << "Frame2.png"
+         << "frame" << "frame" + special5 + ".png" << "frame5.png"
+         << QString(QChar(0)) << "" << "frame10.png" << "frame0.png"
+         << "frame00.png" << "a" + QString(QChar(1)) << "a";
+
+    auto expected = list;
+    std::sort(expected.begin(), expected.end(), compare{});
+
+    sort(list);
+    TEST_EQUAL(list, expected);
+
+    return 0;
+}
+
+//-----------------------------------------------------------------------------
+QString randomString(int maxLength)
+{
+    // Use a small alphabet, so that strings frequently share groups
+    static auto const& alphabet =
+        QString::fromUtf8(u8"0001599ab.\u00e9\u0665") + QChar(0) + QChar(1);
+
+    QString s;
+    auto const n = qtRand(maxLength + 1);
+    for (int i = 0; i < n; ++i)
+    {
+        if (qtRand(10) == 0)
+            s += special5;
+        else
+            s += alphabet.at(qtRand(alphabet.length()));
+    }
+    return s;
+}
+
+//-----------------------------------------------------------------------------
+int testStreaming(qtTest& t_obj)
+{
+    qsrand(5);
+
+    compare c;
+    for (int i = 0; i < 20000; ++i)
+    {
+        auto const& s1 = randomString(8);
+        auto const& s2 = randomString(8);
+        auto const r = compareStreaming(s1, s2);
+
+        if (TEST_EQUAL(r < 0, c(s1, s2)) || TEST_EQUAL(r > 0, c(s2, s1)) ||
+            TEST_EQUAL(r == 0, s1 == s2))
+        {
+            t_obj.out() << "  while comparing " << s1 << " to " << s2 << '\n';
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+//-----------------------------------------------------------------------------
+int testBenchmark(qtTest& t_obj)
+{
+    // Typical file browser content: many frame names that differ only in the
+    // frame number
+    QStringList names;
+    for (int i = 0; i < 100000; ++i)
+    {
+        auto const frame = static_cast<int>(i * 7919LL % 100000);
+        names.append(QString("shot%1_frame%2.png").arg(i % 7).arg(frame));
+    }
+
+    QElapsedTimer timer;
+
+    auto list = names;
+    timer.start();
+    std::sort(list.begin(), list.end(), compare{});
+    auto const tCompare = timer.elapsed();
+
+    auto streamingList = names;
+    timer.start();
+    std::sort(streamingList.begin(), streamingList.end(),
+              [](QString const& a, QString const& b) {
+                  return compareStreaming(a, b) < 0;
+              });
+    auto const tStreaming = timer.elapsed();
+
+    auto keyList = names;
+    timer.start();
+    sort(keyList);
+    auto const tKeys = timer.elapsed();
+
+    TEST_EQUAL(streamingList, list);
+    TEST_EQUAL(keyList, list);
+
+    t_obj.out() << "  compare: " << tCompare << " ms"
+                << ", compareStreaming: " << tStreaming << " ms"
+                << ", sort: " << tKeys << " ms\n";
+
+    return 0;
+}
+
 //-----------------------------------------------------------------------------
 int main()
 {
@@ -175,5 +291,8 @@ int main()
 
   t_obj.runSuite("Cracking", testCracking);
   t_obj.runSuite("Comparisons", testCompare);
+  t_obj.runSuite("Sorting", testSort);
+  t_obj.runSuite("Streaming Comparisons", testStreaming);
+  t_obj.runSuite("Benchmark", testBenchmark);
   return t_obj.result();
 }
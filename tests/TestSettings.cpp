@@ -0,0 +1,185 @@
+// This file is part of qtExtensions, and is distributed under the
+// OSI-approved BSD 3-Clause License. See top-level LICENSE file or
+// https://github.com/Kitware/qtExtensions/blob/master/LICENSE for details.
+
+#define TEST_OBJECT_NAME t_obj
+
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QSettings>
+#include <QTemporaryDir>
+#include <QThread>
+
+#include "../core/qtTest.h"
+
+#include "../util/qtSettings.h"
+
+//-----------------------------------------------------------------------------
+class TestSettings : public qtSettings
+{
+public:
+  TestSettings()
+    {
+    this->declareSetting("alpha", QVariant(0));
+    this->declareSetting("beta", QString("b"));
+    }
+
+  using qtSettings::value;
+  using qtSettings::setValue;
+};
+
+//-----------------------------------------------------------------------------
+QVariant storedValue(const QString& key)
+{
+  return QSettings().value(key);
+}
+
+//-----------------------------------------------------------------------------
+int testSynchronous(qtTest& t_obj)
+{
+  QSettings().clear();
+
+  TestSettings settings;
+  TEST_EQUAL(settings.commitMode(), qtSettings::SynchronousCommit);
+  TEST_EQUAL(settings.value("alpha"), QVariant(0));
+
+  // Values are written when committed
+  settings.setValue("alpha", 1);
+  TEST(settings.hasUncommittedChanges());
+  TEST(!storedValue("alpha").isValid());
+
+  settings.commit();
+  TEST(!settings.hasUncommittedChanges());
+  TEST(settings.wasCommitted());
+  TEST_EQUAL(storedValue("alpha").toInt(), 1);
+
+  // Discarded values are not written
+  settings.setValue("alpha", 2);
+  settings.discard();
+  TEST_EQUAL(settings.value("alpha").toInt(), 1);
+  settings.commit();
+  TEST_EQUAL(storedValue("alpha").toInt(), 1);
+
+  return 0;
+}
+
+//-----------------------------------------------------------------------------
+int testAsynchronous(qtTest& t_obj)
+{
+  QSettings().clear();
+
+  TestSettings settings;
+  settings.setCommitMode(qtSettings::AsynchronousCommit);
+  settings.setCommitDelay(60000);
+
+  // Successive commits are merged, and nothing is written until the delay
+  // expires or the commit is waited for
+  settings.setValue("alpha", 1);
+  settings.commit();
+  settings.setValue("beta", QString("x"));
+  settings.commit();
+  settings.setValue("alpha", 2);
+  settings.commit();
+
+  TEST(!settings.hasUncommittedChanges());
+  TEST(settings.wasCommitted());
+  TEST_EQUAL(settings.value("alpha").toInt(), 2);
+  TEST(!storedValue("alpha").isValid());
+  TEST(!storedValue("beta").isValid());
+
+  settings.waitForCommit();
+  TEST_EQUAL(storedValue("alpha").toInt(), 2);
+  TEST_EQUAL(storedValue("beta").toString(), QString("x"));
+
+  // Committed values are written once the delay expires
+  settings.setCommitDelay(10);
+  settings.setValue("alpha", 3);
+  settings.commit();
+  TEST_EQUAL(storedValue("alpha").toInt(), 2);
+
+  QElapsedTimer timer;
+  timer.start();
+  while (storedValue("alpha").toInt() != 3 && timer.elapsed() < 10000)
+    {
+    QCoreApplication::processEvents();
+    QThread::msleep(5);
+    }
+  TEST_EQUAL(storedValue("alpha").toInt(), 3);
+
+  // Without a delay, values are written immediately (in the background)
+  settings.setCommitDelay(0);
+  settings.setValue("alpha", 4);
+  settings.commit();
+  settings.waitForCommit();
+  TEST_EQUAL(storedValue("alpha").toInt(), 4);
+
+  return 0;
+}
+
+//-----------------------------------------------------------------------------
+int testClear(qtTest& t_obj)
+{
+  QSettings().clear();
+
+  // Clearing drops values that have not yet been written
+  TestSettings settings;
+  settings.setCommitMode(qtSettings::AsynchronousCommit);
+  settings.setCommitDelay(60000);
+  settings.setValue("alpha", 5);
+  settings.commit();
+
+  settings.clear();
+  settings.waitForCommit();
+  TEST(!storedValue("alpha").isValid());
+  TEST(!settings.value("alpha").isValid());
+
+  return 0;
+}
+
+//-----------------------------------------------------------------------------
+int testModeSwitch(qtTest& t_obj)
+{
+  QSettings().clear();
+
+  TestSettings settings;
+  settings.setCommitMode(qtSettings::AsynchronousCommit);
+  settings.setCommitDelay(60000);
+  settings.setValue("alpha", 6);
+  settings.commit();
+  TEST(!storedValue("alpha").isValid());
+
+  // Switching to synchronous mode writes pending values...
+  settings.setCommitMode(qtSettings::SynchronousCommit);
+  TEST_EQUAL(settings.commitMode(), qtSettings::SynchronousCommit);
+  TEST_EQUAL(storedValue("alpha").toInt(), 6);
+
+  // ...and later commits are written immediately
+  settings.setValue("alpha", 7);
+  settings.commit();
+  TEST_EQUAL(storedValue("alpha").toInt(), 7);
+
+  return 0;
+}
+
+//-----------------------------------------------------------------------------
+int main(int argc, char* argv[])
+{
+  QCoreApplication app(argc, argv);
+  app.setOrganizationName("qtExtensions");
+  app.setApplicationName("testSettings");
+
+  // Keep the settings written by the tests out of the user's configuration
+  QTemporaryDir configDir;
+  QSettings::setPath(QSettings::NativeFormat, QSettings::UserScope,
+                     configDir.path());
+  QSettings::setPath(QSettings::IniFormat, QSettings::UserScope,
+                     configDir.path());
+
+  qtTest t_obj;
+
+  t_obj.runSuite("Synchronous Commit", testSynchronous);
+  t_obj.runSuite("Asynchronous Commit", testAsynchronous);
+  t_obj.runSuite("Clear", testClear);
+  t_obj.runSuite("Commit Mode Switch", testModeSwitch);
+  return t_obj.result();
+}
@@ -0,0 +1,336 @@
+// This file is part of qtExtensions, and is distributed under the
+// OSI-approved BSD 3-Clause License. See top-level LICENSE file or
+// https://github.com/Kitware/qtExtensions/blob/master/LICENSE for details.
+
+#define TEST_OBJECT_NAME t_obj
+
+#include <QApplication>
+#include <QElapsedTimer>
+#include <QLabel>
+#include <QProgressBar>
+#include <QRunnable>
+#include <QScopedPointer>
+#include <QThread>
+#include <QThreadPool>
+
+#include "../core/qtTest.h"
+
+#include "../util/qtStatusForwarder.h"
+#include "../util/qtStatusManager.h"
+
+//-----------------------------------------------------------------------------
+class PostTask : public QRunnable
+{
+public:
+  PostTask(const QVector<qtStatusSource>& sources, int updates)
+    : sources(sources), updates(updates) {}
+
+  virtual void run() QTE_OVERRIDE
+    {
+    for (int u = 1; u <= this->updates; ++u)
+      {
+      for (auto& source : this->sources)
+        {
+        source.postProgress(u, this->updates);
+        }
+      }
+    }
+
+protected:
+  QVector<qtStatusSource> sources;
+  const int updates;
+};
+
+//-----------------------------------------------------------------------------
+class Job : public qtStatusNotifier
+{
+public:
+  void progress(qreal value) { this->postStatus("working", value); }
+  void finish() { this->postStatus("done", true); }
+};
+
+//-----------------------------------------------------------------------------
+int testSenderOrder(qtTest& t_obj)
+{
+  qtStatusManager manager;
+  QLabel label;
+  manager.addStatusLabel(&label);
+
+  QObject a, b;
+  QScopedPointer<QObject> c(new QObject);
+  qtStatusSource sa(&a), sb(&b), sc(c.data());
+
+  manager.setStatusText(sa, "a");
+  manager.setStatusText(sb, "b");
+  TEST_EQUAL(label.text(), QString("b"));
+
+  // Updating an earlier sender makes it the most recent
+  manager.setStatusText(sa, "a2");
+  TEST_EQUAL(label.text(), QString("a2"));
+
+  // Clearing the most recent sender shows the previous one
+  manager.setStatusText(sa);
+  TEST_EQUAL(label.text(), QString("b"));
+
+  // Destroying the owner of the most recent sender removes its status
+  manager.setStatusText(sc, "c");
+  TEST_EQUAL(label.text(), QString("c"));
+  c.reset();
+  TEST_EQUAL(label.text(), QString("b"));
+
+  // Clearing the only sender clears the status
+  manager.setStatusText(sb);
+  TEST(label.text().isEmpty());
+
+  return 0;
+}
+
+//-----------------------------------------------------------------------------
+int testUpdateRate(qtTest& t_obj)
+{
+  qtStatusManager manager;
+  QLabel label;
+  QProgressBar progressBar;
+  manager.addStatusLabel(&label);
+  manager.addProgressBar(&progressBar);
+  manager.setUpdateRate(2);
+  TEST_EQUAL(manager.updateRate(), 2);
+
+  QObject a;
+  qtStatusSource sa(&a);
+
+  manager.setStatusText(sa, "first");
+  manager.flushUpdates();
+  TEST_EQUAL(label.text(), QString("first"));
+
+  // Further notifications within the update interval are deferred; only the
+  // latest is shown when the pending update is flushed
+  manager.setStatusText(sa, "second");
+  manager.setProgress(sa, true, 1, 10);
+  manager.setStatusText(sa, "third");
+  manager.setProgress(sa, true, 2, 10);
+  TEST_EQUAL(label.text(), QString("first"));
+  TEST(progressBar.isHidden());
+
+  manager.flushUpdates();
+  TEST_EQUAL(label.text(), QString("third"));
+  TEST(!progressBar.isHidden());
+  TEST_EQUAL(progressBar.value(), 2);
+
+  // Deferred updates are applied once the interval has elapsed
+  manager.setStatusText(sa, "fourth");
+  TEST_EQUAL(label.text(), QString("third"));
+
+  QElapsedTimer timer;
+  timer.start();
+  while (label.text() != "fourth" && timer.elapsed() < 10000)
+    {
+    QCoreApplication::processEvents();
+    QThread::msleep(5);
+    }
+  TEST_EQUAL(label.text(), QString("fourth"));
+
+  // Clearing the status is always applied, even when it follows other
+  // updates within the same interval
+  manager.setStatusText(sa, "fifth");
+  manager.setProgress(sa);
+  manager.setStatusText(sa);
+  manager.flushUpdates();
+  TEST(label.text().isEmpty());
+  TEST(progressBar.isHidden());
+
+  // Disabling rate limiting applies any pending update
+  manager.setStatusText(sa, "sixth");
+  manager.setUpdateRate(0);
+  TEST_EQUAL(label.text(), QString("sixth"));
+  manager.setStatusText(sa, "seventh");
+  TEST_EQUAL(label.text(), QString("seventh"));
+
+  return 0;
+}
+
+//-----------------------------------------------------------------------------
+int testAggregate(qtTest& t_obj)
+{
+  qtStatusManager manager;
+  QProgressBar progressBar;
+  manager.addProgressBar(&progressBar);
+  manager.setDisplayMode(qtStatusManager::ShowAggregate);
+
+  QObject a;
+  QScopedPointer<QObject> b(new QObject);
+  qtStatusSource sa(&a), sb(b.data());
+  manager.setSourceWeight(sb, 3.0);
+
+  // Progress is weighted
+  manager.setProgress(sa, true, 50, 100);
+  TEST_EQUAL(progressBar.maximum(), 10000);
+  TEST_EQUAL(progressBar.value(), 5000);
+  manager.setProgress(sb, true, 0, 100);
+  TEST_EQUAL(progressBar.value(), 1250);
+  manager.setProgress(sb, true, 100, 100);
+  TEST_EQUAL(progressBar.value(), 8750);
+
+  // Finished sources count as complete, so progress does not regress
+  manager.setProgress(sb);
+  TEST_EQUAL(progressBar.value(), 8750);
+  manager.setProgress(sa, true, 100, 100);
+  TEST_EQUAL(progressBar.value(), 10000);
+
+  // When nothing is in progress, the next job starts a new aggregation
+  manager.setProgress(sa);
+  TEST(progressBar.isHidden());
+  manager.setProgress(sa, true, 25, 100);
+  TEST(!progressBar.isHidden());
+  TEST_EQUAL(progressBar.value(), 2500);
+
+  // Indeterminate sources count towards the total weight
+  manager.setProgress(sb, true, -1.0);
+  TEST_EQUAL(progressBar.value(), 625);
+
+  // Changing a weight updates the progress
+  manager.setSourceWeight(sb, 1.0);
+  TEST_EQUAL(progressBar.value(), 1250);
+
+  // Destroying a source counts it as complete
+  b.reset();
+  TEST_EQUAL(progressBar.value(), 6250);
+
+  manager.setProgress(sa);
+  TEST(progressBar.isHidden());
+
+  return 0;
+}
+
+//-----------------------------------------------------------------------------
+int testForwarder(qtTest& t_obj)
+{
+  qtStatusManager manager;
+  QProgressBar progressBar;
+  manager.addProgressBar(&progressBar);
+
+  // Jobs 1 and 2 are combined by an inner forwarder, which is combined with
+  // job 3 (with three times the weight) by an outer forwarder
+  qtStatusForwarder inner, outer;
+  inner.setProgressMode(qtStatusForwarder::AggregateProgress);
+  outer.setProgressMode(qtStatusForwarder::AggregateProgress);
+  outer.addReceiver(&manager);
+
+  Job job1, job3;
+  QScopedPointer<Job> job2(new Job);
+  inner.connect(&job1);
+  inner.connect(job2.data());
+  outer.connect(&inner);
+  outer.connect(&job3, 3.0);
+
+  job1.progress(0.5);
+  TEST_EQUAL(progressBar.value(), 625);
+  job3.progress(0.5);
+  TEST_EQUAL(progressBar.value(), 4375);
+  job1.finish();
+  TEST_EQUAL(progressBar.value(), 5000);
+
+  // Removing a job that has not started leaves only finished jobs in the
+  // inner forwarder, which is then complete
+  job2.reset();
+  TEST_EQUAL(progressBar.value(), 6250);
+
+  // Progress is cleared once every job is complete, and then restarts
+  job3.finish();
+  TEST(progressBar.isHidden());
+  job3.progress(0.5);
+  TEST(!progressBar.isHidden());
+  TEST_EQUAL(progressBar.value(), 3750);
+
+  return 0;
+}
+
+//-----------------------------------------------------------------------------
+int testBenchmark(qtTest& t_obj)
+{
+  const int sourceCount = 4000;
+  const int taskCount = 8;
+  const int updates = 50;
+
+  qtStatusManager manager;
+  QLabel label;
+  QProgressBar progressBar;
+  manager.addStatusLabel(&label);
+  manager.addProgressBar(&progressBar);
+  manager.setUpdateRate(30);
+
+  QScopedPointer<QObject> root(new QObject);
+  QVector<qtStatusSource> sources;
+  for (int i = 0; i < sourceCount; ++i)
+    {
+    sources.append(qtStatusSource(new QObject(root.data())));
+    manager.watchSource(sources.last());
+    }
+
+  QElapsedTimer timer;
+
+  // Update every source in turn from this thread, so that each update moves
+  // a different source to the front
+  timer.start();
+  for (int u = 1; u <= updates; ++u)
+    {
+    foreach (auto const& source, sources)
+      {
+      manager.setProgress(source, true, u, updates);
+      }
+    }
+  manager.flushUpdates();
+  const qint64 directTime = timer.nsecsElapsed();
+
+  TEST_EQUAL(progressBar.value(), progressBar.maximum());
+
+  // Post progress for all sources concurrently from several threads
+  QThreadPool pool;
+  pool.setMaxThreadCount(taskCount);
+
+  timer.start();
+  const int slice = sourceCount / taskCount;
+  for (int t = 0; t < taskCount; ++t)
+    {
+    pool.start(new PostTask(sources.mid(t * slice, slice), updates));
+    }
+  while (!pool.waitForDone(1))
+    {
+    QCoreApplication::processEvents();
+    }
+  QCoreApplication::processEvents();
+  manager.flushUpdates();
+  const qint64 postTime = timer.nsecsElapsed();
+
+  TEST_EQUAL(progressBar.value(), progressBar.maximum());
+
+  // Destroy all the owners
+  timer.start();
+  root.reset();
+  manager.flushUpdates();
+  const qint64 cleanupTime = timer.nsecsElapsed();
+
+  TEST(progressBar.isHidden());
+
+  const qint64 count = static_cast<qint64>(sourceCount) * updates;
+  t_obj.out() << "  " << sourceCount << " sources: "
+              << (directTime / count) << " ns per direct update, "
+              << (postTime / count) << " ns per posted update, "
+              << (cleanupTime / sourceCount) << " ns per removal\n";
+
+  return 0;
+}
+
+//-----------------------------------------------------------------------------
+int main(int argc, char* argv[])
+{
+  QApplication app(argc, argv); // Needed to construct widgets
+  qtTest t_obj;
+
+  t_obj.runSuite("Sender Order", testSenderOrder);
+  t_obj.runSuite("Update Rate", testUpdateRate);
+  t_obj.runSuite("Aggregate Progress", testAggregate);
+  t_obj.runSuite("Forwarded Progress", testForwarder);
+  t_obj.runSuite("Benchmark", testBenchmark);
+  return t_obj.result();
+}
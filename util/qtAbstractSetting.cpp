@@ -49,6 +49,14 @@ void qtAbstractSetting::commit(QSettings& store)
   this->modified = false;
 }
 
+//-----------------------------------------------------------------------------
+void qtAbstractSetting::snapshot(QVariantHash& values)
+{
+  values.insert(this->key(), this->currentValue);
+  this->originalValue = this->currentValue;
+  this->modified = false;
+}
+
 //-----------------------------------------------------------------------------
 void qtAbstractSetting::discard()
 {
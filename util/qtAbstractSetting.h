@@ -29,6 +29,14 @@ protected:
   virtual void initialize(const QSettings& store);
   virtual QString key() const = 0;
 
+  /// Record the values to be written by an asynchronous commit.
+  ///
+  /// This is the counterpart of commit() that is used when the owning
+  /// qtSettings commits asynchronously. It adds the keys and values to be
+  /// written to \p values, and marks the setting as committed. Subclasses
+  /// that override commit() should also override this method.
+  virtual void snapshot(QVariantHash& values);
+
   QVariant originalValue;
   QVariant currentValue;
   bool modified;
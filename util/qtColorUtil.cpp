@@ -4,6 +4,289 @@
 
 #include "qtColorUtil.h"
 
+#include <algorithm>
+#include <cmath>
+
+namespace // anonymous
+{
+
+// The loops below are written without data-dependent branches (using
+// selects) and over plain arrays, so that the compiler can vectorize them
+
+//-----------------------------------------------------------------------------
+inline float clampUnit(float x)
+{
+  return std::min(std::max(x, 0.0f), 1.0f);
+}
+
+//-----------------------------------------------------------------------------
+inline float hue(float r, float g, float b, float max, float delta)
+{
+  const float d = (delta > 0.0f ? delta : 1.0f);
+  const float h = (max == r ? (g - b) / d :
+                   max == g ? 2.0f + ((b - r) / d) :
+                              4.0f + ((r - g) / d)) / 6.0f;
+  return (delta > 0.0f ? (h < 0.0f ? h + 1.0f : h) : -1.0f);
+}
+
+//-----------------------------------------------------------------------------
+// Achromatic colors have no hue (it is -1, as with QColor); when blending,
+// they take the hue of the neighboring color, so that blending with a gray
+// does not shift the hue of the other color
+template <typename T>
+inline T chromaticHue(T hue, T fallback)
+{
+  return (hue < T(0) ? fallback : hue);
+}
+
+//-----------------------------------------------------------------------------
+inline float hermite(float p0, float p1, float p2, float p3, float t)
+{
+  // Cubic Hermite interpolation, as in the scalar blend
+  const float t2 = t * t;
+  const float t3 = t2 * t;
+
+  const float m0 = (p2 - p0) * 0.5f;
+  const float m1 = (p3 - p1) * 0.5f;
+  const float a0 =  2 * t3  +  -3 * t2  + 1;
+  const float a1 =  1 * t3  +  -2 * t2  + t;
+  const float a2 =  1 * t3  +  -1 * t2;
+  const float a3 = -2 * t3  +   3 * t2;
+
+  return (a0 * p1) + (a1 * m0) + (a2 * m1) + (a3 * p2);
+}
+
+//-----------------------------------------------------------------------------
+int channelCount(QColor::Spec spec)
+{
+  return (spec == QColor::Cmyk ? 4 : 3);
+}
+
+//-----------------------------------------------------------------------------
+bool hasHue(QColor::Spec spec)
+{
+  return (spec == QColor::Hsv || spec == QColor::Hsl);
+}
+
+//-----------------------------------------------------------------------------
+// Test if an array has the given color space and count, and channels of that
+// count
+bool hasLayout(const qtColorUtil::ColorArray& a, QColor::Spec spec, int count)
+{
+  if (a.spec != spec || a.alpha.count() != count)
+    {
+    return false;
+    }
+
+  const int n = channelCount(spec);
+  for (int k = 0; k < n; ++k)
+    {
+    if (a.channels[k].count() != count)
+      {
+      return false;
+      }
+    }
+
+  return true;
+}
+
+//-----------------------------------------------------------------------------
+qreal blendHue(qreal a, qreal b, qreal t)
+{
+  // The result is achromatic only if both colors are
+  const qreal ha = chromaticHue(a, b);
+  const qreal hb = chromaticHue(b, a);
+  return (ha < 0.0 ? -1.0
+                   : qBound(0.0, qtColorUtil::blend(ha, hb, t), 1.0));
+}
+
+//-----------------------------------------------------------------------------
+qreal blendHue(qreal a, qreal b, qreal c, qreal d, qreal t)
+{
+  // The result is achromatic only if both of the colors being interpolated
+  // between are; the outer colors take the hue of their inner neighbors
+  const qreal hb = chromaticHue(b, c);
+  const qreal hc = chromaticHue(c, hb);
+  const qreal ha = chromaticHue(a, hb);
+  const qreal hd = chromaticHue(d, hc);
+  return (hc < 0.0 ? -1.0
+                   : qBound(0.0, qtColorUtil::blend(ha, hb, hc, hd, t), 1.0));
+}
+
+//-----------------------------------------------------------------------------
+void rgbToHsv(const float* r, const float* g, const float* b,
+              float* h, float* s, float* v, int count)
+{
+  for (int i = 0; i < count; ++i)
+    {
+    const float max = std::max(r[i], std::max(g[i], b[i]));
+    const float min = std::min(r[i], std::min(g[i], b[i]));
+    const float delta = max - min;
+    h[i] = hue(r[i], g[i], b[i], max, delta);
+    s[i] = (max > 0.0f ? delta / (max > 0.0f ? max : 1.0f) : 0.0f);
+    v[i] = max;
+    }
+}
+
+//-----------------------------------------------------------------------------
+void hsvToRgb(const float* h, const float* s, const float* v,
+              float* r, float* g, float* b, int count)
+{
+  for (int i = 0; i < count; ++i)
+    {
+    // Channel n is v - (s * v * clamp(min(k, 4 - k))), with k = (n + 6h)
+    // mod 6; achromatic colors (negative hue) are gray
+    const float h6 = clampUnit(h[i]) * 6.0f;
+    const float sv = (h[i] < 0.0f ? 0.0f : clampUnit(s[i])) * v[i];
+    const auto channel = [h6, sv, v, i](float n) {
+      const float x = n + h6;
+      const float k = (x >= 6.0f ? x - 6.0f : x);
+      return v[i] - (sv * clampUnit(std::min(k, 4.0f - k)));
+    };
+    r[i] = channel(5.0f);
+    g[i] = channel(3.0f);
+    b[i] = channel(1.0f);
+    }
+}
+
+//-----------------------------------------------------------------------------
+void rgbToHsl(const float* r, const float* g, const float* b,
+              float* h, float* s, float* l, int count)
+{
+  for (int i = 0; i < count; ++i)
+    {
+    const float max = std::max(r[i], std::max(g[i], b[i]));
+    const float min = std::min(r[i], std::min(g[i], b[i]));
+    const float delta = max - min;
+    const float lightness = 0.5f * (max + min);
+    const float d = 1.0f - std::fabs((2.0f * lightness) - 1.0f);
+    h[i] = hue(r[i], g[i], b[i], max, delta);
+    s[i] = (delta > 0.0f && d > 0.0f ? delta / (d > 0.0f ? d : 1.0f) : 0.0f);
+    l[i] = lightness;
+    }
+}
+
+//-----------------------------------------------------------------------------
+void hslToRgb(const float* h, const float* s, const float* l,
+              float* r, float* g, float* b, int count)
+{
+  for (int i = 0; i < count; ++i)
+    {
+    // Channel n is l - (a * clamp(min(k - 3, 9 - k), -1, 1)), with
+    // a = s * min(l, 1 - l) and k = (n + 12h) mod 12
+    const float h12 = clampUnit(h[i]) * 12.0f;
+    const float sat = (h[i] < 0.0f ? 0.0f : clampUnit(s[i]));
+    const float a = sat * std::min(l[i], 1.0f - l[i]);
+    const auto channel = [h12, a, l, i](float n) {
+      const float x = n + h12;
+      const float k = (x >= 12.0f ? x - 12.0f : x);
+      const float f = std::min(std::min(k - 3.0f, 9.0f - k), 1.0f);
+      return l[i] - (a * std::max(f, -1.0f));
+    };
+    r[i] = channel(0.0f);
+    g[i] = channel(8.0f);
+    b[i] = channel(4.0f);
+    }
+}
+
+//-----------------------------------------------------------------------------
+void rgbToCmyk(const float* r, const float* g, const float* b,
+               float* c, float* m, float* y, float* k, int count)
+{
+  for (int i = 0; i < count; ++i)
+    {
+    const float max = std::max(r[i], std::max(g[i], b[i]));
+    const float d = (max > 0.0f ? max : 1.0f);
+    c[i] = (max > 0.0f ? (max - r[i]) / d : 0.0f);
+    m[i] = (max > 0.0f ? (max - g[i]) / d : 0.0f);
+    y[i] = (max > 0.0f ? (max - b[i]) / d : 0.0f);
+    k[i] = 1.0f - max;
+    }
+}
+
+//-----------------------------------------------------------------------------
+void cmykToRgb(const float* c, const float* m, const float* y, const float* k,
+               float* r, float* g, float* b, int count)
+{
+  for (int i = 0; i < count; ++i)
+    {
+    const float w = 1.0f - k[i];
+    r[i] = (1.0f - c[i]) * w;
+    g[i] = (1.0f - m[i]) * w;
+    b[i] = (1.0f - y[i]) * w;
+    }
+}
+
+//-----------------------------------------------------------------------------
+void toRgb(const qtColorUtil::ColorArray& in, qtColorUtil::ColorArray& rgb)
+{
+  const int count = in.count();
+  rgb.spec = QColor::Rgb;
+  rgb.resize(count);
+  rgb.alpha = in.alpha;
+
+  const float* const c0 = in.channels[0].constData();
+  const float* const c1 = in.channels[1].constData();
+  const float* const c2 = in.channels[2].constData();
+  float* const r = rgb.channels[0].data();
+  float* const g = rgb.channels[1].data();
+  float* const b = rgb.channels[2].data();
+
+  switch (in.spec)
+    {
+    case QColor::Hsv:
+      hsvToRgb(c0, c1, c2, r, g, b, count);
+      break;
+    case QColor::Hsl:
+      hslToRgb(c0, c1, c2, r, g, b, count);
+      break;
+    case QColor::Cmyk:
+      cmykToRgb(c0, c1, c2, in.channels[3].constData(), r, g, b, count);
+      break;
+    default: // RGB
+      std::copy(c0, c0 + count, r);
+      std::copy(c1, c1 + count, g);
+      std::copy(c2, c2 + count, b);
+      break;
+    }
+}
+
+//-----------------------------------------------------------------------------
+void fromRgb(const qtColorUtil::ColorArray& rgb, qtColorUtil::ColorArray& out)
+{
+  const int count = rgb.count();
+  out.resize(count);
+  out.alpha = rgb.alpha;
+
+  const float* const r = rgb.channels[0].constData();
+  const float* const g = rgb.channels[1].constData();
+  const float* const b = rgb.channels[2].constData();
+  float* const c0 = out.channels[0].data();
+  float* const c1 = out.channels[1].data();
+  float* const c2 = out.channels[2].data();
+
+  switch (out.spec)
+    {
+    case QColor::Hsv:
+      rgbToHsv(r, g, b, c0, c1, c2, count);
+      break;
+    case QColor::Hsl:
+      rgbToHsl(r, g, b, c0, c1, c2, count);
+      break;
+    case QColor::Cmyk:
+      rgbToCmyk(r, g, b, c0, c1, c2, out.channels[3].data(), count);
+      break;
+    default: // RGB
+      out.spec = QColor::Rgb;
+      std::copy(r, r + count, c0);
+      std::copy(g, g + count, c1);
+      std::copy(b, b + count, c2);
+      break;
+    }
+}
+
+} // namespace <anonymous>
+
 namespace qtColorUtil
 {
 
@@ -30,50 +313,56 @@ qreal blend(qreal p0, qreal p1, qreal p2, qreal p3, qreal t)
 }
 
 //-----------------------------------------------------------------------------
-QColor blend(const QColor& a, const QColor& b, qreal t, QColor::Spec s)
+#define BLEND2(_c) qBound(0.0, blend(a._c##F(), b._c##F(), t), 1.0)
+#define BLEND2_HUE(_c) blendHue(a._c##F(), b._c##F(), t)
+QColor blend(const QColor& ia, const QColor& ib, qreal t, QColor::Spec s)
 {
+  // Convert inputs once, so that the component accessors do not each perform
+  // a conversion; results are clamped, as rounding error could otherwise put
+  // them (slightly) out of range
+  const QColor::Spec cs = (s == QColor::Invalid ? QColor::Rgb : s);
+  const QColor a = ia.convertTo(cs);
+  const QColor b = ib.convertTo(cs);
   QColor result;
 
   switch (s)
     {
     case QColor::Cmyk:
       result.setCmykF(
-        blend(a.cyanF(),    b.cyanF(),    t),
-        blend(a.magentaF(), b.magentaF(), t),
-        blend(a.yellowF(),  b.yellowF(),  t),
-        blend(a.blackF(),   b.blackF(),   t));
+        BLEND2(cyan), BLEND2(magenta), BLEND2(yellow), BLEND2(black));
       break;
     case QColor::Hsv:
       result.setHsvF(
-        blend(a.hsvHueF(),        b.hsvHueF(),        t),
-        blend(a.hsvSaturationF(), b.hsvSaturationF(), t),
-        blend(a.valueF(),         b.valueF(),         t));
+        BLEND2_HUE(hsvHue), BLEND2(hsvSaturation), BLEND2(value));
       break;
     case QColor::Hsl:
       result.setHslF(
-        blend(a.hslHueF(),        b.hslHueF(),        t),
-        blend(a.hslSaturationF(), b.hslSaturationF(), t),
-        blend(a.lightnessF(),     b.lightnessF(),     t));
+        BLEND2_HUE(hslHue), BLEND2(hslSaturation), BLEND2(lightness));
       break;
     default: // RGB
-      result.setRgbF(
-        blend(a.redF(),   b.redF(),   t),
-        blend(a.greenF(), b.greenF(), t),
-        blend(a.blueF(),  b.blueF(),  t));
+      result.setRgbF(BLEND2(red), BLEND2(green), BLEND2(blue));
       break;
     }
 
   // Blend alpha and return result
-  result.setAlphaF(blend(a.alphaF(), b.alphaF(), t));
+  result.setAlphaF(BLEND2(alpha));
   return result;
 }
 
 //-----------------------------------------------------------------------------
 #define BLEND4(_c) \
   qBound(0.0, blend(a._c##F(), b._c##F(), c._c##F(), d._c##F(), t), 1.0)
-QColor blend(const QColor& a, const QColor& b, const QColor& c,
-             const QColor& d, qreal t, QColor::Spec s)
+#define BLEND4_HUE(_c) \
+  blendHue(a._c##F(), b._c##F(), c._c##F(), d._c##F(), t)
+QColor blend(const QColor& ia, const QColor& ib, const QColor& ic,
+             const QColor& id, qreal t, QColor::Spec s)
 {
+  // Convert inputs once (see above)
+  const QColor::Spec cs = (s == QColor::Invalid ? QColor::Rgb : s);
+  const QColor a = ia.convertTo(cs);
+  const QColor b = ib.convertTo(cs);
+  const QColor c = ic.convertTo(cs);
+  const QColor d = id.convertTo(cs);
   QColor result;
 
   switch (s)
@@ -84,11 +373,11 @@ QColor blend(const QColor& a, const QColor& b, const QColor& c,
       break;
     case QColor::Hsv:
       result.setHsvF(
-        BLEND4(hsvHue), BLEND4(hsvSaturation), BLEND4(value));
+        BLEND4_HUE(hsvHue), BLEND4(hsvSaturation), BLEND4(value));
       break;
     case QColor::Hsl:
       result.setHslF(
-        BLEND4(hslHue), BLEND4(hslSaturation), BLEND4(lightness));
+        BLEND4_HUE(hslHue), BLEND4(hslSaturation), BLEND4(lightness));
       break;
     default: // RGB
       result.setRgbF(BLEND4(red), BLEND4(green), BLEND4(blue));
@@ -100,4 +389,237 @@ QColor blend(const QColor& a, const QColor& b, const QColor& c,
   return result;
 }
 
+//-----------------------------------------------------------------------------
+ColorArray::ColorArray(QColor::Spec spec, int count) : spec(spec)
+{
+  this->resize(count);
+}
+
+//-----------------------------------------------------------------------------
+void ColorArray::resize(int count)
+{
+  const int n = channelCount(this->spec);
+  for (int k = 0; k < 4; ++k)
+    {
+    this->channels[k].resize(k < n ? count : 0);
+    }
+  this->alpha.resize(count);
+}
+
+//-----------------------------------------------------------------------------
+void convert(const QColor* in, int count, ColorArray& out)
+{
+  ColorArray rgb(QColor::Rgb, count);
+  float* const r = rgb.channels[0].data();
+  float* const g = rgb.channels[1].data();
+  float* const b = rgb.channels[2].data();
+  float* const a = rgb.alpha.data();
+
+  for (int i = 0; i < count; ++i)
+    {
+    qreal cr, cg, cb, ca;
+    in[i].getRgbF(&cr, &cg, &cb, &ca);
+    r[i] = static_cast<float>(cr);
+    g[i] = static_cast<float>(cg);
+    b[i] = static_cast<float>(cb);
+    a[i] = static_cast<float>(ca);
+    }
+
+  fromRgb(rgb, out);
+}
+
+//-----------------------------------------------------------------------------
+void convert(const QRgb* in, int count, ColorArray& out)
+{
+  ColorArray rgb(QColor::Rgb, count);
+  float* const r = rgb.channels[0].data();
+  float* const g = rgb.channels[1].data();
+  float* const b = rgb.channels[2].data();
+  float* const a = rgb.alpha.data();
+
+  const float k = 1.0f / 255.0f;
+  for (int i = 0; i < count; ++i)
+    {
+    r[i] = static_cast<float>(qRed(in[i])) * k;
+    g[i] = static_cast<float>(qGreen(in[i])) * k;
+    b[i] = static_cast<float>(qBlue(in[i])) * k;
+    a[i] = static_cast<float>(qAlpha(in[i])) * k;
+    }
+
+  fromRgb(rgb, out);
+}
+
+//-----------------------------------------------------------------------------
+void convert(const ColorArray& in, ColorArray& out)
+{
+  if (in.spec == out.spec)
+    {
+    out = in;
+    return;
+    }
+
+  ColorArray rgb;
+  toRgb(in, rgb);
+  fromRgb(rgb, out);
+}
+
+//-----------------------------------------------------------------------------
+void convert(const ColorArray& in, QColor* out)
+{
+  // Components are set in the array's color space, so no conversion is
+  // performed
+  const int count = in.count();
+  const float* const c0 = in.channels[0].constData();
+  const float* const c1 = in.channels[1].constData();
+  const float* const c2 = in.channels[2].constData();
+  const float* const c3 = in.channels[3].constData();
+  const float* const a = in.alpha.constData();
+
+  for (int i = 0; i < count; ++i)
+    {
+    const float h = (c0[i] < 0.0f ? -1.0f : clampUnit(c0[i]));
+    switch (in.spec)
+      {
+      case QColor::Hsv:
+        out[i].setHsvF(h, clampUnit(c1[i]), clampUnit(c2[i]),
+                       clampUnit(a[i]));
+        break;
+      case QColor::Hsl:
+        out[i].setHslF(h, clampUnit(c1[i]), clampUnit(c2[i]),
+                       clampUnit(a[i]));
+        break;
+      case QColor::Cmyk:
+        out[i].setCmykF(clampUnit(c0[i]), clampUnit(c1[i]), clampUnit(c2[i]),
+                        clampUnit(c3[i]), clampUnit(a[i]));
+        break;
+      default: // RGB
+        out[i].setRgbF(clampUnit(c0[i]), clampUnit(c1[i]), clampUnit(c2[i]),
+                       clampUnit(a[i]));
+        break;
+      }
+    }
+}
+
+//-----------------------------------------------------------------------------
+void convert(const ColorArray& in, QRgb* out)
+{
+  ColorArray rgb;
+  toRgb(in, rgb);
+
+  const int count = rgb.count();
+  const float* const r = rgb.channels[0].constData();
+  const float* const g = rgb.channels[1].constData();
+  const float* const b = rgb.channels[2].constData();
+  const float* const a = rgb.alpha.constData();
+
+  const auto pack = [](float x) {
+    return static_cast<int>((clampUnit(x) * 255.0f) + 0.5f);
+  };
+  for (int i = 0; i < count; ++i)
+    {
+    out[i] = qRgba(pack(r[i]), pack(g[i]), pack(b[i]), pack(a[i]));
+    }
+}
+
+//-----------------------------------------------------------------------------
+bool blend(const ColorArray& a, const ColorArray& b,
+           const float* t, ColorArray& out)
+{
+  const int count = a.count();
+  out.spec = a.spec;
+
+  if (!hasLayout(a, a.spec, count) || !hasLayout(b, a.spec, count))
+    {
+    out.resize(0);
+    return false;
+    }
+
+  const int n = channelCount(a.spec);
+  out.resize(count);
+
+  for (int k = 0; k <= n; ++k)
+    {
+    // The last pass blends alpha
+    const QVector<float>& ca = (k < n ? a.channels[k] : a.alpha);
+    const QVector<float>& cb = (k < n ? b.channels[k] : b.alpha);
+    QVector<float>& co = (k < n ? out.channels[k] : out.alpha);
+
+    const float* const pa = ca.constData();
+    const float* const pb = cb.constData();
+    float* const po = co.data();
+    if (k == 0 && hasHue(a.spec))
+      {
+      // The result is achromatic only if both colors are
+      for (int i = 0; i < count; ++i)
+        {
+        const float ha = chromaticHue(pa[i], pb[i]);
+        const float hb = chromaticHue(pb[i], pa[i]);
+        const float h = clampUnit((ha * (1.0f - t[i])) + (hb * t[i]));
+        po[i] = (ha < 0.0f ? -1.0f : h);
+        }
+      continue;
+      }
+
+    for (int i = 0; i < count; ++i)
+      {
+      po[i] = clampUnit((pa[i] * (1.0f - t[i])) + (pb[i] * t[i]));
+      }
+    }
+
+  return true;
+}
+
+//-----------------------------------------------------------------------------
+bool blend(const ColorArray& a, const ColorArray& b,
+           const ColorArray& c, const ColorArray& d,
+           const float* t, ColorArray& out)
+{
+  const int count = a.count();
+  out.spec = a.spec;
+
+  if (!hasLayout(a, a.spec, count) || !hasLayout(b, a.spec, count) ||
+      !hasLayout(c, a.spec, count) || !hasLayout(d, a.spec, count))
+    {
+    out.resize(0);
+    return false;
+    }
+
+  const int n = channelCount(a.spec);
+  out.resize(count);
+
+  for (int k = 0; k <= n; ++k)
+    {
+    // The last pass blends alpha
+    const float* const p0 = (k < n ? a.channels[k] : a.alpha).constData();
+    const float* const p1 = (k < n ? b.channels[k] : b.alpha).constData();
+    const float* const p2 = (k < n ? c.channels[k] : c.alpha).constData();
+    const float* const p3 = (k < n ? d.channels[k] : d.alpha).constData();
+    float* const po = (k < n ? out.channels[k] : out.alpha).data();
+
+    if (k == 0 && hasHue(a.spec))
+      {
+      // The result is achromatic only if both of the colors being
+      // interpolated between are; the outer colors take the hue of their
+      // inner neighbors
+      for (int i = 0; i < count; ++i)
+        {
+        const float h1 = chromaticHue(p1[i], p2[i]);
+        const float h2 = chromaticHue(p2[i], h1);
+        const float h0 = chromaticHue(p0[i], h1);
+        const float h3 = chromaticHue(p3[i], h2);
+        const float h = clampUnit(hermite(h0, h1, h2, h3, t[i]));
+        po[i] = (h2 < 0.0f ? -1.0f : h);
+        }
+      continue;
+      }
+
+    for (int i = 0; i < count; ++i)
+      {
+      po[i] = clampUnit(hermite(p0[i], p1[i], p2[i], p3[i], t[i]));
+      }
+    }
+
+  return true;
+}
+
 } // namespace qtColorUtil
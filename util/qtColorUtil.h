@@ -6,6 +6,7 @@
 #define __qtColorUtil_h
 
 #include <QColor>
+#include <QVector>
 
 #include "../core/qtGlobal.h"
 
@@ -13,11 +14,51 @@ namespace qtColorUtil
 {
   QTE_EXPORT qreal blend(qreal a, qreal b, qreal t);
   QTE_EXPORT qreal blend(qreal a, qreal b, qreal c, qreal d, qreal t);
+
+  // Blend colors linearly, or by cubic interpolation between b and c, in the
+  // given color space; achromatic colors (which have no hue) take the hue of
+  // the color they are blended with
   QTE_EXPORT QColor blend(const QColor& a, const QColor& b,
                           qreal t, QColor::Spec s = QColor::Rgb);
   QTE_EXPORT QColor blend(const QColor& a, const QColor& b,
                           const QColor& c, const QColor& d,
                           qreal t, QColor::Spec s = QColor::Rgb);
+
+  // Colors in structure-of-arrays layout, for converting and blending many
+  // colors at once. The channels hold the components of the array's color
+  // space, in the order and range of the QColor accessors (e.g. hsvHueF(),
+  // hsvSaturationF(), valueF()); the fourth channel is used only by CMYK.
+  // Hue is -1 for achromatic colors, as with QColor.
+  struct QTE_EXPORT ColorArray
+  {
+    explicit ColorArray(QColor::Spec spec = QColor::Rgb, int count = 0);
+
+    int count() const { return this->alpha.count(); }
+    void resize(int count);
+
+    QColor::Spec spec;
+    QVector<float> channels[4];
+    QVector<float> alpha;
+  };
+
+  // Convert colors to or from arrays, or between color spaces; when
+  // converting to an array, the output array's color space is used (the Rgb,
+  // Hsv, Hsl and Cmyk color spaces are supported)
+  QTE_EXPORT void convert(const QColor* in, int count, ColorArray& out);
+  QTE_EXPORT void convert(const QRgb* in, int count, ColorArray& out);
+  QTE_EXPORT void convert(const ColorArray& in, ColorArray& out);
+  QTE_EXPORT void convert(const ColorArray& in, QColor* out);
+  QTE_EXPORT void convert(const ColorArray& in, QRgb* out);
+
+  // Blend arrays of colors element-wise, using the blend parameters in t, as
+  // with the scalar blends; the inputs must have the same color space and
+  // count (and channels of that count), otherwise the output is emptied and
+  // false is returned
+  QTE_EXPORT bool blend(const ColorArray& a, const ColorArray& b,
+                        const float* t, ColorArray& out);
+  QTE_EXPORT bool blend(const ColorArray& a, const ColorArray& b,
+                        const ColorArray& c, const ColorArray& d,
+                        const float* t, ColorArray& out);
 }
 
 #endif
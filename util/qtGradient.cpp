@@ -4,7 +4,14 @@
 
 #include "qtGradient.h"
 
+#include <QImage>
+#include <QRunnable>
 #include <QSharedData>
+#include <QThread>
+#include <QThreadPool>
+
+#include <algorithm>
+#include <cstring>
 
 #include "../core/qtIndexRange.h"
 #include "../core/qtMath.h"
@@ -13,26 +20,145 @@
 
 QTE_IMPLEMENT_D_FUNC_SHARED(qtGradient)
 
+namespace // anonymous
+{
+
+// Size of lookup table used when mapping values without an explicit table
+const int defaultLutSize = 1024;
+
+// Number of values processed per pass when mapping arrays; indices for a
+// block are computed in one pass (which the compiler can vectorize), and the
+// table is then read in a second pass
+const int mapBlockSize = 256;
+
+// Minimum number of pixels for which image rendering is split across threads
+const int parallelRenderSize = 1 << 20;
+
+//-----------------------------------------------------------------------------
+QRgb composite(QRgb fg, QRgb bg)
+{
+    auto const a = qAlpha(fg);
+    auto const blend = [a](int f, int b) {
+        return ((f * a) + (b * (255 - a)) + 127) / 255;
+    };
+    return qRgb(blend(qRed(fg), qRed(bg)),
+                blend(qGreen(fg), qGreen(bg)),
+                blend(qBlue(fg), qBlue(bg)));
+}
+
+//-----------------------------------------------------------------------------
+template <typename Function>
+class FunctionTask : public QRunnable
+{
+public:
+    explicit FunctionTask(Function f) : function(f) {}
+    virtual void run() QTE_OVERRIDE { this->function(); }
+
+protected:
+    Function function;
+};
+
+//-----------------------------------------------------------------------------
+template <typename Function>
+QRunnable* makeTask(Function f)
+{
+    return new FunctionTask<Function>(f);
+}
+
+} // namespace <anonymous>
+
 //BEGIN qtGradientData
 
 //-----------------------------------------------------------------------------
 class qtGradientData : public QSharedData
 {
 public:
-    QMap<qreal, qtGradient::Stop> stops;
+    // Interpolation coefficients of the span between two adjacent stops,
+    // cached when the stops or interpolation mode change; colors are stored
+    // converted to the blend space
+    struct Segment
+    {
+        qreal lower, upper, weight;
+        QColor lowerColor, upperColor;
+
+        // Intermediary control points used by cubic interpolation
+        qreal outerLower, mid, outerUpper;
+        QColor outerLowerColor, midColor, outerUpperColor;
+    };
+
+    QVector<qtGradient::Stop> stops; // sorted by position
+    QVector<Segment> segments;
+    QColor::Spec space;
     qtGradient::InterpolationMode interpolateMode;
     qtGradient::Spread spread;
 
+    static void insertStop(QVector<qtGradient::Stop>& stops,
+                           qtGradient::Stop const& stop);
+    void updateSegments();
+
     QColor blend(QColor const& a, QColor const& b, qreal t) const;
     QColor linearBlend(QColor const& a, QColor const& b,
                        qreal t, qreal w) const;
-    QColor cubicBlend(qtGradient::Stop const& a, qtGradient::Stop const& b,
-                      qtGradient::Stop const& c, qtGradient::Stop const& d,
-                      qreal t) const;
+    QColor cubicBlend(Segment const& s, qreal t) const;
 
     QColor::Spec blendSpace() const;
+    qreal applySpread(qreal pos) const;
+
+    QColor colorAt(qreal pos) const;
+    QColor colorAt(qreal pos, int& segment) const;
+    QColor segmentColorAt(int segment, qreal pos) const;
 };
 
+//-----------------------------------------------------------------------------
+void qtGradientData::insertStop(
+    QVector<qtGradient::Stop>& stops, qtGradient::Stop const& stop)
+{
+    // Insert the stop in order, replacing any stop at the same position
+    auto const iter = std::lower_bound(
+        stops.begin(), stops.end(), stop.position,
+        [](qtGradient::Stop const& s, qreal p){ return s.position < p; });
+
+    if (iter != stops.end() && iter->position == stop.position)
+        *iter = stop;
+    else
+        stops.insert(iter, stop);
+}
+
+//-----------------------------------------------------------------------------
+void qtGradientData::updateSegments()
+{
+    this->space = this->blendSpace();
+
+    auto const n = this->stops.count();
+    this->segments.resize(qMax(0, n - 1));
+
+    for (int i = 0; i < n - 1; ++i)
+    {
+        // Get the stops bounding the segment, and their outer neighbors (or
+        // the bounding stops themselves, at the ends of the gradient)
+        auto const& a = this->stops[qMax(0, i - 1)];
+        auto const& b = this->stops[i];
+        auto const& c = this->stops[i + 1];
+        auto const& d = this->stops[qMin(n - 1, i + 2)];
+
+        auto& segment = this->segments[i];
+        segment.lower = b.position;
+        segment.upper = c.position;
+        segment.weight = b.weight;
+        segment.lowerColor = b.color.convertTo(this->space);
+        segment.upperColor = c.color.convertTo(this->space);
+
+        segment.outerLower =
+            qtColorUtil::blend(a.position, b.position, a.weight);
+        segment.outerUpper =
+            qtColorUtil::blend(d.position, c.position, c.weight);
+        segment.mid = qtColorUtil::blend(b.position, c.position, b.weight);
+        segment.outerLowerColor = this->blend(a.color, b.color, 0.5);
+        segment.outerUpperColor = this->blend(d.color, c.color, 0.5);
+        segment.midColor = this->blend(b.color, c.color, 0.5);
+    }
+}
+
 //-----------------------------------------------------------------------------
 QColor::Spec qtGradientData::blendSpace() const
 {
@@ -49,10 +175,28 @@ QColor::Spec qtGradientData::blendSpace() const
     }
 }
 
+//-----------------------------------------------------------------------------
+qreal qtGradientData::applySpread(qreal pos) const
+{
+    switch (this->spread)
+    {
+        case QGradient::RepeatSpread:
+            pos = fmod(pos, 1.0);
+            (pos < 0.0) && (pos = 1.0 + pos);
+            return pos;
+        case QGradient::ReflectSpread:
+            pos = fabs(fmod(pos, 2.0));
+            (pos > 1.0) && (pos = 2.0 - pos);
+            return pos;
+        default:
+            return qBound(0.0, pos, 1.0);
+    }
+}
+
 //-----------------------------------------------------------------------------
 QColor qtGradientData::blend(QColor const& a, QColor const& b, qreal t) const
 {
-    return qtColorUtil::blend(a, b, t, blendSpace());
+    return qtColorUtil::blend(a, b, t, this->space);
 }
 
 //-----------------------------------------------------------------------------
@@ -68,34 +212,96 @@ QColor qtGradientData::linearBlend(
 }
 
 //-----------------------------------------------------------------------------
-QColor qtGradientData::cubicBlend(
-    qtGradient::Stop const& a, qtGradient::Stop const& b,
-    qtGradient::Stop const& c, qtGradient::Stop const& d, qreal t) const
+QColor qtGradientData::cubicBlend(Segment const& s, qreal t) const
 {
-    // Calculate intermediary stops
-    auto const& cb = b.color, cc = c.color;
-    auto const& ca = blend(a.color, cb, 0.5);
-    auto const& cd = blend(d.color, cc, 0.5);
-    auto const& cm = blend(cb, cc, 0.5);
-    auto const w = b.weight;
-    auto const pb = b.position, pc = c.position;
-    auto const pa = qtColorUtil::blend(a.position, pb, a.weight);
-    auto const pd = qtColorUtil::blend(d.position, pc, c.weight);
-    auto const pm = qtColorUtil::blend(pb, pc, w);
+    auto const w = s.weight;
 
     if (t > w)
     {
         t = (t - w) / (1.0 - w);
-        t = qtColorUtil::blend(pb, pm, pc, pd, t);
-        t = qBound(0.0, (t - pm) / (pc - pm), 1.0);
-        return qtColorUtil::blend(cb, cm, cc, cd, t, blendSpace());
+        t = qtColorUtil::blend(s.lower, s.mid, s.upper, s.outerUpper, t);
+        t = qBound(0.0, (t - s.mid) / (s.upper - s.mid), 1.0);
+        return qtColorUtil::blend(s.lowerColor, s.midColor, s.upperColor,
+                                  s.outerUpperColor, t, this->space);
     }
     else
     {
         t /= w;
-        t = qtColorUtil::blend(pa, pb, pm, pc, t);
-        t = qBound(0.0, (t - pb) / (pm - pb), 1.0);
-        return qtColorUtil::blend(ca, cb, cm, cc, t, blendSpace());
+        t = qtColorUtil::blend(s.outerLower, s.lower, s.mid, s.upper, t);
+        t = qBound(0.0, (t - s.lower) / (s.mid - s.lower), 1.0);
+        return qtColorUtil::blend(s.outerLowerColor, s.lowerColor,
+                                  s.midColor, s.upperColor, t, this->space);
+    }
+}
+
+//-----------------------------------------------------------------------------
+QColor qtGradientData::colorAt(qreal pos) const
+{
+    auto segment = -1;
+    return this->colorAt(pos, segment);
+}
+
+//-----------------------------------------------------------------------------
+QColor qtGradientData::colorAt(qreal pos, int& segment) const
+{
+    auto const n = this->stops.count();
+    if (n < 1)
+        return Qt::transparent;
+
+    // Positions outside the span of the stops take the nearest stop's color
+    auto const* const first = this->stops.constData();
+    auto const* const last = first + (n - 1);
+    if (!(pos > first->position))
+        return first->color;
+    if (pos > last->position)
+        return last->color;
+
+    // Find the segment containing the position; if the given segment precedes
+    // the position (as when sampling in increasing order), walk forward from
+    // there, otherwise search
+    if (segment < 0 || segment >= n - 1 || !(pos > first[segment].position))
+    {
+        auto const* const upper = std::lower_bound(
+            first + 1, last, pos,
+            [](qtGradient::Stop const& s, qreal p){ return s.position < p; });
+        segment = static_cast<int>(upper - first) - 1;
+    }
+    else
+    {
+        while (pos > first[segment + 1].position)
+            ++segment;
+    }
+
+    return this->segmentColorAt(segment, pos);
+}
+
+//-----------------------------------------------------------------------------
+QColor qtGradientData::segmentColorAt(int segment, qreal pos) const
+{
+    auto const& s = this->segments[segment];
+
+    // Check for exact (or 'close enough') match against either stop
+    if (qFuzzyCompare(pos, s.upper))
+        return this->stops[segment + 1].color;
+    if (qFuzzyCompare(pos, s.lower))
+        return this->stops[segment].color;
+
+    // Calculate relative position
+    auto const rpos = (pos - s.lower) / (s.upper - s.lower);
+
+    // Calculate blended color
+    switch (this->interpolateMode & qtGradient::InterpolateFunctionMask)
+    {
+        case qtGradient::InterpolateDiscrete:
+            return (rpos < s.weight ? this->stops[segment].color
+                                    : this->stops[segment + 1].color);
+
+        case qtGradient::InterpolateCubic:
+            return this->cubicBlend(s, rpos);
+
+        default: // qtGradient::InterpolateLinear
+            return this->linearBlend(s.lowerColor, s.upperColor,
+                                     rpos, s.weight);
     }
 }
 
@@ -112,6 +318,7 @@ qtGradient::qtGradient() : d_ptr(new qtGradientData)
     d->interpolateMode = qtGradient::InterpolateLinear |
                          qtGradient::InterpolateRgb;
     d->spread = QGradient::PadSpread;
+    d->space = QColor::Rgb;
     insertStop(0.0, Qt::black);
     insertStop(1.0, Qt::white);
 }
@@ -124,6 +331,7 @@ qtGradient::qtGradient(QList<Stop> const& stops, InterpolationMode im,
     QTE_D_MUTABLE();
     d->interpolateMode = im;
     d->spread = spread;
+    d->space = d->blendSpace();
     setStops(stops, nm);
 }
 
@@ -156,6 +364,7 @@ void qtGradient::setInterpolationMode(qtGradient::InterpolationMode im)
 {
     QTE_D_MUTABLE();
     d->interpolateMode = im;
+    d->updateSegments();
 }
 
 //-----------------------------------------------------------------------------
@@ -176,7 +385,12 @@ void qtGradient::setSpread(qtGradient::Spread spread)
 QMap<qreal, qtGradient::Stop> qtGradient::stops() const
 {
     QTE_D_SHARED();
-    return d->stops;
+
+    QMap<qreal, qtGradient::Stop> stopsMap;
+    foreach (auto const& stop, d->stops)
+        stopsMap.insert(stop.position, stop);
+
+    return stopsMap;
 }
 
 //-----------------------------------------------------------------------------
@@ -185,66 +399,70 @@ void qtGradient::setStops(QList<qtGradient::Stop> const& stops,
 {
     QTE_D_MUTABLE();
 
-    // Handle empty set
-    if (stops.isEmpty())
-    {
-        d->stops.clear();
-        return;
-    }
+    d->stops.clear();
 
     // Handle set with exactly one stop
     if (stops.count() == 1)
     {
-        d->stops.clear();
-        d->stops.insert(0.0, stops.first());
-        return;
-    }
-
-    // Convert to map
-    QMap<qreal, qtGradient::Stop> stopsMap;
-    foreach (auto stop, stops)
-    {
-      stop.weight = qBound(0.0, stop.weight, 1.0);
-      stopsMap.insert(stop.position, stop);
+        auto stop = stops.first();
+        stop.position = 0.0;
+        stop.weight = qBound(0.0, stop.weight, 1.0);
+        d->stops.append(stop);
     }
-
-    // Handle 'regular' stop sets, based on normalization mode
-    if (nm == qtGradient::NormalizeStops)
+    else if (!stops.isEmpty())
     {
-        // Calculate coefficients to normalize stops to [0.0, 1.0]
-        auto const offset = stopsMap.constBegin().key();
-        auto const scale = 1.0 / ((--stopsMap.constEnd()).key() - offset);
-
-        // Recreate stop set, normalized
-        d->stops.clear();
+        // Convert to sorted set
+        QVector<qtGradient::Stop> sortedStops;
+        sortedStops.reserve(stops.count());
         foreach (auto stop, stops)
         {
-            stop.position = (stop.position - offset) * scale;
-            d->stops.insert(stop.position, stop);
+            stop.weight = qBound(0.0, stop.weight, 1.0);
+            qtGradientData::insertStop(sortedStops, stop);
         }
-    }
-    else
-    {
-        QMap<qreal, qtGradient::Stop>::iterator iter;
 
-        // Truncate stops outside of normalized range
-        while (!stopsMap.isEmpty() && (iter = stopsMap.begin()).key() < 0.0)
-            stopsMap.erase(iter);
-        while (!stopsMap.isEmpty() && (iter = stopsMap.end()).key() > 1.0)
-            stopsMap.erase(iter);
+        // Handle 'regular' stop sets, based on normalization mode
+        if (nm == qtGradient::NormalizeStops)
+        {
+            // Calculate coefficients to normalize stops to [0.0, 1.0]
+            auto const offset = sortedStops.first().position;
+            auto const scale = 1.0 / (sortedStops.last().position - offset);
 
-        // Add stops at 0.0, 1.0 if needed
-        if (!stopsMap.isEmpty())
+            // Normalize stops (which does not change their order)
+            for (auto& stop : sortedStops)
+                stop.position = (stop.position - offset) * scale;
+        }
+        else
         {
-            if ((iter = stopsMap.begin()).key() > 0.0)
-                stopsMap.insert(0.0, iter.value());
-            if ((iter = stopsMap.end()).key() < 1.0)
-                stopsMap.insert(1.0, iter.value());
+            // Truncate stops outside of normalized range
+            while (!sortedStops.isEmpty() &&
+                   sortedStops.first().position < 0.0)
+                sortedStops.removeFirst();
+            while (!sortedStops.isEmpty() &&
+                   sortedStops.last().position > 1.0)
+                sortedStops.removeLast();
+
+            // Add stops at 0.0, 1.0 if needed
+            if (!sortedStops.isEmpty())
+            {
+                if (sortedStops.first().position > 0.0)
+                {
+                    auto stop = sortedStops.first();
+                    stop.position = 0.0;
+                    sortedStops.prepend(stop);
+                }
+                if (sortedStops.last().position < 1.0)
+                {
+                    auto stop = sortedStops.last();
+                    stop.position = 1.0;
+                    sortedStops.append(stop);
+                }
+            }
         }
 
-        // Set stops to modified set
-        d->stops = stopsMap;
+        d->stops = sortedStops;
     }
+
+    d->updateSegments();
 }
 
 //-----------------------------------------------------------------------------
@@ -256,7 +474,8 @@ bool qtGradient::insertStop(qtGradient::Stop stop)
     QTE_D_MUTABLE();
 
     stop.weight = qBound(0.0, stop.weight, 1.0);
-    d->stops.insert(stop.position, stop);
+    qtGradientData::insertStop(d->stops, stop);
+    d->updateSegments();
 
     return true;
 }
@@ -265,81 +484,357 @@ bool qtGradient::insertStop(qtGradient::Stop stop)
 bool qtGradient::removeStop(qreal position)
 {
     QTE_D_MUTABLE();
-    return (d->stops.remove(position) > 0);
+
+    auto const iter = std::lower_bound(
+        d->stops.begin(), d->stops.end(), position,
+        [](qtGradient::Stop const& s, qreal p){ return s.position < p; });
+    if (iter == d->stops.end() || iter->position != position)
+        return false;
+
+    d->stops.erase(iter);
+    d->updateSegments();
+    return true;
 }
 
 //-----------------------------------------------------------------------------
 QColor qtGradient::at(qreal pos) const
 {
     QTE_D_SHARED();
+    return d->colorAt(d->applySpread(pos));
+}
 
-    if (d->stops.isEmpty())
-        return Qt::transparent;
-    if (d->stops.count() < 2)
-        return d->stops.begin().value().color;
+//-----------------------------------------------------------------------------
+qtGradientLut qtGradient::bake(int entries, bool includeFloat) const
+{
+    QTE_D_SHARED();
 
-    // Apply spread to get normalized position
-    switch (d->spread)
+    entries = qMax(2, entries);
+
+    qtGradientLut lut;
+    lut.spreadMode = d->spread;
+    lut.scale = static_cast<qreal>(entries - 1);
+    lut.table.resize(entries);
+    if (includeFloat)
+        lut.floatTable.resize(4 * entries);
+
+    // Sample the gradient over the normalized range; spread is applied when
+    // the table is sampled (positions are computed by division, rather than
+    // multiplying by the reciprocal, so that the last is exactly 1)
+    auto* const rgb = lut.table.data();
+    auto* const rgbaF = (includeFloat ? lut.floatTable.data() : nullptr);
+    auto segment = -1;
+    foreach (auto const i, qtIndexRange(entries))
     {
-        case QGradient::RepeatSpread:
-            pos = fmod(pos, 1.0);
-            (pos < 0.0) && (pos = 1.0 + pos);
-            break;
-        case QGradient::ReflectSpread:
-            pos = fabs(fmod(pos, 2.0));
-            (pos > 1.0) && (pos = 2.0 - pos);
-            break;
-        default:
-            pos = qBound(0.0, pos, 1.0);
-            break;
+        auto const& c = d->colorAt(static_cast<qreal>(i) / lut.scale,
+                                   segment);
+        rgb[i] = c.rgba();
+
+        if (rgbaF)
+        {
+            qreal r, g, b, a;
+            c.getRgbF(&r, &g, &b, &a);
+            rgbaF[(4 * i) + 0] = static_cast<float>(r);
+            rgbaF[(4 * i) + 1] = static_cast<float>(g);
+            rgbaF[(4 * i) + 2] = static_cast<float>(b);
+            rgbaF[(4 * i) + 3] = static_cast<float>(a);
+        }
     }
 
-    // Find next stop
-    auto const su = d->stops.lowerBound(pos);
+    return lut;
+}
 
-    // Check for exact (or 'close enough') match
-    if (qFuzzyCompare(pos, su.key()))
-        return su.value().color;
+//-----------------------------------------------------------------------------
+void qtGradient::map(float const* values, int count, qreal lo, qreal hi,
+                     QRgb* out, QRgb nanColor) const
+{
+    this->bake(defaultLutSize).map(values, count, lo, hi, out, nanColor);
+}
 
-    // Find previous stop and calculate relative position
-    auto const sl = su - 1;
-    auto const rpos = (pos - sl.key()) / (su.key() - sl.key());
+//-----------------------------------------------------------------------------
+void qtGradient::map(double const* values, int count, qreal lo, qreal hi,
+                     QRgb* out, QRgb nanColor) const
+{
+    this->bake(defaultLutSize).map(values, count, lo, hi, out, nanColor);
+}
 
-    // Check (again) for exact (or 'close enough') match, this time against the
-    // previous stop (in case we are off 'just enough' that lowerBound didn't
-    // consider it a match)
-    if (qFuzzyCompare(pos, sl.key()))
-        return sl.value().color;
+//-----------------------------------------------------------------------------
+QImage qtGradient::renderImage(
+    QSize const& size, Qt::Orientation orientation,
+    QColor const& checker1, QColor const& checker2, int checkerSize) const
+{
+    if (size.isEmpty())
+        return QImage();
+
+    auto const horizontal = (orientation == Qt::Horizontal);
+    auto const width = size.width();
+    auto const height = size.height();
+    auto const length = (horizontal ? width : height);
+    auto const checkered =
+        checker1.isValid() && checker2.isValid() && checkerSize > 0;
+
+    // Allocate the image first, as this can fail for large sizes
+    QImage image(size, QImage::Format_ARGB32_Premultiplied);
+    if (image.isNull())
+        return QImage();
+
+    // Compute colors along the gradient; when using a checkerboard, the colors
+    // are composited over each checker color, otherwise they are premultiplied
+    // (colors are sampled through the table, rather than taken directly from
+    // its entries, so that spread is applied as in at() and render())
+    auto const lut = this->bake(length);
+    auto const scale = static_cast<qreal>(qMax(1, length - 1));
+
+    QVector<QRgb> colors1(length), colors2;
+    auto* const c1 = colors1.data();
+    if (checkered)
+    {
+        colors2.resize(length);
+        auto* const c2 = colors2.data();
+        auto const bg1 = checker1.rgb();
+        auto const bg2 = checker2.rgb();
+        for (int i = 0; i < length; ++i)
+        {
+            auto const sample = lut.sample(i / scale);
+            c1[i] = composite(sample, bg1);
+            c2[i] = composite(sample, bg2);
+        }
+    }
+    else
+    {
+        for (int i = 0; i < length; ++i)
+            c1[i] = qPremultiply(lut.sample(i / scale));
+    }
+    auto const* const c2 = (checkered ? colors2.constData() : c1);
 
-    // Calculate blended color
-    switch (d->interpolateMode & qtGradient::InterpolateFunctionMask)
+    // For horizontal gradients, every row is one of (at most) two patterns,
+    // which are built once and then copied
+    QVector<QRgb> patterns;
+    if (horizontal)
     {
-        case qtGradient::InterpolateDiscrete:
-            return (rpos < sl->weight ? sl->color : su->color);
+        patterns.resize(2 * width);
+        auto* const p = patterns.data();
+        for (int i = 0; i < width; ++i)
+        {
+            auto const oddColumn = ((i / qMax(1, checkerSize)) & 1);
+            p[i] = (oddColumn ? c1[i] : c2[i]);
+            p[width + i] = (oddColumn ? c2[i] : c1[i]);
+        }
+    }
 
-        case qtGradient::InterpolateCubic:
+    auto* const bits = image.bits();
+    auto const stride = image.bytesPerLine();
+    auto const* const rowPatterns = patterns.constData();
+
+    // Write the rows directly
+    auto const fillRows = [=](int first, int last) {
+        for (int j = first; j < last; ++j)
         {
-            auto const sll = (sl == d->stops.begin() ? sl : sl - 1);
-            auto const suu = (su + 1 == d->stops.end() ? su : su + 1);
-            return d->cubicBlend(*sll, *sl, *su, *suu, rpos);
+            auto* const row = reinterpret_cast<QRgb*>(
+                bits + (static_cast<qptrdiff>(j) * stride));
+            auto const oddRow = (checkered && ((j / checkerSize) & 1));
+
+            if (horizontal)
+            {
+                auto const* const pattern = rowPatterns + (oddRow ? width : 0);
+                memcpy(row, pattern,
+                       static_cast<size_t>(width) * sizeof(QRgb));
+            }
+            else if (!checkered)
+            {
+                std::fill(row, row + width, c1[j]);
+            }
+            else
+            {
+                // Fill runs of checker cells, alternating colors; the second
+                // color is used where the cell's row and column parity match
+                auto same = !oddRow;
+                for (int i = 0; i < width; i += checkerSize)
+                {
+                    auto const n = qMin(checkerSize, width - i);
+                    std::fill(row + i, row + i + n, (same ? c2[j] : c1[j]));
+                    same = !same;
+                }
+            }
         }
+    };
 
-        default: // qtGradient::InterpolateLinear
-            return d->linearBlend(sl->color, su->color, rpos, sl->weight);
+    // Split large images into bands of rows, rendered in parallel
+    auto const threads = QThread::idealThreadCount();
+    if (threads > 1 &&
+        static_cast<qint64>(width) * height >= parallelRenderSize)
+    {
+        auto const band = (height + threads - 1) / threads;
+
+        QThreadPool pool;
+        for (int first = 0; first < height; first += band)
+        {
+            auto const last = qMin(height, first + band);
+            pool.start(makeTask([=]{ fillRows(first, last); }));
+        }
+        pool.waitForDone();
     }
+    else
+    {
+        fillRows(0, height);
+    }
+
+    return image;
 }
 
 //-----------------------------------------------------------------------------
 QList<QColor> qtGradient::render(int size) const
 {
+    QTE_D_SHARED();
+
     QList<QColor> out;
     out.reserve(size);
 
-    auto const k = static_cast<qreal>(1.0 / (size - 1));
+    // Sample positions increase monotonically (except where spread wraps),
+    // so the segment of each sample is found by walking forward from that of
+    // the previous sample rather than searching
+    auto const scale = static_cast<qreal>(size - 1);
+    auto segment = -1;
     foreach (auto const i, qtIndexRange(size))
-        out.append(at(static_cast<qreal>(i) * k));
+    {
+        auto const pos = d->applySpread(static_cast<qreal>(i) / scale);
+        out.append(d->colorAt(pos, segment));
+    }
 
     return out;
 }
 
 //END qtGradient
+
+///////////////////////////////////////////////////////////////////////////////
+
+//BEGIN qtGradientLut
+
+//-----------------------------------------------------------------------------
+qtGradientLut::qtGradientLut() : spreadMode(QGradient::PadSpread), scale(0.0)
+{
+}
+
+//-----------------------------------------------------------------------------
+float const* qtGradientLut::floatData() const
+{
+    return (this->floatTable.isEmpty() ? nullptr
+                                       : this->floatTable.constData());
+}
+
+//-----------------------------------------------------------------------------
+template <typename T>
+void qtGradientLut::mapValues(T const* values, int count, qreal lo, qreal hi,
+                              QRgb* out, QRgb nanColor) const
+{
+    if (this->table.isEmpty())
+    {
+        std::fill(out, out + qMax(0, count), nanColor);
+        return;
+    }
+
+    auto const* const table = this->table.constData();
+    auto const k = (hi != lo ? 1.0 / (hi - lo) : 0.0);
+
+    if (this->spreadMode != QGradient::PadSpread)
+    {
+        // Repeat and reflect require per-value modular arithmetic; use the
+        // general path
+        for (int i = 0; i < count; ++i)
+        {
+            auto const v = static_cast<qreal>(values[i]);
+            out[i] = (v == v ? table[this->index((v - lo) * k)] : nanColor);
+        }
+        return;
+    }
+
+    // Fold normalization and scaling to table indices into a single multiply
+    // and add, and clamp in index space
+    auto const a = k * this->scale;
+    auto const b = 0.5 - (lo * a);
+    auto const top = this->scale;
+
+    int indices[mapBlockSize];
+    for (int start = 0; start < count; start += mapBlockSize)
+    {
+        auto const n = qMin(mapBlockSize, count - start);
+        auto const* const v = values + start;
+        auto* const o = out + start;
+
+        for (int i = 0; i < n; ++i)
+        {
+            // Written so that NaN clamps to 0, to keep the index valid
+            auto x = (static_cast<qreal>(v[i]) * a) + b;
+            x = (x > 0.0 ? x : 0.0);
+            x = (x < top ? x : top);
+            indices[i] = static_cast<int>(x);
+        }
+
+        for (int i = 0; i < n; ++i)
+            o[i] = (v[i] == v[i] ? table[indices[i]] : nanColor);
+    }
+}
+
+//-----------------------------------------------------------------------------
+template <typename T>
+bool qtGradientLut::mapValues(T const* values, int count, qreal lo, qreal hi,
+                              QImage& image, int line, QRgb nanColor) const
+{
+    if (line < 0 || line >= image.height())
+        return false;
+
+    auto const format = image.format();
+    if (format != QImage::Format_RGB32 &&
+        format != QImage::Format_ARGB32 &&
+        format != QImage::Format_ARGB32_Premultiplied)
+    {
+        return false;
+    }
+
+    count = qMin(count, image.width());
+    auto* const out = reinterpret_cast<QRgb*>(image.scanLine(line));
+    this->mapValues(values, count, lo, hi, out, nanColor);
+
+    // Convert to the image's pixel format, if needed
+    if (format == QImage::Format_RGB32)
+    {
+        for (int i = 0; i < count; ++i)
+            out[i] |= 0xff000000u;
+    }
+    else if (format == QImage::Format_ARGB32_Premultiplied)
+    {
+        for (int i = 0; i < count; ++i)
+            out[i] = qPremultiply(out[i]);
+    }
+
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+void qtGradientLut::map(float const* values, int count, qreal lo, qreal hi,
+                        QRgb* out, QRgb nanColor) const
+{
+    this->mapValues(values, count, lo, hi, out, nanColor);
+}
+
+//-----------------------------------------------------------------------------
+void qtGradientLut::map(double const* values, int count, qreal lo, qreal hi,
+                        QRgb* out, QRgb nanColor) const
+{
+    this->mapValues(values, count, lo, hi, out, nanColor);
+}
+
+//-----------------------------------------------------------------------------
+bool qtGradientLut::map(float const* values, int count, qreal lo, qreal hi,
+                        QImage& image, int line, QRgb nanColor) const
+{
+    return this->mapValues(values, count, lo, hi, image, line, nanColor);
+}
+
+//-----------------------------------------------------------------------------
+bool qtGradientLut::map(double const* values, int count, qreal lo, qreal hi,
+                        QImage& image, int line, QRgb nanColor) const
+{
+    return this->mapValues(values, count, lo, hi, image, line, nanColor);
+}
+
+//END qtGradientLut
@@ -8,10 +8,17 @@
 #include <QGradient>
 #include <QMap>
 #include <QSharedDataPointer>
+#include <QVector>
+
+#include <cmath>
 
 #include "../core/qtGlobal.h"
 
+class QImage;
+class QSize;
+
 class qtGradientData;
+class qtGradientLut;
 
 class QTE_EXPORT qtGradient
 {
@@ -66,8 +73,18 @@ public:
     Spread spread() const;
     void setSpread(Spread);
 
+    // Get or set the stops; stop weights are clamped to [0, 1]. Multiple stops
+    // are either scaled to span [0, 1] (NormalizeStops), or truncated to that
+    // range, with the first and last stops repeated at 0 and 1 if needed
+    // (PadStops). A single stop is moved to 0 (in either mode), and colors the
+    // entire gradient.
     QMap<qreal, Stop> stops() const;
     void setStops(QList<Stop> const&, NormalizeMode = NormalizeStops);
+
+    // Insert a stop (which must lie in [0, 1]), replacing any stop at the same
+    // position, or remove the stop at a position; positions outside of the
+    // span of the stops (e.g. after removing an end stop) take the color of
+    // the nearest stop
     bool insertStop(Stop stop);
     bool removeStop(qreal position);
 
@@ -77,6 +94,25 @@ public:
     QColor at(qreal) const;
     QList<QColor> render(int size) const;
 
+    // Render the gradient to an image (in premultiplied ARGB); if checker
+    // colors are given, the gradient is composited over a checkerboard of
+    // those colors (with the given cell size) to visualize transparency
+    QImage renderImage(QSize const& size,
+                       Qt::Orientation orientation = Qt::Horizontal,
+                       QColor const& checker1 = QColor(),
+                       QColor const& checker2 = QColor(),
+                       int checkerSize = 6) const;
+
+    // Precompute a lookup table of the gradient, for fast repeated sampling
+    qtGradientLut bake(int entries, bool includeFloat = false) const;
+
+    // Map values in the range [lo, hi] to colors; this bakes a lookup table on
+    // every call, so callers mapping repeatedly should use bake() instead
+    void map(float const* values, int count, qreal lo, qreal hi,
+             QRgb* out, QRgb nanColor = 0) const;
+    void map(double const* values, int count, qreal lo, qreal hi,
+             QRgb* out, QRgb nanColor = 0) const;
+
 protected:
     QTE_DECLARE_SHARED_PTR(qtGradient)
 
@@ -86,4 +122,84 @@ private:
 
 Q_DECLARE_OPERATORS_FOR_FLAGS(qtGradient::InterpolationMode)
 
+class QTE_EXPORT qtGradientLut
+{
+public:
+    qtGradientLut();
+
+    bool isEmpty() const { return this->table.isEmpty(); }
+    int size() const { return this->table.count(); }
+    qtGradient::Spread spread() const { return this->spreadMode; }
+
+    // Table entries, as (non-premultiplied) packed colors, and, if the table
+    // was baked with floating point colors, as interleaved RGBA values
+    QRgb const* data() const { return this->table.constData(); }
+    float const* floatData() const;
+
+    // Sample the table; index() and sample() must not be called on an empty
+    // table, while sampleF() returns null if the table has no floating point
+    // colors
+    inline int index(qreal pos) const;
+    QRgb sample(qreal pos) const
+    { return this->table.constData()[this->index(pos)]; }
+    float const* sampleF(qreal pos) const
+    {
+        return (this->floatTable.isEmpty()
+                ? nullptr
+                : this->floatTable.constData() + (4 * this->index(pos)));
+    }
+
+    // Map values in the range [lo, hi] to colors; NaN values (and all values,
+    // if the table is empty) are given nanColor
+    void map(float const* values, int count, qreal lo, qreal hi,
+             QRgb* out, QRgb nanColor = 0) const;
+    void map(double const* values, int count, qreal lo, qreal hi,
+             QRgb* out, QRgb nanColor = 0) const;
+
+    // Map values into a row of an image; this supports the 32-bit RGB
+    // formats, and fails if the image has any other format
+    bool map(float const* values, int count, qreal lo, qreal hi,
+             QImage& image, int line, QRgb nanColor = 0) const;
+    bool map(double const* values, int count, qreal lo, qreal hi,
+             QImage& image, int line, QRgb nanColor = 0) const;
+
+protected:
+    friend class qtGradient;
+
+    template <typename T>
+    void mapValues(T const* values, int count, qreal lo, qreal hi,
+                   QRgb* out, QRgb nanColor) const;
+    template <typename T>
+    bool mapValues(T const* values, int count, qreal lo, qreal hi,
+                   QImage& image, int line, QRgb nanColor) const;
+
+    QVector<QRgb> table;
+    QVector<float> floatTable;
+    qtGradient::Spread spreadMode;
+    qreal scale;
+};
+
+//-----------------------------------------------------------------------------
+int qtGradientLut::index(qreal pos) const
+{
+    // Apply spread to get normalized position (as in qtGradient::at)
+    switch (this->spreadMode)
+    {
+        case QGradient::RepeatSpread:
+            pos = std::fmod(pos, 1.0);
+            (pos < 0.0) && (pos = 1.0 + pos);
+            break;
+        case QGradient::ReflectSpread:
+            pos = std::fabs(std::fmod(pos, 2.0));
+            (pos > 1.0) && (pos = 2.0 - pos);
+            break;
+        default:
+            break;
+    }
+
+    // Clamping also implements PadSpread, and maps NaN to a valid index
+    pos = qBound(0.0, pos, 1.0);
+    return static_cast<int>((pos * this->scale) + 0.5);
+}
+
 #endif
@@ -6,154 +6,2260 @@
 
 #include "../core/qtEnumerate.h"
 #include "../core/qtGlobal.h"
-#include "../core/qtIndexRange.h"
 #include "../core/qtMath.h"
 
+#include <QIODevice>
+#include <QLocale>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+QTE_IMPLEMENT_D_FUNC(qtJson::Writer)
+QTE_IMPLEMENT_D_FUNC(qtJson::Reader)
+QTE_IMPLEMENT_D_FUNC_SHARED(qtJson::Document)
+
 namespace // anonymous
 {
 
+// Number of bytes to accumulate before writing to a device
+const int deviceBufferSize = 64 * 1024;
+
+// Largest magnitudes below which every integer is exactly representable as a
+// double or float, respectively
+const double maxExactDouble = 9007199254740992.0; // 2^53
+const float maxExactFloat = 16777216.0f; // 2^24
+
+// Number of significant digits used by qtJson::LegacyReal
+const int legacyRealPrecision = 8;
+
+// Number of significant digits that always suffice to round-trip a float
+const int maxFloatPrecision = 9;
+
+//-----------------------------------------------------------------------------
+template <typename T>
+bool isExactInteger(T value, T limit)
+{
+  // Negative zero is excluded, so that its sign is preserved
+  return std::fabs(value) < limit && value == std::trunc(value) &&
+         !(value == 0 && std::signbit(value));
+}
+
+//-----------------------------------------------------------------------------
+inline bool isSafeAscii(ushort c)
+{
+  // Printable ASCII, other than the characters that must be escaped
+  return c >= 0x20 && c < 0x7f && c != '"' && c != '\\';
+}
+
+//-----------------------------------------------------------------------------
+inline bool isSafeAscii4(const ushort* p)
+{
+  // Test four characters at once, treating a 64-bit word as four 16-bit
+  // lanes (the tests are the same for every lane, so byte order does not
+  // matter)
+  static const quint64 ones = Q_UINT64_C(0x0001000100010001);
+  static const quint64 highs = ones * 0x80;
+
+  quint64 w;
+  memcpy(&w, p, sizeof(w));
+
+  const auto hasZero = [](quint64 v) {
+    return (v - ones) & ~v & (ones << 15);
+  };
+
+  return !(w & (ones * 0xff80)) &&          // all ASCII...
+         ((w + (ones * 0x60)) & highs) == highs && // ...and >= 0x20...
+         !((w + ones) & highs) &&           // ...and not DEL
+         !hasZero(w ^ (ones * '"')) &&
+         !hasZero(w ^ (ones * '\\'));
+}
+
+//-----------------------------------------------------------------------------
+void appendLatin1(QByteArray& out, const ushort* p, int count)
+{
+  const int size = out.size();
+  out.resize(size + count);
+
+  char* const dst = out.data() + size;
+  for (int i = 0; i < count; ++i)
+    {
+    dst[i] = static_cast<char>(p[i]);
+    }
+}
+
+//-----------------------------------------------------------------------------
+void appendUtf8(QByteArray& out, const ushort* p, int count)
+{
+  // Reserve space for the worst case (three bytes per UTF-16 code unit), then
+  // trim to the actual size; the input contains only non-ASCII characters
+  // and valid surrogate pairs
+  const int size = out.size();
+  out.resize(size + (3 * count));
+
+  uchar* dst = reinterpret_cast<uchar*>(out.data() + size);
+  const ushort* const end = p + count;
+  while (p < end)
+    {
+    const uint c = *(p++);
+    if (c < 0x800)
+      {
+      *(dst++) = static_cast<uchar>(0xc0 | (c >> 6));
+      *(dst++) = static_cast<uchar>(0x80 | (c & 0x3f));
+      }
+    else if (!QChar::isHighSurrogate(c))
+      {
+      *(dst++) = static_cast<uchar>(0xe0 | (c >> 12));
+      *(dst++) = static_cast<uchar>(0x80 | ((c >> 6) & 0x3f));
+      *(dst++) = static_cast<uchar>(0x80 | (c & 0x3f));
+      }
+    else
+      {
+      const uint u = QChar::surrogateToUcs4(static_cast<ushort>(c), *(p++));
+      *(dst++) = static_cast<uchar>(0xf0 | (u >> 18));
+      *(dst++) = static_cast<uchar>(0x80 | ((u >> 12) & 0x3f));
+      *(dst++) = static_cast<uchar>(0x80 | ((u >> 6) & 0x3f));
+      *(dst++) = static_cast<uchar>(0x80 | (u & 0x3f));
+      }
+    }
+
+  out.resize(static_cast<int>(dst - reinterpret_cast<uchar*>(out.data())));
+}
+
 //-----------------------------------------------------------------------------
-qtJson::JsonData join(QList<qtJson::JsonData> list, char prefix, char suffix)
+void appendEscaped(QByteArray& out, ushort c)
 {
-  qtJson::JsonData result;
+  static const char hexDigits[] = "0123456789abcdef";
 
-  result += prefix;
-  foreach (auto const i, qtIndexRange(list.count()))
+  switch (c)
     {
-    if (i)
+    case '"':  out.append("\\\"", 2); return;
+    case '\\': out.append("\\\\", 2); return;
+    case '\b': out.append("\\b", 2);  return;
+    case '\f': out.append("\\f", 2);  return;
+    case '\n': out.append("\\n", 2);  return;
+    case '\r': out.append("\\r", 2);  return;
+    case '\t': out.append("\\t", 2);  return;
+    default:
       {
-      result += ',';
+      const char escape[] = {
+        '\\', 'u',
+        hexDigits[(c >> 12) & 0xf], hexDigits[(c >> 8) & 0xf],
+        hexDigits[(c >> 4) & 0xf], hexDigits[c & 0xf]
+      };
+      out.append(escape, sizeof(escape));
+      return;
       }
-    result += list[i];
     }
-  result += suffix;
+}
 
-  return result;
+// Number of bytes to read from a device at a time
+const int readChunkSize = 64 * 1024;
+
+//-----------------------------------------------------------------------------
+bool isNumberCharacter(char c)
+{
+  return (c >= '0' && c <= '9') ||
+         c == '-' || c == '+' || c == '.' || c == 'e' || c == 'E';
+}
+
+//-----------------------------------------------------------------------------
+bool isValidNumber(const QByteArray& text)
+{
+  // Check against the JSON number grammar:
+  //   -?(0|[1-9][0-9]*)(\.[0-9]+)?([eE][+-]?[0-9]+)?
+  const char* p = text.constData();
+  const char* const end = p + text.size();
+  const auto isDigit = [&p, end]{ return p < end && *p >= '0' && *p <= '9'; };
+  const auto skipDigits = [&p, &isDigit]{
+    const char* const start = p;
+    while (isDigit())
+      {
+      ++p;
+      }
+    return p > start;
+  };
+
+  (p < end && *p == '-') && ++p;
+  if (p < end && *p == '0')
+    {
+    ++p;
+    }
+  else if (!skipDigits())
+    {
+    return false;
+    }
+
+  if (p < end && *p == '.')
+    {
+    ++p;
+    if (!skipDigits())
+      {
+      return false;
+      }
+    }
+
+  if (p < end && (*p == 'e' || *p == 'E'))
+    {
+    ++p;
+    (p < end && (*p == '+' || *p == '-')) && ++p;
+    if (!skipDigits())
+      {
+      return false;
+      }
+    }
+
+  return p == end;
+}
+
+//-----------------------------------------------------------------------------
+bool parseHex4(const char* p, uint& value)
+{
+  value = 0;
+  for (int i = 0; i < 4; ++i)
+    {
+    const char c = p[i];
+    const int digit = (c >= '0' && c <= '9' ? c - '0' :
+                       c >= 'a' && c <= 'f' ? c - 'a' + 10 :
+                       c >= 'A' && c <= 'F' ? c - 'A' + 10 : -1);
+    if (digit < 0)
+      {
+      return false;
+      }
+    value = (value << 4) | static_cast<uint>(digit);
+    }
+  return true;
 }
 
 } // namespace <anonymous>
 
 //-----------------------------------------------------------------------------
-qtJson::JsonData qtJson::encode(QString value)
+class qtJson::WriterPrivate
 {
-  const int k = value.length();
+public:
+  WriterPrivate(QByteArray* buffer, QIODevice* device);
 
-  JsonData result;
-  result.reserve(k + 2);
+  void beginValue();
+  void beginContainer(char open);
+  void endContainer(char close);
+
+  void appendInteger(quint64 magnitude, bool negative);
+  void appendReal(double value);
+  void appendFloat(float value);
+  void appendString(const QString& value);
+
+  bool flushIfFull();
+  bool flush();
+
+  QByteArray* const buffer;
+  QIODevice* const device;
+  QByteArray deviceBuffer;
+  bool valid;
+
+  qtJson::RealFormat realFormat;
+
+  bool needComma;
+  bool afterKey;
+};
+
+//-----------------------------------------------------------------------------
+qtJson::WriterPrivate::WriterPrivate(QByteArray* buffer, QIODevice* device)
+  : buffer(buffer && !device ? buffer : &this->deviceBuffer), device(device),
+    valid(device ? device->isWritable() : !!buffer),
+    realFormat(qtJson::ShortestReal), needComma(false), afterKey(false)
+{
+  if (device)
+    {
+    this->deviceBuffer.reserve(deviceBufferSize);
+    }
+}
+
+//-----------------------------------------------------------------------------
+void qtJson::WriterPrivate::beginValue()
+{
+  // Write out the buffer once it is full, so that long runs of scalars do not
+  // accumulate in memory
+  this->flushIfFull();
+
+  // A value following a key needs no separator; otherwise, values after the
+  // first in a container are separated by commas
+  if (this->afterKey)
+    {
+    this->afterKey = false;
+    }
+  else if (this->needComma)
+    {
+    this->buffer->append(',');
+    }
+  this->needComma = true;
+}
+
+//-----------------------------------------------------------------------------
+void qtJson::WriterPrivate::beginContainer(char open)
+{
+  this->beginValue();
+  this->buffer->append(open);
+  this->needComma = false;
+}
+
+//-----------------------------------------------------------------------------
+void qtJson::WriterPrivate::endContainer(char close)
+{
+  this->buffer->append(close);
+  this->needComma = true;
+  this->flushIfFull();
+}
+
+//-----------------------------------------------------------------------------
+void qtJson::WriterPrivate::appendInteger(quint64 magnitude, bool negative)
+{
+  // Format digits in reverse into a local buffer
+  char digits[24];
+  char* p = digits + sizeof(digits);
+  do
+    {
+    *(--p) = static_cast<char>('0' + (magnitude % 10));
+    magnitude /= 10;
+    }
+  while (magnitude);
+
+  if (negative)
+    {
+    *(--p) = '-';
+    }
+
+  this->buffer->append(p, static_cast<int>(digits + sizeof(digits) - p));
+}
+
+//-----------------------------------------------------------------------------
+void qtJson::WriterPrivate::appendReal(double value)
+{
+  if (!qIsFinite(value))
+    {
+    this->buffer->append("null");
+    }
+  else if (this->realFormat == qtJson::LegacyReal)
+    {
+    this->buffer->append(QByteArray::number(value, 'g', legacyRealPrecision));
+    }
+  else if (isExactInteger(value, maxExactDouble))
+    {
+    // Integral values are written exactly without going through the general
+    // formatting
+    const qint64 i = static_cast<qint64>(value);
+    this->appendInteger(i < 0 ? 0 - static_cast<quint64>(i)
+                              : static_cast<quint64>(i), i < 0);
+    }
+  else
+    {
+    // Qt's shortest representation is exact for doubles (it is computed by
+    // the bundled double-conversion library)
+    this->buffer->append(
+      QByteArray::number(value, 'g', QLocale::FloatingPointShortest));
+    }
+}
+
+//-----------------------------------------------------------------------------
+void qtJson::WriterPrivate::appendFloat(float value)
+{
+  const double dv = static_cast<double>(value);
+  if (!qIsFinite(value) || this->realFormat == qtJson::LegacyReal ||
+      isExactInteger(value, maxExactFloat))
+    {
+    this->appendReal(dv);
+    return;
+    }
+
+  // The shortest representation of the value as a double has more digits
+  // than are needed to identify the float; instead, use the fewest digits
+  // that read back as the same float
+  for (int precision = 1; precision < maxFloatPrecision; ++precision)
+    {
+    const QByteArray text = QByteArray::number(dv, 'g', precision);
+    if (text.toFloat() == value)
+      {
+      this->buffer->append(text);
+      return;
+      }
+    }
+  this->buffer->append(QByteArray::number(dv, 'g', maxFloatPrecision));
+}
+
+//-----------------------------------------------------------------------------
+void qtJson::WriterPrivate::appendString(const QString& value)
+{
+  QByteArray& out = *this->buffer;
+  out.append('"');
 
-  result += "\"";
-  foreach (auto const i, qtIndexRange(k))
+  const ushort* p = value.utf16();
+  const ushort* const end = p + value.length();
+  while (p < end)
     {
-    const QChar& c = value[i];
-    if (c == '\\')
+    // Copy the run of characters that need no escaping or transcoding
+    const ushort* const start = p;
+    while (end - p >= 4 && isSafeAscii4(p))
+      {
+      p += 4;
+      }
+    while (p < end && isSafeAscii(*p))
+      {
+      ++p;
+      }
+    appendLatin1(out, start, static_cast<int>(p - start));
+
+    if (p >= end)
+      {
+      break;
+      }
+
+    if (*p < 0x80)
+      {
+      appendEscaped(out, *(p++));
+      continue;
+      }
+
+    // Transcode the run of printable non-ASCII characters
+    const ushort* const runStart = p;
+    while (p < end && *p >= 0x80)
       {
-      result += "\\\\";
+      if (QChar::isHighSurrogate(*p))
+        {
+        if (end - p < 2 || !QChar::isLowSurrogate(p[1]) ||
+            !QChar::isPrint(QChar::surrogateToUcs4(p[0], p[1])))
+          {
+          break;
+          }
+        p += 2;
+        }
+      else if (QChar::isLowSurrogate(*p) || !QChar::isPrint(*p))
+        {
+        break;
+        }
+      else
+        {
+        ++p;
+        }
       }
-    else if (c == '\"')
+    appendUtf8(out, runStart, static_cast<int>(p - runStart));
+
+    if (p >= end || *p < 0x80)
       {
-      result += "\\\"";
+      continue;
       }
-    else if (!c.isPrint())
+
+    // Escape a non-printable character (both halves, if it is a surrogate
+    // pair), or replace an unpaired surrogate
+    if (QChar::isHighSurrogate(*p) && end - p >= 2 &&
+        QChar::isLowSurrogate(p[1]))
       {
-      result += QString::asprintf("\\u%04x", c.unicode()).toUtf8();
+      appendEscaped(out, *(p++));
+      appendEscaped(out, *(p++));
       }
-    else if (c.unicode() < 128)
+    else if (QChar::isSurrogate(*p))
       {
-      result += static_cast<char>(c.unicode());
+      out.append("\xef\xbf\xbd"); // U+FFFD
+      ++p;
       }
     else
       {
-      result += QString(c).toUtf8();
+      appendEscaped(out, *(p++));
       }
     }
-  result += "\"";
 
-  return result;
+  out.append('"');
 }
 
 //-----------------------------------------------------------------------------
-qtJson::JsonData qtJson::encode(const qtJson::Array& array)
+bool qtJson::WriterPrivate::flushIfFull()
 {
-  QList<JsonData> encodedValues;
-  encodedValues.reserve(array.count());
+  return !this->device || this->deviceBuffer.size() < deviceBufferSize ||
+         this->flush();
+}
 
-  foreach (auto const& value, array)
+//-----------------------------------------------------------------------------
+bool qtJson::WriterPrivate::flush()
+{
+  if (!this->device || this->deviceBuffer.isEmpty())
     {
-    encodedValues.append(encode(value));
+    return this->valid;
     }
 
-  return join(encodedValues, '[', ']');
+  if (this->valid)
+    {
+    const qint64 n = this->device->write(this->deviceBuffer);
+    this->valid = (n == this->deviceBuffer.size());
+    }
+
+  // Keep the allocation for reuse
+  this->deviceBuffer.resize(0);
+  return this->valid;
+}
+
+//-----------------------------------------------------------------------------
+qtJson::Writer::Writer(QByteArray* buffer)
+  : d_ptr(new WriterPrivate(buffer, nullptr))
+{
 }
 
 //-----------------------------------------------------------------------------
-qtJson::JsonData qtJson::encode(const qtJson::Object& object)
+qtJson::Writer::Writer(QIODevice* device)
+  : d_ptr(new WriterPrivate(nullptr, device))
 {
-  QList<JsonData> encodedPairs;
-  encodedPairs.reserve(object.count());
+}
 
-  foreach (auto const iter, qtEnumerate(object))
-    encodedPairs.append(encode(iter.key()) + ':' + encode(iter.value()));
+//-----------------------------------------------------------------------------
+qtJson::Writer::~Writer()
+{
+  this->flush();
+}
+
+//-----------------------------------------------------------------------------
+void qtJson::Writer::beginArray()
+{
+  QTE_D(Writer);
+  d->beginContainer('[');
+}
+
+//-----------------------------------------------------------------------------
+void qtJson::Writer::endArray()
+{
+  QTE_D(Writer);
+  d->endContainer(']');
+}
+
+//-----------------------------------------------------------------------------
+void qtJson::Writer::beginObject()
+{
+  QTE_D(Writer);
+  d->beginContainer('{');
+}
+
+//-----------------------------------------------------------------------------
+void qtJson::Writer::endObject()
+{
+  QTE_D(Writer);
+  d->endContainer('}');
+}
 
-  return join(encodedPairs, '{', '}');
+//-----------------------------------------------------------------------------
+void qtJson::Writer::writeKey(const QString& key)
+{
+  QTE_D(Writer);
+  d->beginValue();
+  d->appendString(key);
+  d->buffer->append(':');
+  d->afterKey = true;
+}
+
+//-----------------------------------------------------------------------------
+void qtJson::Writer::writeNull()
+{
+  QTE_D(Writer);
+  d->beginValue();
+  d->buffer->append("null");
+}
+
+//-----------------------------------------------------------------------------
+void qtJson::Writer::writeBool(bool value)
+{
+  QTE_D(Writer);
+  d->beginValue();
+  d->buffer->append(value ? "true" : "false");
+}
+
+//-----------------------------------------------------------------------------
+void qtJson::Writer::writeInteger(qint64 value)
+{
+  QTE_D(Writer);
+  d->beginValue();
+
+  // The magnitude is computed as unsigned so that the most negative value
+  // does not overflow
+  const bool negative = (value < 0);
+  d->appendInteger(negative ? 0 - static_cast<quint64>(value)
+                            : static_cast<quint64>(value), negative);
+}
+
+//-----------------------------------------------------------------------------
+void qtJson::Writer::writeUnsignedInteger(quint64 value)
+{
+  QTE_D(Writer);
+  d->beginValue();
+  d->appendInteger(value, false);
+}
+
+//-----------------------------------------------------------------------------
+void qtJson::Writer::writeReal(double value)
+{
+  QTE_D(Writer);
+  d->beginValue();
+  d->appendReal(value);
+}
+
+//-----------------------------------------------------------------------------
+void qtJson::Writer::writeFloat(float value)
+{
+  QTE_D(Writer);
+  d->beginValue();
+  d->appendFloat(value);
+}
+
+//-----------------------------------------------------------------------------
+void qtJson::Writer::writeString(const QString& value)
+{
+  QTE_D(Writer);
+  d->beginValue();
+  d->appendString(value);
+  d->flushIfFull();
+}
+
+//-----------------------------------------------------------------------------
+void qtJson::Writer::writeEncoded(const JsonData& data)
+{
+  QTE_D(Writer);
+  d->beginValue();
+  d->buffer->append(data);
+  d->flushIfFull();
 }
 
 //-----------------------------------------------------------------------------
-qtJson::JsonData qtJson::encode(const Value& value)
+void qtJson::Writer::writeValue(const Value& value)
 {
   switch (static_cast<QMetaType::Type>(value.type()))
     {
     // Already encoded data
     case QVariant::ByteArray:
-      return value.toByteArray();
+      this->writeEncoded(value.toByteArray());
+      break;
 
     // Special values
     case QVariant::Invalid:
-      return "null";
+      this->writeNull();
+      break;
     case QVariant::Bool:
-      return (value.toBool() ? "true" : "false");
+      this->writeBool(value.toBool());
+      break;
 
     // Integer types
     case QMetaType::Char:
-      return QByteArray::number(value.value<char>());
+      this->writeInteger(static_cast<qint64>(value.value<char>()));
+      break;
     case QMetaType::UChar:
-      return QByteArray::number(value.value<uchar>());
+      this->writeInteger(static_cast<qint64>(value.value<uchar>()));
+      break;
     case QMetaType::Short:
-      return QByteArray::number(value.value<short>());
+      this->writeInteger(static_cast<qint64>(value.value<short>()));
+      break;
     case QMetaType::UShort:
-      return QByteArray::number(value.value<ushort>());
+      this->writeInteger(static_cast<qint64>(value.value<ushort>()));
+      break;
     case QVariant::Int:
-      return QByteArray::number(value.toInt());
+      this->writeInteger(static_cast<qint64>(value.toInt()));
+      break;
     case QVariant::UInt:
-      return QByteArray::number(value.toUInt());
+      this->writeInteger(static_cast<qint64>(value.toUInt()));
+      break;
     case QVariant::LongLong:
-      return QByteArray::number(value.toLongLong());
+      this->writeInteger(value.toLongLong());
+      break;
     case QVariant::ULongLong:
-      return QByteArray::number(value.toULongLong());
+      this->writeUnsignedInteger(value.toULongLong());
+      break;
 
     // Floating point types
     case QMetaType::Float:
-      {
-      const float fv = value.value<float>();
-      return (qIsFinite(fv) ? QByteArray::number(fv, 'g', 8) : "null");
-      }
+      this->writeFloat(value.value<float>());
+      break;
     case QVariant::Double:
-      {
-      const double dv = value.toDouble();
-      return (qIsFinite(dv) ? QByteArray::number(dv, 'g', 8) : "null");
-      }
+      this->writeReal(value.toDouble());
+      break;
 
     // String
     case QVariant::String:
-      return encode(value.toString());
+      this->writeString(value.toString());
+      break;
 
-    // Array or object
+    // Array
     case QVariant::List:
-      return encode(value.toList());
+      this->beginArray();
+      foreach (auto const& item, value.toList())
+        {
+        this->writeValue(item);
+        }
+      this->endArray();
+      break;
+
+    // Object
     case QVariant::Map:
-      return encode(value.toMap());
+      {
+      const Object object = value.toMap();
+      this->beginObject();
+      foreach (auto const iter, qtEnumerate(object))
+        {
+        this->writeKey(iter.key());
+        this->writeValue(iter.value());
+        }
+      this->endObject();
+      break;
+      }
 
-    // Anything else is not supported
+    // Anything else is not supported, and is written as an empty value
     default:
-      return {};
+      {
+      QTE_D(Writer);
+      d->beginValue();
+      break;
+      }
     }
 }
+
+//-----------------------------------------------------------------------------
+qtJson::RealFormat qtJson::Writer::realFormat() const
+{
+  QTE_D_CONST(Writer);
+  return d->realFormat;
+}
+
+//-----------------------------------------------------------------------------
+void qtJson::Writer::setRealFormat(RealFormat format)
+{
+  QTE_D(Writer);
+  d->realFormat = format;
+}
+
+//-----------------------------------------------------------------------------
+bool qtJson::Writer::flush()
+{
+  QTE_D(Writer);
+  return d->flush();
+}
+
+//-----------------------------------------------------------------------------
+class qtJson::ReaderPrivate
+{
+public:
+  enum State
+  {
+    ExpectDocument,
+    ExpectValue,
+    ExpectFirstValue,
+    ExpectKey,
+    ExpectFirstKey,
+    ExpectColon,
+    ExpectSeparator,
+    ExpectEnd,
+    Finished
+  };
+
+  ReaderPrivate(const QByteArray& data, QIODevice* device);
+
+  bool more();
+  bool ensure(int count);
+  bool skipWhitespace();
+
+  Reader::TokenType readNext();
+  Reader::TokenType readValue();
+  Reader::TokenType readString(Reader::TokenType type);
+  Reader::TokenType readNumber();
+  Reader::TokenType readLiteral(const char* text, int length,
+                                Reader::TokenType type, bool value);
+  Reader::TokenType endContainer(char close);
+  Reader::TokenType setToken(Reader::TokenType type, int length);
+  Reader::TokenType setError(const QString& message, int at = 0);
+
+  void appendUtf8(uint c);
+
+  QIODevice* const device;
+  QByteArray buffer;
+  int pos;
+  qint64 bufferOffset;
+  bool eof;
+  QString deviceError;
+
+  QByteArray containers;
+  State state;
+
+  Reader::TokenType token;
+  qint64 tokenOffset;
+  QByteArray tokenData;
+  bool tokenBool;
+  QString error;
+};
+
+//-----------------------------------------------------------------------------
+qtJson::ReaderPrivate::ReaderPrivate(
+  const QByteArray& data, QIODevice* device)
+  : device(device), buffer(data), pos(0), bufferOffset(0), eof(!device),
+    state(ExpectDocument), token(Reader::NoToken), tokenOffset(0),
+    tokenBool(false)
+{
+}
+
+//-----------------------------------------------------------------------------
+bool qtJson::ReaderPrivate::more()
+{
+  if (this->eof)
+    {
+    return false;
+    }
+
+  // Discard consumed input; the token being read (if any) always starts at
+  // the current position, so only the unfinished token is retained
+  if (this->pos > 0)
+    {
+    this->buffer.remove(0, this->pos);
+    this->bufferOffset += this->pos;
+    this->pos = 0;
+    }
+
+  for (;;)
+    {
+    const int size = this->buffer.size();
+    this->buffer.resize(size + readChunkSize);
+
+    const qint64 n =
+      this->device->read(this->buffer.data() + size, readChunkSize);
+    this->buffer.resize(size + static_cast<int>(qMax(n, qint64(0))));
+
+    if (n > 0)
+      {
+      return true;
+      }
+    if (n == 0 && this->device->isSequential() &&
+        this->device->waitForReadyRead(-1))
+      {
+      continue;
+      }
+    if (n < 0)
+      {
+      this->deviceError = this->device->errorString();
+      }
+
+    this->eof = true;
+    return false;
+    }
+}
+
+//-----------------------------------------------------------------------------
+bool qtJson::ReaderPrivate::ensure(int count)
+{
+  while (this->buffer.size() - this->pos < count)
+    {
+    if (!this->more())
+      {
+      return false;
+      }
+    }
+  return true;
+}
+
+//-----------------------------------------------------------------------------
+bool qtJson::ReaderPrivate::skipWhitespace()
+{
+  for (;;)
+    {
+    const char* const data = this->buffer.constData();
+    const int size = this->buffer.size();
+    while (this->pos < size)
+      {
+      const char c = data[this->pos];
+      if (c != ' ' && c != '\n' && c != '\r' && c != '\t')
+        {
+        return true;
+        }
+      ++this->pos;
+      }
+
+    if (!this->more())
+      {
+      return false;
+      }
+    }
+}
+
+//-----------------------------------------------------------------------------
+qtJson::Reader::TokenType qtJson::ReaderPrivate::readNext()
+{
+  // Skip byte order mark, if present
+  if (this->state == ExpectDocument)
+    {
+    if (this->ensure(3) && this->buffer.mid(this->pos, 3) == "\xef\xbb\xbf")
+      {
+      this->pos += 3;
+      }
+    this->state = ExpectValue;
+    }
+
+  for (;;)
+    {
+    if (!this->skipWhitespace())
+      {
+      if (this->state == ExpectEnd)
+        {
+        this->tokenOffset = this->bufferOffset + this->pos;
+        this->state = Finished;
+        return (this->token = Reader::EndDocument);
+        }
+      return this->setError("unexpected end of input");
+      }
+
+    const char c = this->buffer.constData()[this->pos];
+    this->tokenOffset = this->bufferOffset + this->pos;
+
+    switch (this->state)
+      {
+      case ExpectFirstValue:
+        if (c == ']')
+          {
+          return this->endContainer(c);
+          }
+        return this->readValue();
+
+      case ExpectValue:
+        return this->readValue();
+
+      case ExpectFirstKey:
+        if (c == '}')
+          {
+          return this->endContainer(c);
+          }
+        // fall through
+      case ExpectKey:
+        if (c != '"')
+          {
+          return this->setError("expected object key");
+          }
+        return this->readString(Reader::Key);
+
+      case ExpectColon:
+        if (c != ':')
+          {
+          return this->setError("expected ':'");
+          }
+        ++this->pos;
+        this->state = ExpectValue;
+        continue;
+
+      case ExpectSeparator:
+        if (c == ',')
+          {
+          ++this->pos;
+          this->state = (this->containers.endsWith('{') ? ExpectKey
+                                                        : ExpectValue);
+          continue;
+          }
+        return this->endContainer(c);
+
+      case ExpectEnd:
+        return this->setError("unexpected data after document");
+
+      default:
+        return this->token;
+      }
+    }
+}
+
+//-----------------------------------------------------------------------------
+qtJson::Reader::TokenType qtJson::ReaderPrivate::readValue()
+{
+  const char c = this->buffer.constData()[this->pos];
+  switch (c)
+    {
+    case '[':
+      this->containers.append(c);
+      this->state = ExpectFirstValue;
+      ++this->pos;
+      return (this->token = Reader::StartArray);
+    case '{':
+      this->containers.append(c);
+      this->state = ExpectFirstKey;
+      ++this->pos;
+      return (this->token = Reader::StartObject);
+    case '"':
+      return this->readString(Reader::String);
+    case 't':
+      return this->readLiteral("true", 4, Reader::Bool, true);
+    case 'f':
+      return this->readLiteral("false", 5, Reader::Bool, false);
+    case 'n':
+      return this->readLiteral("null", 4, Reader::Null, false);
+    default:
+      if (c == '-' || (c >= '0' && c <= '9'))
+        {
+        return this->readNumber();
+        }
+      return this->setError("unexpected character");
+    }
+}
+
+//-----------------------------------------------------------------------------
+qtJson::Reader::TokenType qtJson::ReaderPrivate::readString(
+  Reader::TokenType type)
+{
+  this->tokenData.resize(0);
+
+  // Offsets are relative to the opening quote, since reading more input may
+  // move the token within the buffer
+  int k = 1;
+  for (;;)
+    {
+    const char* data = this->buffer.constData() + this->pos;
+    const int size = this->buffer.size() - this->pos;
+
+    // Copy the run of characters up to the next quote, escape, or end of
+    // available input
+    const int start = k;
+    while (k < size && data[k] != '"' && data[k] != '\\' &&
+           static_cast<uchar>(data[k]) >= 0x20)
+      {
+      ++k;
+      }
+    this->tokenData.append(data + start, k - start);
+
+    if (k >= size)
+      {
+      if (!this->more())
+        {
+        return this->setError("unterminated string");
+        }
+      continue;
+      }
+
+    const char c = data[k];
+    if (c == '"')
+      {
+      this->state = (type == Reader::Key ? ExpectColon : ExpectSeparator);
+      return this->setToken(type, k + 1);
+      }
+    if (c != '\\')
+      {
+      return this->setError("control character in string", k);
+      }
+
+    // Decode escape sequence
+    if (!this->ensure(k + 2))
+      {
+      return this->setError("unterminated string");
+      }
+    data = this->buffer.constData() + this->pos;
+
+    switch (data[k + 1])
+      {
+      case '"':  this->tokenData.append('"');  break;
+      case '\\': this->tokenData.append('\\'); break;
+      case '/':  this->tokenData.append('/');  break;
+      case 'b':  this->tokenData.append('\b'); break;
+      case 'f':  this->tokenData.append('\f'); break;
+      case 'n':  this->tokenData.append('\n'); break;
+      case 'r':  this->tokenData.append('\r'); break;
+      case 't':  this->tokenData.append('\t'); break;
+      case 'u':
+        {
+        uint u = 0;
+        if (!this->ensure(k + 6) ||
+            !parseHex4(this->buffer.constData() + this->pos + k + 2, u))
+          {
+          return this->setError("invalid escape sequence", k);
+          }
+
+        // Combine surrogate pairs; unpaired surrogates are replaced
+        if (QChar::isHighSurrogate(u))
+          {
+          uint l = 0;
+          const bool paired =
+            this->ensure(k + 12) &&
+            this->buffer.at(this->pos + k + 6) == '\\' &&
+            this->buffer.at(this->pos + k + 7) == 'u' &&
+            parseHex4(this->buffer.constData() + this->pos + k + 8, l) &&
+            QChar::isLowSurrogate(l);
+          if (paired)
+            {
+            u = QChar::surrogateToUcs4(static_cast<ushort>(u),
+                                       static_cast<ushort>(l));
+            k += 6;
+            }
+          else
+            {
+            u = QChar::ReplacementCharacter;
+            }
+          }
+        else if (QChar::isSurrogate(u))
+          {
+          u = QChar::ReplacementCharacter;
+          }
+
+        this->appendUtf8(u);
+        k += 4;
+        break;
+        }
+      default:
+        return this->setError("invalid escape sequence", k);
+      }
+    k += 2;
+    }
+}
+
+//-----------------------------------------------------------------------------
+qtJson::Reader::TokenType qtJson::ReaderPrivate::readNumber()
+{
+  // Find the extent of the number, reading more input as needed
+  int k = 0;
+  for (;;)
+    {
+    const char* const data = this->buffer.constData() + this->pos;
+    const int size = this->buffer.size() - this->pos;
+    while (k < size && isNumberCharacter(data[k]))
+      {
+      ++k;
+      }
+    if (k < size || !this->more())
+      {
+      break;
+      }
+    }
+
+  this->tokenData = this->buffer.mid(this->pos, k);
+  if (!isValidNumber(this->tokenData))
+    {
+    return this->setError("invalid number");
+    }
+
+  this->state = ExpectSeparator;
+  return this->setToken(Reader::Number, k);
+}
+
+//-----------------------------------------------------------------------------
+qtJson::Reader::TokenType qtJson::ReaderPrivate::readLiteral(
+  const char* text, int length, Reader::TokenType type, bool value)
+{
+  if (!this->ensure(length) ||
+      memcmp(this->buffer.constData() + this->pos, text,
+             static_cast<size_t>(length)) != 0)
+    {
+    return this->setError("invalid literal");
+    }
+
+  this->tokenBool = value;
+  this->state = ExpectSeparator;
+  return this->setToken(type, length);
+}
+
+//-----------------------------------------------------------------------------
+qtJson::Reader::TokenType qtJson::ReaderPrivate::endContainer(char close)
+{
+  const char open = (close == ']' ? '[' : close == '}' ? '{' : '\0');
+  if (!open || !this->containers.endsWith(open))
+    {
+    return this->setError("unexpected character");
+    }
+
+  this->containers.chop(1);
+  this->state = ExpectSeparator;
+  return this->setToken(close == ']' ? Reader::EndArray : Reader::EndObject,
+                        1);
+}
+
+//-----------------------------------------------------------------------------
+qtJson::Reader::TokenType qtJson::ReaderPrivate::setToken(
+  Reader::TokenType type, int length)
+{
+  // After a complete value at the top level, only the end of the document
+  // may follow
+  if (this->state == ExpectSeparator && this->containers.isEmpty())
+    {
+    this->state = ExpectEnd;
+    }
+
+  this->pos += length;
+  return (this->token = type);
+}
+
+//-----------------------------------------------------------------------------
+qtJson::Reader::TokenType qtJson::ReaderPrivate::setError(
+  const QString& message, int at)
+{
+  this->error = (this->deviceError.isEmpty() ? message : this->deviceError);
+  this->tokenOffset = this->bufferOffset + this->pos + at;
+  this->tokenData.clear();
+  this->state = Finished;
+  return (this->token = Reader::Invalid);
+}
+
+//-----------------------------------------------------------------------------
+void qtJson::ReaderPrivate::appendUtf8(uint c)
+{
+  if (c < 0x80)
+    {
+    this->tokenData.append(static_cast<char>(c));
+    return;
+    }
+
+  // Write lead byte, then continuation bytes
+  const int n = (c < 0x800 ? 1 : c < 0x10000 ? 2 : 3);
+  static const uchar leads[] = { 0x00, 0xc0, 0xe0, 0xf0 };
+  this->tokenData.append(static_cast<char>(leads[n] | (c >> (6 * n))));
+  for (int k = n - 1; k >= 0; --k)
+    {
+    this->tokenData.append(static_cast<char>(0x80 | ((c >> (6 * k)) & 0x3f)));
+    }
+}
+
+//-----------------------------------------------------------------------------
+qtJson::Reader::Reader(const QByteArray& data)
+  : d_ptr(new ReaderPrivate(data, nullptr))
+{
+}
+
+//-----------------------------------------------------------------------------
+qtJson::Reader::Reader(QIODevice* device)
+  : d_ptr(new ReaderPrivate(QByteArray(), device))
+{
+}
+
+//-----------------------------------------------------------------------------
+qtJson::Reader::~Reader()
+{
+}
+
+//-----------------------------------------------------------------------------
+qtJson::Reader::TokenType qtJson::Reader::readNext()
+{
+  QTE_D(Reader);
+  if (d->state == ReaderPrivate::Finished)
+    {
+    return d->token;
+    }
+  return d->readNext();
+}
+
+//-----------------------------------------------------------------------------
+qtJson::Reader::TokenType qtJson::Reader::tokenType() const
+{
+  QTE_D_CONST(Reader);
+  return d->token;
+}
+
+//-----------------------------------------------------------------------------
+bool qtJson::Reader::atEnd() const
+{
+  QTE_D_CONST(Reader);
+  return d->state == ReaderPrivate::Finished;
+}
+
+//-----------------------------------------------------------------------------
+bool qtJson::Reader::hasError() const
+{
+  QTE_D_CONST(Reader);
+  return d->token == Invalid;
+}
+
+//-----------------------------------------------------------------------------
+QString qtJson::Reader::errorString() const
+{
+  QTE_D_CONST(Reader);
+  return d->error;
+}
+
+//-----------------------------------------------------------------------------
+qint64 qtJson::Reader::offset() const
+{
+  QTE_D_CONST(Reader);
+  return d->tokenOffset;
+}
+
+//-----------------------------------------------------------------------------
+int qtJson::Reader::depth() const
+{
+  QTE_D_CONST(Reader);
+  return d->containers.size();
+}
+
+//-----------------------------------------------------------------------------
+QString qtJson::Reader::string() const
+{
+  QTE_D_CONST(Reader);
+  return (d->token == Key || d->token == String
+          ? QString::fromUtf8(d->tokenData) : QString());
+}
+
+//-----------------------------------------------------------------------------
+double qtJson::Reader::number() const
+{
+  QTE_D_CONST(Reader);
+  return (d->token == Number ? d->tokenData.toDouble() : 0.0);
+}
+
+//-----------------------------------------------------------------------------
+bool qtJson::Reader::isInteger() const
+{
+  QTE_D_CONST(Reader);
+  if (d->token != Number)
+    {
+    return false;
+    }
+
+  foreach (auto const c, d->tokenData)
+    {
+    if (c == '.' || c == 'e' || c == 'E')
+      {
+      return false;
+      }
+    }
+
+  bool okay;
+  d->tokenData.toLongLong(&okay);
+  return okay;
+}
+
+//-----------------------------------------------------------------------------
+qint64 qtJson::Reader::integer() const
+{
+  QTE_D_CONST(Reader);
+  return (d->token == Number ? d->tokenData.toLongLong() : 0);
+}
+
+//-----------------------------------------------------------------------------
+bool qtJson::Reader::boolean() const
+{
+  QTE_D_CONST(Reader);
+  return (d->token == Bool && d->tokenBool);
+}
+
+//-----------------------------------------------------------------------------
+bool qtJson::Reader::skipValue()
+{
+  QTE_D(Reader);
+  if (d->token != StartArray && d->token != StartObject)
+    {
+    return !this->hasError();
+    }
+
+  // Read until the container that was just started has been closed
+  const int depth = d->containers.size();
+  while (d->containers.size() >= depth)
+    {
+    if (this->readNext() == Invalid)
+      {
+      return false;
+      }
+    }
+
+  return true;
+}
+
+//-----------------------------------------------------------------------------
+qtJson::Value qtJson::Reader::readValue()
+{
+  QTE_D(Reader);
+  switch (d->token)
+    {
+    case String:
+      return this->string();
+    case Number:
+      return (this->isInteger() ? Value(this->integer())
+                                : Value(this->number()));
+    case Bool:
+      return d->tokenBool;
+
+    case StartArray:
+      {
+      Array array;
+      for (;;)
+        {
+        const TokenType type = this->readNext();
+        if (type == EndArray)
+          {
+          return array;
+          }
+
+        const Value value = this->readValue();
+        if (this->hasError())
+          {
+          return {};
+          }
+        array.append(value);
+        }
+      }
+
+    case StartObject:
+      {
+      Object object;
+      for (;;)
+        {
+        const TokenType type = this->readNext();
+        if (type == EndObject)
+          {
+          return object;
+          }
+        if (type != Key)
+          {
+          return {};
+          }
+
+        const QString key = this->string();
+        this->readNext();
+        const Value value = this->readValue();
+        if (this->hasError())
+          {
+          return {};
+          }
+        object.insert(key, value);
+        }
+      }
+
+    // Null, and anything that is not the start of a value
+    default:
+      return {};
+    }
+}
+
+//-----------------------------------------------------------------------------
+class qtJson::DocumentData : public QSharedData
+{
+public:
+  enum Flag
+  {
+    UnsignedFlag = 0x1,
+    SingleFlag = 0x2
+  };
+
+  struct NodeData
+  {
+    quint8 type;
+    quint8 flags;
+    qint32 count;
+    union
+    {
+      bool b;
+      qint64 i;
+      quint64 u;
+      double r;
+      qint32 offset;
+    } value;
+  };
+
+  DocumentData() : root(-1) {}
+
+  const NodeData* node(int n) const;
+  const NodeData* node(int n, Document::Type type) const;
+
+  int addNode(Document::Type type, int count = 0, int flags = 0);
+  int addString(const QString& value);
+  int addContainer(Document::Type type, const QVector<int>& children);
+  int addObject(QVector<QPair<QString, int>> members);
+  int addValue(const Value& value);
+  int readValue(Reader& reader);
+
+  QString string(const NodeData& n) const;
+  Value toValue(int n) const;
+  void write(Writer& writer, int n) const;
+
+  QVector<NodeData> nodes;
+  QVector<int> children;
+  QString text;
+  QByteArray encoded;
+  int root;
+};
+
+//-----------------------------------------------------------------------------
+const qtJson::DocumentData::NodeData* qtJson::DocumentData::node(int n) const
+{
+  return (n >= 0 && n < this->nodes.count() ? this->nodes.constData() + n
+                                            : nullptr);
+}
+
+//-----------------------------------------------------------------------------
+const qtJson::DocumentData::NodeData* qtJson::DocumentData::node(
+  int n, Document::Type type) const
+{
+  const NodeData* const p = this->node(n);
+  return (p && p->type == type ? p : nullptr);
+}
+
+//-----------------------------------------------------------------------------
+int qtJson::DocumentData::addNode(Document::Type type, int count, int flags)
+{
+  NodeData n;
+  n.type = static_cast<quint8>(type);
+  n.flags = static_cast<quint8>(flags);
+  n.count = count;
+  n.value.i = 0;
+
+  this->nodes.append(n);
+  return this->nodes.count() - 1;
+}
+
+//-----------------------------------------------------------------------------
+int qtJson::DocumentData::addString(const QString& value)
+{
+  const int n = this->addNode(Document::StringType, value.length());
+  this->nodes[n].value.offset = this->text.length();
+  this->text.append(value);
+  return n;
+}
+
+//-----------------------------------------------------------------------------
+int qtJson::DocumentData::addContainer(
+  Document::Type type, const QVector<int>& children)
+{
+  // Objects store (key, value) pairs of nodes
+  const int count =
+    (type == Document::ObjectType ? children.count() / 2 : children.count());
+
+  const int n = this->addNode(type, count);
+  this->nodes[n].value.offset = this->children.count();
+  this->children += children;
+  return n;
+}
+
+//-----------------------------------------------------------------------------
+int qtJson::DocumentData::addObject(QVector<QPair<QString, int>> members)
+{
+  // Sort the members by key; the sort is stable, so that the last of any
+  // members with the same key can be kept
+  std::stable_sort(
+    members.begin(), members.end(),
+    [](const QPair<QString, int>& a, const QPair<QString, int>& b) {
+      return a.first < b.first;
+    });
+
+  QVector<int> pairs;
+  pairs.reserve(2 * members.count());
+  for (int i = 0; i < members.count(); ++i)
+    {
+    if (i + 1 < members.count() && members[i + 1].first == members[i].first)
+      {
+      continue;
+      }
+    pairs.append(this->addString(members[i].first));
+    pairs.append(members[i].second);
+    }
+
+  return this->addContainer(Document::ObjectType, pairs);
+}
+
+//-----------------------------------------------------------------------------
+int qtJson::DocumentData::addValue(const Value& value)
+{
+  switch (static_cast<QMetaType::Type>(value.type()))
+    {
+    // Already encoded data
+    case QVariant::ByteArray:
+      {
+      const QByteArray data = value.toByteArray();
+      const int n = this->addNode(Document::EncodedType, data.size());
+      this->nodes[n].value.offset = this->encoded.size();
+      this->encoded.append(data);
+      return n;
+      }
+
+    case QVariant::Bool:
+      {
+      const int n = this->addNode(Document::BoolType);
+      this->nodes[n].value.b = value.toBool();
+      return n;
+      }
+
+    // Integer types
+    case QMetaType::Char:
+    case QMetaType::UChar:
+    case QMetaType::Short:
+    case QMetaType::UShort:
+    case QVariant::Int:
+    case QVariant::UInt:
+    case QVariant::LongLong:
+      {
+      const int n = this->addNode(Document::IntegerType);
+      this->nodes[n].value.i = value.toLongLong();
+      return n;
+      }
+    case QVariant::ULongLong:
+      {
+      const int n = this->addNode(Document::IntegerType, 0, UnsignedFlag);
+      this->nodes[n].value.u = value.toULongLong();
+      return n;
+      }
+
+    // Floating point types
+    case QMetaType::Float:
+      {
+      const int n = this->addNode(Document::RealType, 0, SingleFlag);
+      this->nodes[n].value.r = static_cast<double>(value.value<float>());
+      return n;
+      }
+    case QVariant::Double:
+      {
+      const int n = this->addNode(Document::RealType);
+      this->nodes[n].value.r = value.toDouble();
+      return n;
+      }
+
+    // String
+    case QVariant::String:
+      return this->addString(value.toString());
+
+    // Array or object; the children are added first, so that the contents
+    // of the container are contiguous
+    case QVariant::List:
+      {
+      const Array array = value.toList();
+      QVector<int> items;
+      items.reserve(array.count());
+      foreach (auto const& item, array)
+        {
+        items.append(this->addValue(item));
+        }
+      return this->addContainer(Document::ArrayType, items);
+      }
+    case QVariant::Map:
+      {
+      // Map keys are already sorted and unique
+      const Object object = value.toMap();
+      QVector<int> members;
+      members.reserve(2 * object.count());
+      foreach (auto const iter, qtEnumerate(object))
+        {
+        members.append(this->addString(iter.key()));
+        members.append(this->addValue(iter.value()));
+        }
+      return this->addContainer(Document::ObjectType, members);
+      }
+
+    // Null, and anything else (which is not supported)
+    default:
+      return this->addNode(Document::NullType);
+    }
+}
+
+//-----------------------------------------------------------------------------
+int qtJson::DocumentData::readValue(Reader& reader)
+{
+  switch (reader.tokenType())
+    {
+    case Reader::String:
+      return this->addString(reader.string());
+
+    case Reader::Number:
+      if (reader.isInteger())
+        {
+        const int n = this->addNode(Document::IntegerType);
+        this->nodes[n].value.i = reader.integer();
+        return n;
+        }
+      else
+        {
+        const int n = this->addNode(Document::RealType);
+        this->nodes[n].value.r = reader.number();
+        return n;
+        }
+
+    case Reader::Bool:
+      {
+      const int n = this->addNode(Document::BoolType);
+      this->nodes[n].value.b = reader.boolean();
+      return n;
+      }
+
+    case Reader::Null:
+      return this->addNode(Document::NullType);
+
+    case Reader::StartArray:
+      {
+      QVector<int> items;
+      while (reader.readNext() != Reader::EndArray)
+        {
+        const int n = this->readValue(reader);
+        if (n < 0)
+          {
+          return -1;
+          }
+        items.append(n);
+        }
+      return this->addContainer(Document::ArrayType, items);
+      }
+
+    case Reader::StartObject:
+      {
+      QVector<QPair<QString, int>> members;
+      while (reader.readNext() != Reader::EndObject)
+        {
+        if (reader.tokenType() != Reader::Key)
+          {
+          return -1;
+          }
+
+        const QString key = reader.string();
+        reader.readNext();
+        const int n = this->readValue(reader);
+        if (n < 0)
+          {
+          return -1;
+          }
+        members.append(qMakePair(key, n));
+        }
+
+      return this->addObject(members);
+      }
+
+    default:
+      return -1;
+    }
+}
+
+//-----------------------------------------------------------------------------
+QString qtJson::DocumentData::string(const NodeData& n) const
+{
+  return this->text.mid(n.value.offset, n.count);
+}
+
+//-----------------------------------------------------------------------------
+qtJson::Value qtJson::DocumentData::toValue(int n) const
+{
+  const NodeData* const p = this->node(n);
+  if (!p)
+    {
+    return {};
+    }
+
+  switch (p->type)
+    {
+    case Document::BoolType:
+      return p->value.b;
+    case Document::IntegerType:
+      return (p->flags & UnsignedFlag ? Value(p->value.u) : Value(p->value.i));
+    case Document::RealType:
+      if (p->flags & SingleFlag)
+        {
+        return QVariant::fromValue(static_cast<float>(p->value.r));
+        }
+      return p->value.r;
+    case Document::StringType:
+      return this->string(*p);
+    case Document::EncodedType:
+      return this->encoded.mid(p->value.offset, p->count);
+
+    case Document::ArrayType:
+      {
+      const int* const c = this->children.constData() + p->value.offset;
+      Array array;
+      array.reserve(p->count);
+      for (int i = 0; i < p->count; ++i)
+        {
+        array.append(this->toValue(c[i]));
+        }
+      return array;
+      }
+
+    case Document::ObjectType:
+      {
+      const int* const c = this->children.constData() + p->value.offset;
+      Object object;
+      for (int i = 0; i < p->count; ++i)
+        {
+        object.insert(this->string(this->nodes[c[2 * i]]),
+                      this->toValue(c[(2 * i) + 1]));
+        }
+      return object;
+      }
+
+    default: // null
+      return {};
+    }
+}
+
+//-----------------------------------------------------------------------------
+void qtJson::DocumentData::write(Writer& writer, int n) const
+{
+  const NodeData* const p = this->node(n);
+  if (!p)
+    {
+    writer.writeNull();
+    return;
+    }
+
+  // Strings are written from the arena without copying
+  const auto textOf = [this](const NodeData& s) {
+    return QString::fromRawData(this->text.constData() + s.value.offset,
+                                s.count);
+  };
+
+  switch (p->type)
+    {
+    case Document::BoolType:
+      writer.writeBool(p->value.b);
+      break;
+    case Document::IntegerType:
+      if (p->flags & UnsignedFlag)
+        {
+        writer.writeUnsignedInteger(p->value.u);
+        }
+      else
+        {
+        writer.writeInteger(p->value.i);
+        }
+      break;
+    case Document::RealType:
+      if (p->flags & SingleFlag)
+        {
+        writer.writeFloat(static_cast<float>(p->value.r));
+        }
+      else
+        {
+        writer.writeReal(p->value.r);
+        }
+      break;
+    case Document::StringType:
+      writer.writeString(textOf(*p));
+      break;
+    case Document::EncodedType:
+      writer.writeEncoded(QByteArray::fromRawData(
+        this->encoded.constData() + p->value.offset, p->count));
+      break;
+
+    case Document::ArrayType:
+      {
+      const int* const c = this->children.constData() + p->value.offset;
+      writer.beginArray();
+      for (int i = 0; i < p->count; ++i)
+        {
+        this->write(writer, c[i]);
+        }
+      writer.endArray();
+      break;
+      }
+
+    case Document::ObjectType:
+      {
+      const int* const c = this->children.constData() + p->value.offset;
+      writer.beginObject();
+      for (int i = 0; i < p->count; ++i)
+        {
+        writer.writeKey(textOf(this->nodes[c[2 * i]]));
+        this->write(writer, c[(2 * i) + 1]);
+        }
+      writer.endObject();
+      break;
+      }
+
+    default: // null
+      writer.writeNull();
+      break;
+    }
+}
+
+//-----------------------------------------------------------------------------
+qtJson::Document::Document() : d_ptr(new DocumentData)
+{
+}
+
+//-----------------------------------------------------------------------------
+qtJson::Document::Document(const Document& other) : d_ptr(other.d_ptr)
+{
+}
+
+//-----------------------------------------------------------------------------
+qtJson::Document::~Document()
+{
+}
+
+//-----------------------------------------------------------------------------
+qtJson::Document& qtJson::Document::operator=(const Document& other)
+{
+  this->d_ptr = other.d_ptr;
+  return *this;
+}
+
+//-----------------------------------------------------------------------------
+qtJson::Document qtJson::Document::fromValue(const Value& value)
+{
+  Document document;
+  auto* const d = document.d_func(true);
+  d->root = d->addValue(value);
+  return document;
+}
+
+//-----------------------------------------------------------------------------
+qtJson::Document qtJson::Document::read(Reader& reader)
+{
+  Document document;
+  auto* const d = document.d_func(true);
+  const int root = d->readValue(reader);
+  if (root < 0 || reader.hasError())
+    {
+    return Document();
+    }
+
+  d->root = root;
+  return document;
+}
+
+//-----------------------------------------------------------------------------
+qtJson::Value qtJson::Document::toValue() const
+{
+  QTE_D_SHARED();
+  return d->toValue(d->root);
+}
+
+//-----------------------------------------------------------------------------
+qtJson::Value qtJson::Document::toValue(Node n) const
+{
+  QTE_D_SHARED();
+  return d->toValue(n);
+}
+
+//-----------------------------------------------------------------------------
+void qtJson::Document::write(Writer& writer) const
+{
+  QTE_D_SHARED();
+  d->write(writer, d->root);
+}
+
+//-----------------------------------------------------------------------------
+bool qtJson::Document::isEmpty() const
+{
+  QTE_D_SHARED();
+  return d->nodes.isEmpty();
+}
+
+//-----------------------------------------------------------------------------
+int qtJson::Document::nodeCount() const
+{
+  QTE_D_SHARED();
+  return d->nodes.count();
+}
+
+//-----------------------------------------------------------------------------
+qtJson::Document::Node qtJson::Document::root() const
+{
+  QTE_D_SHARED();
+  return d->root;
+}
+
+//-----------------------------------------------------------------------------
+void qtJson::Document::setRoot(Node n)
+{
+  QTE_D_MUTABLE();
+  d->root = (d->node(n) ? n : -1);
+}
+
+//-----------------------------------------------------------------------------
+qtJson::Document::Node qtJson::Document::addNull()
+{
+  QTE_D_MUTABLE();
+  return d->addNode(NullType);
+}
+
+//-----------------------------------------------------------------------------
+qtJson::Document::Node qtJson::Document::addBool(bool value)
+{
+  QTE_D_MUTABLE();
+  const int n = d->addNode(BoolType);
+  d->nodes[n].value.b = value;
+  return n;
+}
+
+//-----------------------------------------------------------------------------
+qtJson::Document::Node qtJson::Document::addInteger(qint64 value)
+{
+  QTE_D_MUTABLE();
+  const int n = d->addNode(IntegerType);
+  d->nodes[n].value.i = value;
+  return n;
+}
+
+//-----------------------------------------------------------------------------
+qtJson::Document::Node qtJson::Document::addUnsignedInteger(quint64 value)
+{
+  QTE_D_MUTABLE();
+  const int n = d->addNode(IntegerType, 0, DocumentData::UnsignedFlag);
+  d->nodes[n].value.u = value;
+  return n;
+}
+
+//-----------------------------------------------------------------------------
+qtJson::Document::Node qtJson::Document::addReal(double value)
+{
+  QTE_D_MUTABLE();
+  const int n = d->addNode(RealType);
+  d->nodes[n].value.r = value;
+  return n;
+}
+
+//-----------------------------------------------------------------------------
+qtJson::Document::Node qtJson::Document::addFloat(float value)
+{
+  QTE_D_MUTABLE();
+  const int n = d->addNode(RealType, 0, DocumentData::SingleFlag);
+  d->nodes[n].value.r = static_cast<double>(value);
+  return n;
+}
+
+//-----------------------------------------------------------------------------
+qtJson::Document::Node qtJson::Document::addString(const QString& value)
+{
+  QTE_D_MUTABLE();
+  return d->addString(value);
+}
+
+//-----------------------------------------------------------------------------
+qtJson::Document::Node qtJson::Document::addEncoded(const JsonData& data)
+{
+  QTE_D_MUTABLE();
+  const int n = d->addNode(EncodedType, data.size());
+  d->nodes[n].value.offset = d->encoded.size();
+  d->encoded.append(data);
+  return n;
+}
+
+//-----------------------------------------------------------------------------
+qtJson::Document::Node qtJson::Document::addArray(const QVector<Node>& items)
+{
+  // Only nodes that already exist may be referenced, which keeps the tree
+  // free of cycles and dangling references
+  const int count = this->nodeCount();
+  foreach (auto const n, items)
+    {
+    if (n < 0 || n >= count)
+      {
+      return -1;
+      }
+    }
+
+  QTE_D_MUTABLE();
+  return d->addContainer(ArrayType, items);
+}
+
+//-----------------------------------------------------------------------------
+qtJson::Document::Node qtJson::Document::addObject(
+  const QVector<QPair<QString, Node>>& members)
+{
+  const int count = this->nodeCount();
+  foreach (auto const& member, members)
+    {
+    if (member.second < 0 || member.second >= count)
+      {
+      return -1;
+      }
+    }
+
+  QTE_D_MUTABLE();
+  return d->addObject(members);
+}
+
+//-----------------------------------------------------------------------------
+qtJson::Document::Type qtJson::Document::type(Node n) const
+{
+  QTE_D_SHARED();
+  const auto* const p = d->node(n);
+  return (p ? static_cast<Type>(p->type) : NullType);
+}
+
+//-----------------------------------------------------------------------------
+bool qtJson::Document::toBool(Node n) const
+{
+  QTE_D_SHARED();
+  const auto* const p = d->node(n, BoolType);
+  return (p && p->value.b);
+}
+
+//-----------------------------------------------------------------------------
+qint64 qtJson::Document::toInteger(Node n) const
+{
+  QTE_D_SHARED();
+  const auto* const p = d->node(n);
+  if (p && p->type == IntegerType)
+    {
+    return p->value.i;
+    }
+  if (p && p->type == RealType)
+    {
+    return static_cast<qint64>(p->value.r);
+    }
+  return 0;
+}
+
+//-----------------------------------------------------------------------------
+double qtJson::Document::toReal(Node n) const
+{
+  QTE_D_SHARED();
+  const auto* const p = d->node(n);
+  if (p && p->type == RealType)
+    {
+    return p->value.r;
+    }
+  if (p && p->type == IntegerType)
+    {
+    return (p->flags & DocumentData::UnsignedFlag
+            ? static_cast<double>(p->value.u)
+            : static_cast<double>(p->value.i));
+    }
+  return 0.0;
+}
+
+//-----------------------------------------------------------------------------
+QString qtJson::Document::toString(Node n) const
+{
+  QTE_D_SHARED();
+  const auto* const p = d->node(n, StringType);
+  return (p ? d->string(*p) : QString());
+}
+
+//-----------------------------------------------------------------------------
+qtJson::JsonData qtJson::Document::toEncoded(Node n) const
+{
+  QTE_D_SHARED();
+  const auto* const p = d->node(n, EncodedType);
+  return (p ? d->encoded.mid(p->value.offset, p->count) : JsonData());
+}
+
+//-----------------------------------------------------------------------------
+int qtJson::Document::count(Node n) const
+{
+  QTE_D_SHARED();
+  const auto* const p = d->node(n);
+  return (p && (p->type == ArrayType || p->type == ObjectType) ? p->count : 0);
+}
+
+//-----------------------------------------------------------------------------
+qtJson::Document::Node qtJson::Document::item(Node array, int index) const
+{
+  QTE_D_SHARED();
+  const auto* const p = d->node(array, ArrayType);
+  if (!p || index < 0 || index >= p->count)
+    {
+    return -1;
+    }
+  return d->children[p->value.offset + index];
+}
+
+//-----------------------------------------------------------------------------
+QString qtJson::Document::key(Node object, int index) const
+{
+  QTE_D_SHARED();
+  const auto* const p = d->node(object, ObjectType);
+  if (!p || index < 0 || index >= p->count)
+    {
+    return {};
+    }
+  return d->string(d->nodes[d->children[p->value.offset + (2 * index)]]);
+}
+
+//-----------------------------------------------------------------------------
+qtJson::Document::Node qtJson::Document::member(Node object, int index) const
+{
+  QTE_D_SHARED();
+  const auto* const p = d->node(object, ObjectType);
+  if (!p || index < 0 || index >= p->count)
+    {
+    return -1;
+    }
+  return d->children[p->value.offset + (2 * index) + 1];
+}
+
+//-----------------------------------------------------------------------------
+qtJson::Document::Node qtJson::Document::find(
+  Node object, const QString& key) const
+{
+  QTE_D_SHARED();
+  const auto* const p = d->node(object, ObjectType);
+  if (!p)
+    {
+    return -1;
+    }
+
+  // Members are sorted by key; compare against the text arena directly
+  const int* const c = d->children.constData() + p->value.offset;
+  const auto compare = [d, c](int i, const QString& other) {
+    const auto& k = d->nodes[c[2 * i]];
+    return QStringRef(&d->text, k.value.offset, k.count).compare(other);
+  };
+
+  int lower = 0, upper = p->count;
+  while (lower < upper)
+    {
+    const int mid = lower + ((upper - lower) / 2);
+    if (compare(mid, key) < 0)
+      {
+      lower = mid + 1;
+      }
+    else
+      {
+      upper = mid;
+      }
+    }
+
+  return (lower < p->count && compare(lower, key) == 0
+          ? c[(2 * lower) + 1] : -1);
+}
+
+//-----------------------------------------------------------------------------
+qtJson::JsonData qtJson::encode(QString value)
+{
+  JsonData result;
+  result.reserve(value.length() + 2);
+
+  Writer writer(&result);
+  writer.writeString(value);
+
+  return result;
+}
+
+//-----------------------------------------------------------------------------
+qtJson::JsonData qtJson::encode(const qtJson::Array& array, RealFormat format)
+{
+  JsonData result;
+
+  Writer writer(&result);
+  writer.setRealFormat(format);
+  writer.beginArray();
+  foreach (auto const& value, array)
+    {
+    writer.writeValue(value);
+    }
+  writer.endArray();
+
+  return result;
+}
+
+//-----------------------------------------------------------------------------
+qtJson::JsonData qtJson::encode(
+  const qtJson::Object& object, RealFormat format)
+{
+  JsonData result;
+
+  Writer writer(&result);
+  writer.setRealFormat(format);
+  writer.beginObject();
+  foreach (auto const iter, qtEnumerate(object))
+    {
+    writer.writeKey(iter.key());
+    writer.writeValue(iter.value());
+    }
+  writer.endObject();
+
+  return result;
+}
+
+//-----------------------------------------------------------------------------
+qtJson::JsonData qtJson::encode(const Value& value, RealFormat format)
+{
+  JsonData result;
+
+  Writer writer(&result);
+  writer.setRealFormat(format);
+  writer.writeValue(value);
+
+  return result;
+}
+
+//-----------------------------------------------------------------------------
+qtJson::JsonData qtJson::encode(const Document& document, RealFormat format)
+{
+  JsonData result;
+
+  Writer writer(&result);
+  writer.setRealFormat(format);
+  document.write(writer);
+
+  return result;
+}
@@ -8,16 +8,25 @@
 /// \file
 
 #include <QMap>
+#include <QPair>
+#include <QScopedPointer>
+#include <QSharedDataPointer>
 #include <QString>
 #include <QVariant>
+#include <QVector>
 
 #include <qtExports.h>
 
-/// Methods for encoding JSON.
+#include "../core/qtGlobal.h"
+
+class QIODevice;
+
+/// Methods for encoding and decoding JSON.
 ///
 /// This namespace provides methods for converting C++ structures into JSON
-/// strings. An arbitrary value is represented as a ::QVariant, which may be
-/// a JSON array or object, or a simple value type. An array is represented
+/// strings, and a streaming parser for reading JSON. An arbitrary value is
+/// represented as a ::QVariant, which may be a JSON array or object, or a
+/// simple value type (see also qtJson::Document). An array is represented
 /// as a list of values (i.e. ::QList&lt;::QVariant&gt;), while an object is
 /// represented as an ordered set of keys and values (i.e.
 /// ::QMap&lt;::QString, ::QVariant&gt;); both of which are themselves value
@@ -47,6 +56,15 @@ namespace qtJson
   /// Convenience typedef for an encoded JSON string.
   typedef QByteArray JsonData;
 
+  /// Format used when encoding real numbers.
+  enum RealFormat
+  {
+    /// Encode reals using the fewest digits that read back as the same value.
+    ShortestReal,
+    /// Encode reals with 8 significant digits, as in earlier versions.
+    LegacyReal
+  };
+
   /// Encode a string into JSON representation.
   ///
   /// The returned string is enclosed in quotes, and special characters have
@@ -54,10 +72,10 @@ namespace qtJson
   QTE_EXPORT JsonData encode(QString);
 
   /// Encode an array into JSON representation.
-  QTE_EXPORT JsonData encode(const Array&);
+  QTE_EXPORT JsonData encode(const Array&, RealFormat = ShortestReal);
 
   /// Encode an object into JSON representation.
-  QTE_EXPORT JsonData encode(const Object&);
+  QTE_EXPORT JsonData encode(const Object&, RealFormat = ShortestReal);
 
   /// Encode a value into JSON representation.
   ///
@@ -66,15 +84,323 @@ namespace qtJson
   /// \li If the value is invalid (QVariant::isNull returns \c true), the
   ///     result is "null".
   /// \li If the value is a boolean, the result is "true" or "false".
-  /// \li If the value is a numeric type, result is equivalent to
-  ///     QByteArray::number(value) for integers and finite reals, "null" for
-  ///     infinities or NaN's.
+  /// \li If the value is an integer type, the result is equivalent to
+  ///     QByteArray::number(value).
+  /// \li If the value is a real type, the result is the shortest
+  ///     representation that reads back as the same value (of the same type),
+  ///     or, if \p format is qtJson::LegacyReal, is equivalent to
+  ///     QByteArray::number(value, 'g', 8). Infinities and NaN's are encoded
+  ///     as "null".
   /// \li If the value is a QString, qtJson::Array, or qtJson::Object, the
   ///     result is equivalent to calling the respective overload of
   ///     \c qtJson::encode.
   /// \li If the value is a JsonData, it is returned unaltered.
   /// \li For all other values, the result is an empty JsonData.
-  QTE_EXPORT JsonData encode(const Value&);
+  QTE_EXPORT JsonData encode(const Value&, RealFormat = ShortestReal);
+
+  class WriterPrivate;
+
+  /// Streaming JSON writer.
+  ///
+  /// This class writes JSON incrementally, either by appending to a byte
+  /// array, or (buffered) to a device. Arrays and objects are written by
+  /// bracketing their contents with calls to beginArray() / endArray() or
+  /// beginObject() / endObject(); within an object, each value must be
+  /// preceded by a call to writeKey(). Values are encoded as by
+  /// qtJson::encode.
+  ///
+  /// Because the output is written as it is produced, large documents can be
+  /// written in linear time, without building intermediate encoded values.
+  /// The writer does not validate the structure of the document; the caller
+  /// is responsible for balancing calls to the begin and end methods.
+  class QTE_EXPORT Writer
+  {
+  public:
+    /// Create a writer that appends to \p buffer.
+    explicit Writer(QByteArray* buffer);
+
+    /// Create a writer that writes to \p device.
+    ///
+    /// Output is buffered, and written to the device when the buffer fills,
+    /// when flush() is called, or when the writer is destroyed.
+    explicit Writer(QIODevice* device);
+
+    ~Writer();
+
+    void beginArray();
+    void endArray();
+
+    void beginObject();
+    void endObject();
+
+    /// Write the key of the next member of an object.
+    void writeKey(const QString& key);
+
+    void writeNull();
+    void writeBool(bool value);
+    void writeInteger(qint64 value);
+    void writeUnsignedInteger(quint64 value);
+    void writeReal(double value);
+    void writeFloat(float value);
+    void writeString(const QString& value);
+
+    /// Write already-encoded JSON data.
+    void writeEncoded(const JsonData& data);
+
+    /// Write an arbitrary value, as by qtJson::encode.
+    void writeValue(const Value& value);
+
+    /// Get the format used to write real numbers.
+    RealFormat realFormat() const;
+
+    /// Set the format used to write real numbers.
+    ///
+    /// The default is qtJson::ShortestReal.
+    void setRealFormat(RealFormat);
+
+    /// Write buffered output to the device.
+    ///
+    /// \return \c true if all output so far has been written successfully
+    ///         (always \c true when writing to a byte array).
+    bool flush();
+
+  private:
+    QTE_DECLARE_PRIVATE(Writer)
+    QTE_DECLARE_PRIVATE_RPTR(Writer)
+    QTE_DISABLE_COPY(Writer)
+  };
+
+  class ReaderPrivate;
+
+  /// Streaming (pull) JSON parser.
+  ///
+  /// This class tokenizes UTF-8 encoded JSON incrementally, either from a
+  /// byte array, or from a device which is read in fixed-size chunks. Each
+  /// call to readNext() advances to the next token (the start or end of an
+  /// array or object, an object key, or a simple value), so that documents
+  /// can be processed without building a tree of the entire document, and
+  /// with memory use bounded by the size of the largest single token.
+  ///
+  /// Where a tree is convenient for part of a document, readValue() builds a
+  /// qtJson::Value from the current token and (for arrays and objects) its
+  /// contents, and skipValue() discards them.
+  ///
+  /// A device is read synchronously; for sequential devices, the reader will
+  /// wait for more data to become available.
+  class QTE_EXPORT Reader
+  {
+  public:
+    enum TokenType
+    {
+      NoToken,
+      Invalid,
+      StartArray,
+      EndArray,
+      StartObject,
+      EndObject,
+      Key,
+      String,
+      Number,
+      Bool,
+      Null,
+      EndDocument
+    };
+
+    /// Create a reader that parses \p data.
+    explicit Reader(const QByteArray& data);
+
+    /// Create a reader that parses data read from \p device.
+    explicit Reader(QIODevice* device);
+
+    ~Reader();
+
+    /// Advance to the next token.
+    ///
+    /// \return The type of the new current token. If the input is not valid
+    ///         JSON, the result is Reader::Invalid, and all further calls
+    ///         will return the same.
+    TokenType readNext();
+
+    /// Get the type of the current token.
+    TokenType tokenType() const;
+
+    /// Test if the end of the document has been reached, or an error has
+    /// occurred.
+    bool atEnd() const;
+
+    bool hasError() const;
+    QString errorString() const;
+
+    /// Get the offset, in bytes from the start of the input, of the current
+    /// token, or of the error if an error has occurred.
+    qint64 offset() const;
+
+    /// Get the number of arrays and objects containing the current position.
+    int depth() const;
+
+    /// Get the value of the current Reader::Key or Reader::String token.
+    QString string() const;
+
+    /// Get the value of the current Reader::Number token.
+    double number() const;
+
+    /// Test if the current Reader::Number token is an integer.
+    ///
+    /// This returns \c true if the number has no fraction or exponent, and is
+    /// representable as a \c qint64.
+    bool isInteger() const;
+
+    /// Get the value of the current Reader::Number token as an integer.
+    qint64 integer() const;
+
+    /// Get the value of the current Reader::Bool token.
+    bool boolean() const;
+
+    /// Skip the current value.
+    ///
+    /// If the current token is the start of an array or object, this reads
+    /// up to and including the matching end token. Otherwise, this does
+    /// nothing.
+    ///
+    /// \return \c true if no error has occurred.
+    bool skipValue();
+
+    /// Read the current value.
+    ///
+    /// This builds a value from the current token; if the token is the start
+    /// of an array or object, the entire array or object is read (up to and
+    /// including the matching end token). Integers are given as \c qint64,
+    /// and other numbers as \c double. If the current token is not the start
+    /// of a value, or an error occurs, the result is an invalid value.
+    Value readValue();
+
+  private:
+    QTE_DECLARE_PRIVATE(Reader)
+    QTE_DECLARE_PRIVATE_RPTR(Reader)
+    QTE_DISABLE_COPY(Reader)
+  };
+
+  class DocumentData;
+
+  /// Compact JSON document.
+  ///
+  /// This class stores a tree of JSON values in a compact, typed form, as an
+  /// alternative to the ::QVariant based representation. All nodes are held
+  /// in a single array, and the contents of arrays and objects and the text
+  /// of strings are held in shared arenas, so that individual values do not
+  /// require separate allocations. The members of an object are sorted by key
+  /// (as in a qtJson::Object), and are found by binary search.
+  ///
+  /// Nodes are identified by index, and are added bottom-up; that is, the
+  /// items of an array or the values of an object must be added before the
+  /// array or object itself. Documents are implicitly shared.
+  class QTE_EXPORT Document
+  {
+  public:
+    enum Type
+    {
+      NullType,
+      BoolType,
+      IntegerType,
+      RealType,
+      StringType,
+      EncodedType,
+      ArrayType,
+      ObjectType
+    };
+
+    /// Identifier of a node within a document.
+    typedef int Node;
+
+    Document();
+    Document(const Document&);
+    ~Document();
+
+    Document& operator=(const Document&);
+
+    /// Create a document from a ::QVariant based value.
+    ///
+    /// Values of types not supported by qtJson::encode are stored as null.
+    static Document fromValue(const Value&);
+
+    /// Create a document from the current value of \p reader.
+    ///
+    /// This reads the current value as by Reader::readValue. If an error
+    /// occurs, the result is an empty document.
+    static Document read(Reader& reader);
+
+    /// Convert the root node to a ::QVariant based value.
+    Value toValue() const;
+
+    /// Convert a node to a ::QVariant based value.
+    Value toValue(Node) const;
+
+    /// Write the root node (or "null", if the document is empty).
+    void write(Writer&) const;
+
+    bool isEmpty() const;
+    int nodeCount() const;
+
+    /// Get the root node, or -1 if the document is empty.
+    Node root() const;
+    void setRoot(Node);
+
+    Node addNull();
+    Node addBool(bool);
+    Node addInteger(qint64);
+    Node addUnsignedInteger(quint64);
+    Node addReal(double);
+    Node addFloat(float);
+    Node addString(const QString&);
+    Node addEncoded(const JsonData&);
+
+    /// Add an array.
+    ///
+    /// The items must be nodes already in the document; if any is not, no
+    /// array is added, and the result is -1.
+    Node addArray(const QVector<Node>& items);
+
+    /// Add an object.
+    ///
+    /// The members need not be sorted. If more than one member has the same
+    /// key, the last such member is used. The member values must be nodes
+    /// already in the document; if any is not, no object is added, and the
+    /// result is -1.
+    Node addObject(const QVector<QPair<QString, Node>>& members);
+
+    Type type(Node) const;
+    bool toBool(Node) const;
+    qint64 toInteger(Node) const;
+    double toReal(Node) const;
+    QString toString(Node) const;
+    JsonData toEncoded(Node) const;
+
+    /// Get the number of items of an array, or members of an object.
+    int count(Node) const;
+
+    /// Get the item at \p index of an array.
+    Node item(Node array, int index) const;
+
+    /// Get the key of the member at \p index of an object.
+    QString key(Node object, int index) const;
+
+    /// Get the value of the member at \p index of an object.
+    Node member(Node object, int index) const;
+
+    /// Find the value of the member of an object with the specified key.
+    ///
+    /// \return The value node, or -1 if the object has no such member.
+    Node find(Node object, const QString& key) const;
+
+  protected:
+    QTE_DECLARE_SHARED_PTR(Document)
+
+  private:
+    QTE_DECLARE_SHARED(Document)
+  };
+
+  /// Encode a document into JSON representation.
+  QTE_EXPORT JsonData encode(const Document&, RealFormat = ShortestReal);
 }
 
 #endif
@@ -4,8 +4,11 @@
 
 #include "qtNaturalSort.h"
 
+#include <QPair>
 #include <QVector>
 
+#include <algorithm>
+
 namespace qtNaturalSort
 {
 
@@ -18,11 +21,21 @@ struct Char
     uint codePoint;
     short units;
 
+    // ASCII is handled directly, as most strings are mostly ASCII, and the
+    // Unicode property lookups are comparatively expensive
+
     bool isDigit() const
-    { return QChar::category(codePoint) == QChar::Number_DecimalDigit; }
+    {
+        return (codePoint < 0x80
+                ? codePoint - '0' < 10u
+                : QChar::category(codePoint) == QChar::Number_DecimalDigit);
+    }
 
     int digitValue() const
-    { return QChar::digitValue(codePoint); }
+    {
+        return (codePoint < 0x80 ? static_cast<int>(codePoint - '0')
+                                 : QChar::digitValue(codePoint));
+    }
 };
 
 //-----------------------------------------------------------------------------
@@ -55,6 +68,27 @@ Char getChar(QStringRef const& s, int pos)
     return {c1.unicode(), 1};
 }
 
+//-----------------------------------------------------------------------------
+Char getChar(QChar const* s, int n, int pos)
+{
+    auto const& c1 = s[pos];
+    if (c1.isHighSurrogate() && pos + 1 < n)
+    {
+        auto const& c2 = s[pos + 1];
+        auto const b1 = c1.unicode() - 0xd800u;
+        auto const b2 = c2.unicode() - 0xdc00u;
+        return {0x10000u + (b1 << 10) + b2, 2};
+    }
+
+    return {c1.unicode(), 1};
+}
+
+//-----------------------------------------------------------------------------
+bool isDigitAt(QChar const* s, int n, int pos, Char& c)
+{
+    return pos < n && (c = getChar(s, n, pos)).isDigit();
+}
+
 //-----------------------------------------------------------------------------
 int compareNumbers(StringGroup const& g1, StringGroup const& g2)
 {
@@ -80,6 +114,38 @@ int compareNumbers(StringGroup const& g1, StringGroup const& g2)
     return 0;
 }
 
+//-----------------------------------------------------------------------------
+void appendKeyUnit(QByteArray& key, uint unit)
+{
+    // Units are stored big-endian so that keys can be compared bytewise
+    key.append(static_cast<char>((unit >> 8) & 0xff));
+    key.append(static_cast<char>(unit & 0xff));
+}
+
+//-----------------------------------------------------------------------------
+void appendKeyCount(QByteArray& key, int count)
+{
+    // Counts are stored as two units; the high unit is offset so that a count
+    // is always greater than the key's end-of-groups marker
+    appendKeyUnit(key, (static_cast<uint>(count) >> 16) + 1);
+    appendKeyUnit(key, static_cast<uint>(count) & 0xffff);
+}
+
+//-----------------------------------------------------------------------------
+void appendKeyText(QByteArray& key, QStringRef const& text)
+{
+    // Escape 0 and 1 so that 0 can be used as the group terminator, while
+    // preserving the relative order of all code units
+    foreach (auto const c, text)
+    {
+        auto const u = c.unicode();
+        if (u < 2)
+            appendKeyUnit(key, 1);
+        appendKeyUnit(key, u < 2 ? u + 1 : u);
+    }
+    appendKeyUnit(key, 0);
+}
+
 } // namespace <anonymous>
 
 //-----------------------------------------------------------------------------
@@ -195,4 +261,158 @@ bool compare::operator()(QString const& s1, QString const& s2)
   return (s1 < s2);
 }
 
+//-----------------------------------------------------------------------------
+QByteArray sortKey(QString const& s)
+{
+    // The key mirrors the order of tests in compare: first the groups (text
+    // groups as escaped, terminated code units; numeric groups as the count of
+    // significant digits followed by their values), then the leading zero
+    // counts of the numeric groups, and finally the raw code units
+    auto const& groups = crack(s);
+    auto const n = groups.count();
+
+    QByteArray key;
+    key.reserve(4 * (s.length() + n + 1));
+
+    for (decltype(n + 0) i = 0; i < n; ++i)
+    {
+        auto const& g = groups[i];
+        if (i % 2 == 0)
+        {
+            appendKeyText(key, g.characters);
+            continue;
+        }
+
+        appendKeyCount(key, g.significantDigits);
+
+        auto const k = g.characters.length();
+        for (decltype(k + 0) j = 0; j < k;)
+        {
+            auto const& c = getChar(g.characters, j);
+            appendKeyUnit(key, static_cast<uint>(c.digitValue()));
+            j += c.units;
+        }
+    }
+
+    // Mark the end of the groups; a string with fewer groups (and otherwise
+    // equal) sorts first
+    appendKeyUnit(key, 0);
+
+    for (decltype(n + 0) i = 1; i < n; i += 2)
+        appendKeyCount(key, groups[i].leadingZeros);
+
+    foreach (auto const c, s)
+        appendKeyUnit(key, c.unicode());
+
+    return key;
+}
+
+//-----------------------------------------------------------------------------
+void sort(QStringList& list)
+{
+    QVector<QPair<QByteArray, int>> keys;
+    keys.reserve(list.count());
+    for (int i = 0; i < list.count(); ++i)
+        keys.append(qMakePair(sortKey(list[i]), i));
+
+    std::sort(keys.begin(), keys.end());
+
+    QStringList sorted;
+    sorted.reserve(list.count());
+    foreach (auto const& k, keys)
+        sorted.append(list[k.second]);
+
+    list.swap(sorted);
+}
+
+//-----------------------------------------------------------------------------
+int compareStreaming(QString const& s1, QString const& s2)
+{
+    auto const* const d1 = s1.constData();
+    auto const* const d2 = s2.constData();
+    auto const n1 = s1.length();
+    auto const n2 = s2.length();
+
+    int i1 = 0;
+    int i2 = 0;
+    int ri = 0;
+    Char c1{0, 1}, c2{0, 1};
+
+    for (;;)
+    {
+        // Compare non-numeric groups; if one ends first, it is a prefix of the
+        // other, and so is lesser
+        for (;;)
+        {
+            auto const t1 = (i1 < n1 && !isDigitAt(d1, n1, i1, c1));
+            auto const t2 = (i2 < n2 && !isDigitAt(d2, n2, i2, c2));
+            if (t1 && t2)
+            {
+                if (auto const r = d1[i1].unicode() - d2[i2].unicode())
+                    return r;
+                ++i1;
+                ++i2;
+            }
+            else if (t1 != t2)
+            {
+                return (t1 ? 1 : -1);
+            }
+            else
+            {
+                break;
+            }
+        }
+
+        // If one string has no more groups, it is lesser
+        auto const e1 = (i1 >= n1);
+        auto const e2 = (i2 >= n2);
+        if (e1 || e2)
+        {
+            if (e1 != e2)
+                return (e1 ? -1 : 1);
+            break;
+        }
+
+        // Skip leading zeros
+        auto const z1 = i1;
+        auto const z2 = i2;
+        while (isDigitAt(d1, n1, i1, c1) && c1.digitValue() == 0)
+            i1 += c1.units;
+        while (isDigitAt(d2, n2, i2, c2) && c2.digitValue() == 0)
+            i2 += c2.units;
+
+        // Compare numeric groups; if one has more significant digits, it is
+        // greater, otherwise the first differing digit decides
+        int rd = 0;
+        for (;;)
+        {
+            auto const g1 = isDigitAt(d1, n1, i1, c1);
+            auto const g2 = isDigitAt(d2, n2, i2, c2);
+            if (g1 && g2)
+            {
+                rd = (rd ? rd : c1.digitValue() - c2.digitValue());
+                i1 += c1.units;
+                i2 += c2.units;
+            }
+            else if (g1 != g2)
+            {
+                return (g1 ? 1 : -1);
+            }
+            else
+            {
+                break;
+            }
+        }
+
+        if (rd)
+            return rd;
+
+        // As in compare, note the first difference in leading zeros
+        ri = (ri ? ri : (i1 - z1) - (i2 - z2));
+    }
+
+    // Groups are identical; use leading zeros, and then lexicographical order
+    return (ri ? ri : s1.compare(s2));
+}
+
 } // namespace qtNaturalSort
@@ -7,7 +7,9 @@
 
 #include <qtExports.h>
 
+#include <QByteArray>
 #include <QString>
+#include <QStringList>
 
 template<typename T> class QVector;
 
@@ -80,6 +82,40 @@ namespace qtNaturalSort
     {
         bool operator()(QString const& s1, QString const& s2);
     };
+
+    /// Compare two strings "naturally".
+    ///
+    /// This function compares two strings using the same ordering as
+    /// qtNaturalSort::compare, but walks both strings in lockstep rather than
+    /// cracking them, stopping at the first difference. No memory is
+    /// allocated, which makes this preferable where keys cannot be
+    /// precomputed (e.g. when comparing live model data).
+    ///
+    /// \return
+    ///   A negative value if \p s1 is less than \p s2, zero if the strings are
+    ///   identical, or a positive value if \p s1 is greater than \p s2.
+    QTE_EXPORT int compareStreaming(QString const& s1, QString const& s2);
+
+    /// Compute a collation key for "natural" comparison of a string.
+    ///
+    /// This function encodes a string into a key such that comparing two keys
+    /// bytewise (i.e. using QByteArray's comparison operators, or \c memcmp
+    /// followed by comparing lengths) gives the same order as comparing the
+    /// original strings using qtNaturalSort::compare.
+    ///
+    /// Computing keys is more expensive than a single comparison, but when
+    /// sorting many strings, computing a key once per string is much cheaper
+    /// than cracking each string once per comparison.
+    ///
+    /// \sa qtNaturalSort::sort
+    QTE_EXPORT QByteArray sortKey(QString const& s);
+
+    /// Sort a list of strings "naturally".
+    ///
+    /// This sorts a list of strings in the order given by
+    /// qtNaturalSort::compare, using qtNaturalSort::sortKey to compute the
+    /// collation key of each string once.
+    QTE_EXPORT void sort(QStringList& list);
 } // namespace qtNaturalSort
 
 #endif
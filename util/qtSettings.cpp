@@ -8,12 +8,75 @@
 #include <QCoreApplication>
 #include <QSettings>
 #include <QHash>
+#include <QRunnable>
 #include <QSet>
+#include <QThreadPool>
+#include <QTimer>
+
+#include "../core/qtEnumerate.h"
 
 #include "qtAbstractSetting.h"
 
 QTE_IMPLEMENT_D_FUNC(qtSettings)
 
+namespace // anonymous
+{
+
+// Default time to wait for further commits before writing asynchronously
+// committed values
+const int defaultCommitDelay = 250;
+
+//-----------------------------------------------------------------------------
+QSettings::Scope settingsScope(qtSettings::Scope s)
+{
+  return (s.testFlag(qtSettings::UserScope) ? QSettings::UserScope
+                                            : QSettings::SystemScope);
+}
+
+//-----------------------------------------------------------------------------
+QString applicationName(qtSettings::Scope s)
+{
+  return (s.testFlag(qtSettings::ApplicationScope)
+          ? qApp->applicationName() : QString());
+}
+
+//-----------------------------------------------------------------------------
+struct PendingStore
+{
+  QSettings::Scope scope;
+  QString organization;
+  QString application;
+  QVariantHash values;
+};
+
+typedef QHash<qtSettings::Scope, PendingStore> PendingStores;
+
+//-----------------------------------------------------------------------------
+class CommitTask : public QRunnable
+{
+public:
+  explicit CommitTask(const PendingStores& stores) : stores(stores) {}
+  virtual void run() QTE_OVERRIDE;
+
+protected:
+  PendingStores stores;
+};
+
+//-----------------------------------------------------------------------------
+void CommitTask::run()
+{
+  // Use a QSettings instance that belongs to this thread
+  foreach (auto const& pending, this->stores)
+    {
+    QSettings store(pending.scope, pending.organization, pending.application);
+    foreach (auto const iter, qtEnumerate(pending.values))
+      store.setValue(iter.key(), iter.value());
+    store.sync();
+    }
+}
+
+} // namespace <anonymous>
+
 ///////////////////////////////////////////////////////////////////////////////
 
 //BEGIN qtSettingsPrivate
@@ -24,16 +87,39 @@ class qtSettingsPrivate
 public:
   class Setting;
 
+  qtSettingsPrivate();
   ~qtSettingsPrivate();
 
   QSettings& store(qtSettings::Scope);
+  PendingStore& pendingStore(qtSettings::Scope);
+  void dispatchCommit();
 
   QHash<qtSettings::Scope, QSettings*> stores;
   QHash<QString, qtAbstractSetting*> settings;
   QSet<QString> modifiedSettings;
   bool wasCommitted;
+
+  // Asynchronous commit; values are accumulated in pendingStores until the
+  // commit timer expires, and are then written by the commit pool
+  qtSettings::CommitMode commitMode;
+  PendingStores pendingStores;
+  QTimer commitTimer;
+  QThreadPool commitPool;
 };
 
+//-----------------------------------------------------------------------------
+qtSettingsPrivate::qtSettingsPrivate()
+  : wasCommitted(false), commitMode(qtSettings::SynchronousCommit)
+{
+  // Use a single thread, so that values are written in the order committed
+  this->commitPool.setMaxThreadCount(1);
+
+  this->commitTimer.setSingleShot(true);
+  this->commitTimer.setInterval(defaultCommitDelay);
+  QObject::connect(&this->commitTimer, &QTimer::timeout,
+                   [this]{ this->dispatchCommit(); });
+}
+
 //-----------------------------------------------------------------------------
 qtSettingsPrivate::~qtSettingsPrivate()
 {
@@ -46,12 +132,9 @@ QSettings& qtSettingsPrivate::store(qtSettings::Scope s)
 {
   if (!this->stores.contains(s))
     {
-    QSettings::Scope ss = (s.testFlag(qtSettings::UserScope)
-                           ? QSettings::UserScope
-                           : QSettings::SystemScope);
-    QString appName = (s.testFlag(qtSettings::ApplicationScope)
-                       ? qApp->applicationName() : QString());
-    QSettings* settings = new QSettings(ss, qApp->organizationName(), appName);
+    QSettings* settings =
+      new QSettings(settingsScope(s), qApp->organizationName(),
+                    applicationName(s));
     this->stores.insert(s, settings);
     return *settings;
     }
@@ -59,6 +142,33 @@ QSettings& qtSettingsPrivate::store(qtSettings::Scope s)
   return *this->stores[s];
 }
 
+//-----------------------------------------------------------------------------
+PendingStore& qtSettingsPrivate::pendingStore(qtSettings::Scope s)
+{
+  auto iter = this->pendingStores.find(s);
+  if (iter == this->pendingStores.end())
+    {
+    PendingStore pending;
+    pending.scope = settingsScope(s);
+    pending.organization = qApp->organizationName();
+    pending.application = applicationName(s);
+    iter = this->pendingStores.insert(s, pending);
+    }
+
+  return *iter;
+}
+
+//-----------------------------------------------------------------------------
+void qtSettingsPrivate::dispatchCommit()
+{
+  this->commitTimer.stop();
+  if (!this->pendingStores.isEmpty())
+    {
+    this->commitPool.start(new CommitTask(this->pendingStores));
+    this->pendingStores.clear();
+    }
+}
+
 //END qtSettingsPrivate
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -121,6 +231,7 @@ qtSettings::qtSettings() : d_ptr(new qtSettingsPrivate)
 qtSettings::~qtSettings()
 {
   QTE_D(qtSettings);
+  this->waitForCommit();
   delete d;
 }
 
@@ -148,22 +259,83 @@ void qtSettings::commit()
 
   QTE_D(qtSettings);
 
-  QSet<qtSettings::Scope> modifiedScopes;
-  foreach (auto const& key, d->modifiedSettings.values())
+  if (d->commitMode == AsynchronousCommit)
     {
-    qtAbstractSetting* s = d->settings[key];
-    qtSettings::Scope scope = s->scope();
-    s->commit(d->store(scope));
-    modifiedScopes.insert(scope);
+    // Take a snapshot of the modified values (merging them with any that are
+    // still pending), and restart the delay before they are written
+    foreach (auto const& key, d->modifiedSettings.values())
+      {
+      qtAbstractSetting* s = d->settings[key];
+      s->snapshot(d->pendingStore(s->scope()).values);
+      }
+
+    if (d->commitTimer.interval() > 0)
+      d->commitTimer.start();
+    else
+      d->dispatchCommit();
+    }
+  else
+    {
+    QSet<qtSettings::Scope> modifiedScopes;
+    foreach (auto const& key, d->modifiedSettings.values())
+      {
+      qtAbstractSetting* s = d->settings[key];
+      qtSettings::Scope scope = s->scope();
+      s->commit(d->store(scope));
+      modifiedScopes.insert(scope);
+      }
+
+    foreach (auto const s, modifiedScopes)
+      d->store(s).sync();
     }
-
-  foreach (auto const s, modifiedScopes)
-    d->store(s).sync();
 
   d->modifiedSettings.clear();
   d->wasCommitted = true;
 }
 
+//-----------------------------------------------------------------------------
+qtSettings::CommitMode qtSettings::commitMode() const
+{
+  QTE_D_CONST(qtSettings);
+  return d->commitMode;
+}
+
+//-----------------------------------------------------------------------------
+void qtSettings::setCommitMode(CommitMode mode)
+{
+  QTE_D(qtSettings);
+
+  // Finish any asynchronous commit before switching to synchronous mode, so
+  // that pending values do not overwrite later ones
+  if (mode == SynchronousCommit)
+    {
+    this->waitForCommit();
+    }
+  d->commitMode = mode;
+}
+
+//-----------------------------------------------------------------------------
+int qtSettings::commitDelay() const
+{
+  QTE_D_CONST(qtSettings);
+  return d->commitTimer.interval();
+}
+
+//-----------------------------------------------------------------------------
+void qtSettings::setCommitDelay(int msec)
+{
+  QTE_D(qtSettings);
+  d->commitTimer.setInterval(qMax(0, msec));
+}
+
+//-----------------------------------------------------------------------------
+void qtSettings::waitForCommit()
+{
+  QTE_D(qtSettings);
+  d->dispatchCommit();
+  d->commitPool.waitForDone();
+}
+
 //-----------------------------------------------------------------------------
 void qtSettings::discard()
 {
@@ -180,6 +352,12 @@ void qtSettings::clear()
 {
   QTE_D(qtSettings);
 
+  // Drop any pending asynchronous commit, and wait for any that is being
+  // written, so that the values are not written after the stores are cleared
+  d->commitTimer.stop();
+  d->pendingStores.clear();
+  d->commitPool.waitForDone();
+
   d->settings.clear();
   d->modifiedSettings.clear();
 
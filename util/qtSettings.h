@@ -30,6 +30,21 @@ public:
     };
   Q_DECLARE_FLAGS(Scope, ScopeFlag)
 
+  enum CommitMode
+    {
+    /// Write and synchronize modified settings before commit() returns.
+    SynchronousCommit,
+    /// Write modified settings on a background thread.
+    ///
+    /// In this mode, commit() takes a snapshot of the modified values and
+    /// returns immediately. The values are written, and the affected stores
+    /// synchronized, on a background thread once no further commit has been
+    /// made for the commit delay, so that rapid successive commits result in
+    /// a single write. Use waitForCommit() to ensure that all committed values
+    /// have been written.
+    AsynchronousCommit
+    };
+
   qtSettings();
   virtual ~qtSettings();
 
@@ -40,6 +55,20 @@ public:
   void discard();
   void clear();
 
+  CommitMode commitMode() const;
+  void setCommitMode(CommitMode);
+
+  /// Get the time, in milliseconds, to wait for further commits before
+  /// writing asynchronously committed values.
+  int commitDelay() const;
+  void setCommitDelay(int msec);
+
+  /// Write any asynchronously committed values that are still pending, and
+  /// wait until all such values have been written.
+  ///
+  /// This is called automatically when the qtSettings is destroyed.
+  void waitForCommit();
+
 protected:
   QTE_DECLARE_PRIVATE_PTR(qtSettings)
 
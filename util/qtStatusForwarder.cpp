@@ -4,8 +4,106 @@
 
 #include "qtStatusForwarder.h"
 
+#include <QHash>
+
+QTE_IMPLEMENT_D_FUNC(qtStatusForwarder)
+
+//-----------------------------------------------------------------------------
+class qtStatusForwarderPrivate
+{
+public:
+  struct Child
+    {
+    Child(qreal weight = 1.0)
+      : weight(weight), progress(-1.0), destroyed(false) {}
+
+    qreal weight;
+    qreal progress; // negative if not started or indeterminate
+    bool destroyed;
+    };
+
+  qtStatusForwarderPrivate(qtStatusForwarder* q)
+    : q_ptr(q), progressMode(qtStatusForwarder::ForwardProgress),
+      aggregating(false) {}
+
+  void setProgress(const QObject* notifier, qreal progress);
+  void emitAggregateProgress();
+
+protected:
+  QTE_DECLARE_PUBLIC_PTR(qtStatusForwarder)
+
+  qtStatusForwarder::ProgressMode progressMode;
+  QHash<const QObject*, Child> children;
+
+  // True from the first progress report until every notifier is complete
+  bool aggregating;
+
+private:
+  QTE_DECLARE_PUBLIC(qtStatusForwarder)
+};
+
+//-----------------------------------------------------------------------------
+void qtStatusForwarderPrivate::setProgress(
+  const QObject* notifier, qreal progress)
+{
+  auto const iter = this->children.find(notifier);
+  if (iter != this->children.end())
+    {
+    iter->progress = progress;
+    this->aggregating = true;
+    }
+}
+
+//-----------------------------------------------------------------------------
+void qtStatusForwarderPrivate::emitAggregateProgress()
+{
+  QTE_Q(qtStatusForwarder);
+
+  // Combine the progress of all notifiers
+  qreal total = 0.0, weight = 0.0;
+  bool done = true, determinate = false;
+  foreach (auto const& child, this->children)
+    {
+    weight += child.weight;
+    if (child.progress >= 0.0)
+      {
+      total += child.weight * qMin(child.progress, 1.0);
+      determinate = true;
+      }
+    done = done && (child.progress >= 1.0);
+    }
+
+  if (done)
+    {
+    // All notifiers are complete; reset for the next aggregation, forgetting
+    // any notifiers that no longer exist
+    auto iter = this->children.begin();
+    while (iter != this->children.end())
+      {
+      if (iter->destroyed)
+        {
+        iter = this->children.erase(iter);
+        }
+      else
+        {
+        iter->progress = -1.0;
+        ++iter;
+        }
+      }
+    this->aggregating = false;
+    emit q->progressAvailable(q->statusSource());
+    }
+  else
+    {
+    const qreal combined =
+      (determinate && weight > 0.0 ? total / weight : -1.0);
+    emit q->progressAvailable(q->statusSource(), true, combined);
+    }
+}
+
 //-----------------------------------------------------------------------------
 qtStatusForwarder::qtStatusForwarder()
+  : d_ptr(new qtStatusForwarderPrivate(this))
 {
 }
 
@@ -15,14 +113,34 @@ qtStatusForwarder::~qtStatusForwarder()
 }
 
 //-----------------------------------------------------------------------------
-void qtStatusForwarder::connect(qtStatusNotifier* other)
+void qtStatusForwarder::setProgressMode(ProgressMode mode)
 {
+  QTE_D(qtStatusForwarder);
+  d->progressMode = mode;
+}
+
+//-----------------------------------------------------------------------------
+qtStatusForwarder::ProgressMode qtStatusForwarder::progressMode() const
+{
+  QTE_D_CONST(qtStatusForwarder);
+  return d->progressMode;
+}
+
+//-----------------------------------------------------------------------------
+void qtStatusForwarder::connect(qtStatusNotifier* other, qreal weight)
+{
+  QTE_D(qtStatusForwarder);
+
+  d->children.insert(other, qMax(0.0, weight));
+
   connect(other, SIGNAL(statusMessageAvailable(qtStatusSource, QString)),
           this, SLOT(forwardStatusMessage(qtStatusSource, QString)));
   connect(other, SIGNAL(progressAvailable(qtStatusSource, bool, qreal)),
           this, SLOT(forwardProgress(qtStatusSource, bool, qreal)));
   connect(other, SIGNAL(progressAvailable(qtStatusSource, bool, int, int)),
           this, SLOT(forwardProgress(qtStatusSource, bool, int, int)));
+  connect(other, SIGNAL(destroyed(QObject*)),
+          this, SLOT(notifierDestroyed(QObject*)));
 }
 
 //-----------------------------------------------------------------------------
@@ -37,15 +155,69 @@ void qtStatusForwarder::forwardStatusMessage(
 void qtStatusForwarder::forwardProgress(
   qtStatusSource ss, bool available, qreal progress)
 {
+  QTE_D(qtStatusForwarder);
+
   Q_UNUSED(ss)
-  emit this->progressAvailable(this->statusSource(), available, progress);
+  if (d->progressMode == ForwardProgress)
+    {
+    emit this->progressAvailable(this->statusSource(), available, progress);
+    return;
+    }
+
+  // Record the notifier's progress; clearing progress means the notifier is
+  // done
+  d->setProgress(this->sender(), available ? progress : 1.0);
+  d->emitAggregateProgress();
 }
 
 //-----------------------------------------------------------------------------
 void qtStatusForwarder::forwardProgress(
   qtStatusSource ss, bool available, int progressValue, int progressSteps)
 {
-  Q_UNUSED(ss)
-  emit this->progressAvailable(this->statusSource(), available,
-                               progressValue, progressSteps);
+  QTE_D(qtStatusForwarder);
+
+  if (d->progressMode == ForwardProgress)
+    {
+    emit this->progressAvailable(this->statusSource(), available,
+                                 progressValue, progressSteps);
+    return;
+    }
+
+  const qreal progress =
+    (progressSteps > 0 && progressValue >= 0
+     ? static_cast<qreal>(progressValue) / static_cast<qreal>(progressSteps)
+     : -1.0);
+  this->forwardProgress(ss, available, progress);
+}
+
+//-----------------------------------------------------------------------------
+void qtStatusForwarder::notifierDestroyed(QObject* notifier)
+{
+  QTE_D(qtStatusForwarder);
+
+  auto const iter = d->children.find(notifier);
+  if (iter == d->children.end())
+    {
+    return;
+    }
+
+  if (d->progressMode == AggregateProgress && iter->progress >= 0.0)
+    {
+    // A notifier that was in progress counts as complete; it is forgotten
+    // once the current aggregation is done
+    iter->progress = 1.0;
+    iter->destroyed = true;
+    d->emitAggregateProgress();
+    }
+  else
+    {
+    d->children.erase(iter);
+
+    // The share of the remaining notifiers in the combined progress has
+    // changed (or, if none remain, the aggregation is complete)
+    if (d->progressMode == AggregateProgress && d->aggregating)
+      {
+      d->emitAggregateProgress();
+      }
+    }
 }
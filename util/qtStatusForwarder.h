@@ -7,6 +7,8 @@
 
 #include "qtStatusNotifier.h"
 
+class qtStatusForwarderPrivate;
+
 /// Helper class to redirect status notifications from one source to itself.
 ///
 /// This class provides a base class for users that wish to both send their own
@@ -15,26 +17,58 @@
 /// connecting other status notifiers to the forwarder class and reemitting
 /// their notifications with the original qtStatusSource replaces by the
 /// qtStatusSource of the forwarder instance.
+///
+/// Optionally, the forwarder can instead combine the progress of the
+/// connected notifiers, weighting each as specified when it was connected.
+/// Since forwarders are themselves notifiers, they may be nested to report
+/// the progress of a hierarchy of jobs.
 class QTE_EXPORT qtStatusForwarder : public qtStatusNotifier
 {
   Q_OBJECT
 
 public:
+  enum ProgressMode
+    {
+    /// Reemit the progress of each connected notifier as it is received.
+    ForwardProgress,
+    /// Emit the weighted average progress of all connected notifiers.
+    ///
+    /// A notifier that has not yet reported progress counts as not started,
+    /// while one that has cleared its progress, or that has been destroyed,
+    /// counts as complete. When every connected notifier is complete, the
+    /// forwarder clears its own progress, and the next report from any
+    /// notifier starts a new aggregation.
+    AggregateProgress
+    };
+
   qtStatusForwarder();
   virtual ~qtStatusForwarder();
 
+  void setProgressMode(ProgressMode);
+  ProgressMode progressMode() const;
+
   /// Connect another notifier to this forwarder.
   ///
   /// This connects the notifications of the specified notifier to this
   /// forwarder instance. The notifications of the specified notifier will be
-  /// reemitted from this forwarder using its status source.
-  void connect(qtStatusNotifier*);
+  /// reemitted from this forwarder using its status source. The \p weight is
+  /// used to combine the notifier's progress in
+  /// qtStatusForwarder::AggregateProgress mode.
+  void connect(qtStatusNotifier*, qreal weight = 1.0);
   using QObject::connect;
 
 protected slots:
   void forwardStatusMessage(qtStatusSource, QString);
   void forwardProgress(qtStatusSource, bool, qreal);
   void forwardProgress(qtStatusSource, bool, int, int);
+
+  void notifierDestroyed(QObject*);
+
+protected:
+  QTE_DECLARE_PRIVATE_RPTR(qtStatusForwarder)
+
+private:
+  QTE_DECLARE_PRIVATE(qtStatusForwarder)
 };
 
 #endif
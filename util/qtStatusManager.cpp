@@ -5,18 +5,46 @@
 #include <QtCore>
 
 #include <QApplication>
+#include <QElapsedTimer>
 #include <QHash>
 #include <QLabel>
 #include <QList>
 #include <QProgressBar>
+#include <QTimer>
 
 #include "../core/qtDebug.h"
 
 #include "qtStatusManager.h"
 #include "qtStatusSourcePrivate.h"
 
+#include <list>
+
 QTE_IMPLEMENT_D_FUNC(qtStatusManager)
 
+namespace // anonymous
+{
+
+// Minimum interval between samples of the rate of aggregate progress, and
+// the weight given to each new sample when smoothing the rate
+const qint64 etaSampleInterval = 500;
+const qreal etaSmoothing = 0.3;
+
+//-----------------------------------------------------------------------------
+QString formatDuration(qint64 msec)
+{
+  const qint64 seconds = (msec + 999) / 1000;
+  const qint64 h = seconds / 3600;
+  const qint64 m = (seconds / 60) % 60;
+  const qint64 s = seconds % 60;
+
+  const QChar zero('0');
+  return (h > 0 ? QString("%1:%2:%3").arg(h).arg(m, 2, 10, zero)
+                                     .arg(s, 2, 10, zero)
+                : QString("%1:%2").arg(m).arg(s, 2, 10, zero));
+}
+
+} // namespace <anonymous>
+
 //-----------------------------------------------------------------------------
 class qtStatusManagerPrivate
 {
@@ -37,10 +65,29 @@ public:
     };
 
   qtStatusManagerPrivate(qtStatusManager* q)
-    : q_ptr(q), debugArea(qtDebug::InvalidArea) {}
+    : q_ptr(q), debugArea(qtDebug::InvalidArea), updateRate(0),
+      displayMode(qtStatusManager::ShowLatest), completedWeight(0.0),
+      etaLastTime(0), etaLastFraction(0.0), etaRate(-1.0)
+    {
+    this->updateTimer.setSingleShot(true);
+    }
+
+  typedef std::list<qtStatusSource> SenderList;
 
   void setLastSender(qtStatusSource&);
-  void removeSendersByObject(const QObject*);
+  void removeSender(const QObject*);
+  bool isLastSender(const qtStatusSource&) const;
+
+  void setText(qtStatusSource&, const QString& text);
+  void setProgress(qtStatusSource&, bool available, int value,
+                   int minimum, int maximum, const QString& format);
+  bool takePostedStatus(qtStatusSource&);
+
+  void retireProgress(const qtStatusSource&);
+  void aggregateProgress(StatusInfo&);
+  qint64 estimateRemaining(qreal fraction);
+
+  void requestUpdate();
   void update();
 
 protected:
@@ -51,9 +98,37 @@ protected:
   QList<QLabel*> labels;
   QList<QProgressBar*>progressBars;
 
-  QList<qtStatusSource> senders;
+  // Sources that have status, in order of most recent update; the position
+  // of each in the list is indexed by owner, so that a source can be moved
+  // to the end or removed in constant time
+  SenderList senders;
+  QHash<const QObject*, SenderList::iterator> senderPositions;
   QHash<const QObject*, StatusInfo> status;
 
+  // Watched sources with posted status that has not yet been taken
+  QList<qtStatusSource> postedSources;
+
+  // Coalescing of updates; when updateRate is non-zero, updates are deferred
+  // until at least updateInterval() has elapsed since the last update
+  int updateRate;
+  QTimer updateTimer;
+  QElapsedTimer lastUpdate;
+
+  int updateInterval() const { return qMax(1, 1000 / this->updateRate); }
+
+  // Aggregation of progress; completedWeight is the total weight of sources
+  // that have finished since no sources last had progress available
+  qtStatusManager::DisplayMode displayMode;
+  QHash<const QObject*, qreal> weights;
+  qreal completedWeight;
+
+  // Estimation of the remaining time, from the smoothed rate of change (per
+  // millisecond) of the aggregate progress
+  QElapsedTimer etaClock;
+  qint64 etaLastTime;
+  qreal etaLastFraction;
+  qreal etaRate;
+
 private:
   QTE_DECLARE_PUBLIC(qtStatusManager)
 };
@@ -77,13 +152,23 @@ void qtStatusManagerPrivate::setLastSender(qtStatusSource& source)
 {
   QTE_Q(qtStatusManager);
 
-  // Clear this sender's status when it goes away
-  q->connect(source.d_ptr.data(), SIGNAL(ownerDestroyed(qtStatusSource)),
-             q, SLOT(removeSource(qtStatusSource)), Qt::UniqueConnection);
-
-  // Move sender to top of the list, if not already there
-  this->senders.removeAll(source);
-  this->senders.append(source);
+  auto const iter = this->senderPositions.find(source.owner());
+  if (iter != this->senderPositions.end())
+    {
+    // Move sender to the end of the list, if not already there
+    this->senders.splice(this->senders.end(), this->senders, iter.value());
+    }
+  else
+    {
+    // Clear this sender's status when it goes away; this only needs to be
+    // done when the sender is added, which avoids the cost of connecting for
+    // every update
+    q->connect(source.d_ptr.data(), SIGNAL(ownerDestroyed(qtStatusSource)),
+               q, SLOT(removeSource(qtStatusSource)), Qt::UniqueConnection);
+
+    this->senders.push_back(source);
+    this->senderPositions.insert(source.owner(), --this->senders.end());
+    }
 
   // Check if the sender was deleted while we were adding it
   if (source.isOwnerDestroyed())
@@ -93,33 +178,279 @@ void qtStatusManagerPrivate::setLastSender(qtStatusSource& source)
 }
 
 //-----------------------------------------------------------------------------
-void qtStatusManagerPrivate::removeSendersByObject(const QObject* obj)
+void qtStatusManagerPrivate::removeSender(const QObject* obj)
+{
+  auto const iter = this->senderPositions.find(obj);
+  if (iter != this->senderPositions.end())
+    {
+    this->senders.erase(iter.value());
+    this->senderPositions.erase(iter);
+    }
+}
+
+//-----------------------------------------------------------------------------
+bool qtStatusManagerPrivate::isLastSender(const qtStatusSource& source) const
+{
+  return !this->senders.empty() && this->senders.back() == source;
+}
+
+//-----------------------------------------------------------------------------
+void qtStatusManagerPrivate::setText(
+  qtStatusSource& source, const QString& text)
+{
+  qtDebug(this->debugArea) << "setting status text" << source << text;
+
+  if (text.isEmpty())
+    {
+    // No text means we should clear this sender's status
+    this->retireProgress(source);
+    this->removeSender(source.owner());
+    this->status.remove(source.owner());
+    }
+  else
+    {
+    StatusInfo& si = this->status[source.owner()];
+    si.text = text;
+    this->setLastSender(source);
+    }
+}
+
+//-----------------------------------------------------------------------------
+void qtStatusManagerPrivate::setProgress(
+  qtStatusSource& source, bool available, int value,
+  int minimum, int maximum, const QString& format)
+{
+  qtDebug(this->debugArea)
+      << "setting progress" << source
+      << "( available =" << available
+      << "value =" << value << '/' << minimum << '-' << maximum
+      << "format =" << format << ')';
+
+  if (!available)
+    {
+    this->retireProgress(source);
+    }
+
+  StatusInfo& si = this->status[source.owner()];
+  si.progressAvailable = available;
+  si.progressMinimum = minimum;
+  si.progressMaximum = maximum;
+  si.progressValue = value;
+  si.progressFormat = format;
+
+  this->setLastSender(source);
+}
+
+//-----------------------------------------------------------------------------
+bool qtStatusManagerPrivate::takePostedStatus(qtStatusSource& source)
+{
+  auto* const sd = source.d_ptr.data();
+  sd->rearm();
+
+  bool changed = false;
+
+  // Apply progress first, so that a posted empty message (which clears the
+  // status) is not undone by progress that was posted along with it
+  int value, steps;
+  if (sd->takeProgress(value, steps))
+    {
+    switch (steps)
+      {
+      case qtStatusSourcePrivate::ProgressUnavailable:
+        this->setProgress(source, false, -10000, 0, 10000, "%p%");
+        break;
+      case qtStatusSourcePrivate::ProgressFraction:
+        this->setProgress(source, true, value, 0, 10000, "%p%");
+        break;
+      default:
+        this->setProgress(source, true, value, 0, steps, "%v / %m");
+        break;
+      }
+    changed = true;
+    }
+
+  const QScopedPointer<QString> message(sd->takeMessage());
+  if (message)
+    {
+    this->setText(source, *message);
+    changed = true;
+    }
+
+  return changed;
+}
+
+//-----------------------------------------------------------------------------
+void qtStatusManagerPrivate::retireProgress(const qtStatusSource& source)
+{
+  // In aggregate mode, count the progress of a source that is finishing as
+  // complete, so that the combined progress does not go backwards
+  if (this->displayMode == qtStatusManager::ShowAggregate &&
+      this->status.value(source.owner()).progressAvailable &&
+      this->senderPositions.contains(source.owner()))
+    {
+    this->completedWeight += this->weights.value(source.owner(), 1.0);
+    }
+}
+
+//-----------------------------------------------------------------------------
+void qtStatusManagerPrivate::aggregateProgress(StatusInfo& si)
 {
-  QList<qtStatusSource>::iterator iter = this->senders.begin();
-  while (iter != this->senders.end())
+  qreal total = this->completedWeight;
+  qreal weight = this->completedWeight;
+  bool available = false;
+  bool determinate = (this->completedWeight > 0.0);
+
+  for (auto const& source : this->senders)
     {
-    if (iter->owner() == obj)
+    const StatusInfo& info = this->status[source.owner()];
+    if (!info.progressAvailable)
       {
-      iter = this->senders.erase(iter);
+      continue;
       }
-    else
+
+    const qreal w = this->weights.value(source.owner(), 1.0);
+    const int range = info.progressMaximum - info.progressMinimum;
+
+    available = true;
+    weight += w;
+
+    // Sources with indeterminate progress add to the total weight, but do
+    // not contribute any progress
+    if (info.progressValue >= 0 && range > 0)
       {
-      ++iter;
+      const qreal fraction =
+        static_cast<qreal>(info.progressValue - info.progressMinimum) /
+        static_cast<qreal>(range);
+      total += w * qBound(0.0, fraction, 1.0);
+      determinate = true;
       }
     }
+
+  if (!available)
+    {
+    // Nothing is in progress; start afresh with the next job
+    this->completedWeight = 0.0;
+    this->etaClock.invalidate();
+    si.progressAvailable = false;
+    return;
+    }
+
+  si.progressAvailable = true;
+  si.progressMinimum = 0;
+  si.progressMaximum = 10000;
+
+  if (!determinate || !(weight > 0.0))
+    {
+    si.progressValue = -1;
+    return;
+    }
+
+  const qreal fraction = total / weight;
+  si.progressValue = static_cast<int>(fraction * 10000.0);
+  si.progressFormat = "%p%";
+
+  const qint64 remaining = this->estimateRemaining(fraction);
+  if (remaining >= 0)
+    {
+    si.progressFormat += ' ';
+    si.progressFormat +=
+      qtStatusManager::tr("(%1 remaining)").arg(formatDuration(remaining));
+    }
+}
+
+//-----------------------------------------------------------------------------
+qint64 qtStatusManagerPrivate::estimateRemaining(qreal fraction)
+{
+  // Restart the estimate if progress goes backwards (e.g. because a new job
+  // was started)
+  if (!this->etaClock.isValid() || fraction < this->etaLastFraction)
+    {
+    this->etaClock.start();
+    this->etaLastTime = 0;
+    this->etaLastFraction = fraction;
+    this->etaRate = -1.0;
+    return -1;
+    }
+
+  // Sample the rate of progress periodically, smoothing it to reduce jitter
+  const qint64 now = this->etaClock.elapsed();
+  const qint64 elapsed = now - this->etaLastTime;
+  if (elapsed >= etaSampleInterval)
+    {
+    const qreal rate = (fraction - this->etaLastFraction) /
+                       static_cast<qreal>(elapsed);
+    this->etaRate = (this->etaRate < 0.0
+                     ? rate
+                     : (etaSmoothing * rate) +
+                       ((1.0 - etaSmoothing) * this->etaRate));
+    this->etaLastTime = now;
+    this->etaLastFraction = fraction;
+    }
+
+  if (!(this->etaRate > 0.0))
+    {
+    return -1;
+    }
+
+  return static_cast<qint64>((1.0 - fraction) / this->etaRate);
+}
+
+//-----------------------------------------------------------------------------
+void qtStatusManagerPrivate::requestUpdate()
+{
+  if (this->updateRate <= 0)
+    {
+    this->update();
+    return;
+    }
+
+  // If an update is already scheduled, it will pick up the latest status
+  if (this->updateTimer.isActive())
+    {
+    return;
+    }
+
+  // Update now if the last update was long enough ago; otherwise, schedule an
+  // update for when the interval will have elapsed
+  const qint64 interval = this->updateInterval();
+  const qint64 elapsed =
+    (this->lastUpdate.isValid() ? this->lastUpdate.elapsed() : interval);
+  if (elapsed >= interval)
+    {
+    this->update();
+    }
+  else
+    {
+    this->updateTimer.start(static_cast<int>(interval - elapsed));
+    }
 }
 
 //-----------------------------------------------------------------------------
 void qtStatusManagerPrivate::update()
 {
+  // Take status that was posted since the last update
+  if (!this->postedSources.isEmpty())
+    {
+    QList<qtStatusSource> sources;
+    sources.swap(this->postedSources);
+    for (auto& source : sources)
+      {
+      this->takePostedStatus(source);
+      }
+    }
+
+  // Any pending update is now redundant
+  this->updateTimer.stop();
+  this->lastUpdate.start();
+
   StatusInfo si;
 
-  if (!this->senders.isEmpty())
+  if (!this->senders.empty())
     {
-    si = this->status[this->senders.last().owner()];
+    si = this->status[this->senders.back().owner()];
 
     qtDebug(this->debugArea)
-        << "updating status using sender" << this->senders.last()
+        << "updating status using sender" << this->senders.back()
         << "status" << si;
     }
   else
@@ -127,6 +458,11 @@ void qtStatusManagerPrivate::update()
     qtDebug(this->debugArea) << "clearing status";
     }
 
+  if (this->displayMode == qtStatusManager::ShowAggregate)
+    {
+    this->aggregateProgress(si);
+    }
+
   foreach (auto const label, this->labels)
     label->setText(si.text);
 
@@ -156,7 +492,11 @@ void qtStatusManagerPrivate::update()
 qtStatusManager::qtStatusManager(QObject* parent)
   : QObject(parent), d_ptr(new qtStatusManagerPrivate(this))
 {
+  QTE_D(qtStatusManager);
+
   qRegisterMetaType<qtStatusSource>("qtStatusSource");
+
+  connect(&d->updateTimer, &QTimer::timeout, this, [d]{ d->update(); });
 }
 
 //-----------------------------------------------------------------------------
@@ -171,6 +511,76 @@ void qtStatusManager::setDebugArea(qtDebugAreaAccessor area)
   d->debugArea = area;
 }
 
+//-----------------------------------------------------------------------------
+void qtStatusManager::setDisplayMode(DisplayMode mode)
+{
+  QTE_D(qtStatusManager);
+
+  if (d->displayMode != mode)
+    {
+    d->displayMode = mode;
+    d->completedWeight = 0.0;
+    d->etaClock.invalidate();
+    d->requestUpdate();
+    }
+}
+
+//-----------------------------------------------------------------------------
+qtStatusManager::DisplayMode qtStatusManager::displayMode() const
+{
+  QTE_D_CONST(qtStatusManager);
+  return d->displayMode;
+}
+
+//-----------------------------------------------------------------------------
+void qtStatusManager::setSourceWeight(qtStatusSource source, qreal weight)
+{
+  QTE_D(qtStatusManager);
+
+  // Forget the weight when the source goes away
+  connect(source.d_ptr.data(), SIGNAL(ownerDestroyed(qtStatusSource)),
+          this, SLOT(removeSource(qtStatusSource)), Qt::UniqueConnection);
+
+  d->weights.insert(source.owner(), qMax(0.0, weight));
+  if (d->displayMode == ShowAggregate)
+    {
+    d->requestUpdate();
+    }
+}
+
+//-----------------------------------------------------------------------------
+void qtStatusManager::setUpdateRate(int updatesPerSecond)
+{
+  QTE_D(qtStatusManager);
+
+  d->updateRate = qMax(0, updatesPerSecond);
+
+  // Apply any pending update if coalescing was disabled, or reschedule it
+  // according to the new rate
+  if (d->updateTimer.isActive())
+    {
+    d->updateTimer.stop();
+    d->requestUpdate();
+    }
+}
+
+//-----------------------------------------------------------------------------
+int qtStatusManager::updateRate() const
+{
+  QTE_D_CONST(qtStatusManager);
+  return d->updateRate;
+}
+
+//-----------------------------------------------------------------------------
+void qtStatusManager::flushUpdates()
+{
+  QTE_D(qtStatusManager);
+  if (d->updateTimer.isActive())
+    {
+    d->update();
+    }
+}
+
 //-----------------------------------------------------------------------------
 void qtStatusManager::addStatusLabel(QLabel* obj)
 {
@@ -215,6 +625,52 @@ void qtStatusManager::removeProgressBar(QProgressBar* obj)
   d->progressBars.removeAll(obj);
 }
 
+//-----------------------------------------------------------------------------
+void qtStatusManager::watchSource(qtStatusSource source)
+{
+  QTE_D(qtStatusManager);
+
+  qtDebug(d->debugArea) << "watching source" << source;
+
+  // Always use a queued connection, so that posts from this thread are also
+  // coalesced
+  auto* const sd = source.d_ptr.data();
+  connect(sd, SIGNAL(statusPosted(qtStatusSource)),
+          this, SLOT(applyPostedStatus(qtStatusSource)),
+          static_cast<Qt::ConnectionType>(
+            Qt::QueuedConnection | Qt::UniqueConnection));
+  connect(sd, SIGNAL(ownerDestroyed(qtStatusSource)),
+          this, SLOT(removeSource(qtStatusSource)), Qt::UniqueConnection);
+
+  // Pick up anything that was posted before the source was watched, as the
+  // corresponding notification was not received
+  if (sd->hasPosted())
+    {
+    this->applyPostedStatus(source);
+    }
+}
+
+//-----------------------------------------------------------------------------
+void qtStatusManager::applyPostedStatus(qtStatusSource source)
+{
+  QTE_D(qtStatusManager);
+
+  if (d->updateRate <= 0)
+    {
+    if (d->takePostedStatus(source))
+      {
+      d->update();
+      }
+    }
+  else
+    {
+    // Leave the values in the source's slot until the next update, so that
+    // further posts replace them without notifying again
+    d->postedSources.append(source);
+    d->requestUpdate();
+    }
+}
+
 //-----------------------------------------------------------------------------
 void qtStatusManager::removeObject(QObject* obj)
 {
@@ -236,15 +692,18 @@ void qtStatusManager::removeSource(qtStatusSource source)
   // Clear this object's status
   if (d->status.contains(source.owner()))
     {
-    bool needUpdate = (d->senders.last() == source);
+    bool needUpdate = d->isLastSender(source) ||
+                      (d->displayMode == ShowAggregate);
+    d->retireProgress(source);
     d->status.remove(source.owner());
-    d->senders.removeAll(source);
+    d->removeSender(source.owner());
     if (needUpdate)
       {
-      d->update();
+      d->requestUpdate();
       }
     }
 
+  d->weights.remove(source.owner());
 }
 
 //-----------------------------------------------------------------------------
@@ -259,7 +718,7 @@ void qtStatusManager::transferOwnership(const QObject* from,
         << "transferring status ownership from" << from << "to" << to;
 
     d->status.insert(to.owner(), d->status[from]);
-    d->removeSendersByObject(from);
+    d->removeSender(from);
     d->setLastSender(to);
     }
 }
@@ -268,23 +727,8 @@ void qtStatusManager::transferOwnership(const QObject* from,
 void qtStatusManager::setStatusText(qtStatusSource source, QString text)
 {
   QTE_D(qtStatusManager);
-
-  qtDebug(d->debugArea) << "setting status text" << source << text;
-
-  if (text.isEmpty())
-    {
-    // No text means we should clear this sender's status
-    d->senders.removeAll(source);
-    d->status.remove(source.owner());
-    }
-  else
-    {
-    qtStatusManagerPrivate::StatusInfo& si = d->status[source.owner()];
-    si.text = text;
-    d->setLastSender(source);
-    }
-
-  d->update();
+  d->setText(source, text);
+  d->requestUpdate();
 }
 
 //-----------------------------------------------------------------------------
@@ -308,20 +752,6 @@ void qtStatusManager::setProgress(qtStatusSource source, bool available,
                                   QString format)
 {
   QTE_D(qtStatusManager);
-
-  qtDebug(d->debugArea)
-      << "setting progress" << source
-      << "( available =" << available
-      << "value =" << value << '/' << minimum << '-' << maximum
-      << "format =" << format << ')';
-
-  qtStatusManagerPrivate::StatusInfo& si = d->status[source.owner()];
-  si.progressAvailable = available;
-  si.progressMinimum = minimum;
-  si.progressMaximum = maximum;
-  si.progressValue = value;
-  si.progressFormat = format;
-
-  d->setLastSender(source);
-  d->update();
+  d->setProgress(source, available, value, minimum, maximum, format);
+  d->requestUpdate();
 }
@@ -22,6 +22,16 @@ class QTE_EXPORT qtStatusManager : public QObject
   Q_OBJECT
 
 public:
+  enum DisplayMode
+    {
+    /// Show the status of the source that most recently reported status.
+    ShowLatest,
+    /// Show the text of the source that most recently reported status, and
+    /// the weighted combined progress of all sources, with an estimate of the
+    /// remaining time.
+    ShowAggregate
+    };
+
   explicit qtStatusManager(QObject* parent = nullptr);
   ~qtStatusManager();
 
@@ -33,9 +43,56 @@ public:
 
   void setDebugArea(qtDebugAreaAccessor area);
 
+  /// Set how the status of multiple sources is displayed.
+  ///
+  /// In qtStatusManager::ShowAggregate mode, the progress bars show the
+  /// average progress of all sources that have progress available, weighted
+  /// according to setSourceWeight. Sources that have finished (that is,
+  /// whose progress or status is cleared, or that are destroyed) count as
+  /// complete until no sources with progress remain, so that the combined
+  /// progress does not regress as individual jobs finish. An estimate of the
+  /// remaining time, based on the observed rate of progress, is added to the
+  /// progress bar text. Use qtStatusForwarder to combine the progress of
+  /// nested jobs.
+  void setDisplayMode(DisplayMode);
+  DisplayMode displayMode() const;
+
+  /// Set the weight of a source's progress in aggregate display mode.
+  ///
+  /// The default weight is 1.
+  void setSourceWeight(qtStatusSource, qreal weight);
+
   void transferOwnership(const QObject* from, qtStatusSource to);
 
+  /// Receive status posted through the shared status slot of a source.
+  ///
+  /// This arranges for status posted via qtStatusSource::postMessage and
+  /// qtStatusSource::postProgress to be shown by this manager. Posted values
+  /// are taken by the manager in its own thread, either immediately or, if an
+  /// update rate is set, when the status widgets are next updated.
+  ///
+  /// Posted values are consumed when they are taken, so a source must be
+  /// watched by at most one manager. Sources are never watched implicitly
+  /// (in particular, qtStatusNotifier::addReceiver does not watch the
+  /// notifier's source); the manager that should show posted status must
+  /// call this explicitly.
+  void watchSource(qtStatusSource);
+
+  /// Set the maximum rate at which status widgets are updated.
+  ///
+  /// By default (a rate of zero), status widgets are updated as soon as a
+  /// notification is received. If \p updatesPerSecond is positive,
+  /// notifications instead mark the displayed status as out of date, and the
+  /// widgets are updated at most \p updatesPerSecond times per second. Each
+  /// update uses the latest status, so intermediate values may be skipped,
+  /// but the final state (including clearing the status) is always shown.
+  void setUpdateRate(int updatesPerSecond);
+  int updateRate() const;
+
 public slots:
+  /// Apply any pending status update immediately.
+  void flushUpdates();
+
   void setStatusText(qtStatusSource source, QString text = {});
   void setProgress(qtStatusSource source, bool available = false,
                    qreal value = -1);
@@ -45,6 +102,7 @@ public slots:
                    int minimum, int maximum, QString format = "%p%");
 
 protected slots:
+  void applyPostedStatus(qtStatusSource);
   void removeObject(QObject*);
   void removeSource(qtStatusSource);
 
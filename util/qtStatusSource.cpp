@@ -8,9 +8,22 @@
 
 QTE_IMPLEMENT_D_FUNC(qtStatusSource)
 
+namespace // anonymous
+{
+
+//-----------------------------------------------------------------------------
+quint64 packProgress(int value, int steps)
+{
+  return (static_cast<quint64>(static_cast<quint32>(steps)) << 32) |
+         static_cast<quint64>(static_cast<quint32>(value));
+}
+
+} // namespace <anonymous>
+
 //-----------------------------------------------------------------------------
 qtStatusSourcePrivate::qtStatusSourcePrivate(QObject* obj)
-  : owner(obj), ownerRef(obj)
+  : owner(obj), ownerRef(obj),
+    progress(packProgress(0, NoProgress)), message(nullptr), posted(0)
 {
   if (obj)
     {
@@ -23,12 +36,74 @@ qtStatusSourcePrivate::qtStatusSourcePrivate(QObject* obj)
     }
 }
 
+//-----------------------------------------------------------------------------
+qtStatusSourcePrivate::~qtStatusSourcePrivate()
+{
+  delete this->message.loadAcquire();
+}
+
 //-----------------------------------------------------------------------------
 void qtStatusSourcePrivate::ownerDestroyed()
 {
   emit this->ownerDestroyed({this});
 }
 
+//-----------------------------------------------------------------------------
+void qtStatusSourcePrivate::notifyPosted()
+{
+  // Only the first post since the values were last taken needs to notify the
+  // manager; later posts just replace the values
+  if (this->posted.fetchAndStoreOrdered(1) == 0)
+    {
+    emit this->statusPosted({this});
+    }
+}
+
+//-----------------------------------------------------------------------------
+void qtStatusSourcePrivate::postProgress(int value, int steps)
+{
+  this->progress.storeRelease(packProgress(value, steps));
+  this->notifyPosted();
+}
+
+//-----------------------------------------------------------------------------
+void qtStatusSourcePrivate::postMessage(const QString& message)
+{
+  delete this->message.fetchAndStoreOrdered(new QString(message));
+  this->notifyPosted();
+}
+
+//-----------------------------------------------------------------------------
+bool qtStatusSourcePrivate::hasPosted() const
+{
+  return this->posted.loadAcquire() != 0;
+}
+
+//-----------------------------------------------------------------------------
+bool qtStatusSourcePrivate::takeProgress(int& value, int& steps)
+{
+  const quint64 p =
+    this->progress.fetchAndStoreAcquire(packProgress(0, NoProgress));
+
+  steps = static_cast<int>(static_cast<quint32>(p >> 32));
+  value = static_cast<int>(static_cast<quint32>(p));
+  return steps != NoProgress;
+}
+
+//-----------------------------------------------------------------------------
+QString* qtStatusSourcePrivate::takeMessage()
+{
+  return this->message.fetchAndStoreAcquire(nullptr);
+}
+
+//-----------------------------------------------------------------------------
+void qtStatusSourcePrivate::rearm()
+{
+  // Clear the posted flag before taking the values, so that a post that
+  // races with taking them notifies again rather than being missed
+  this->posted.fetchAndStoreOrdered(0);
+}
+
 //-----------------------------------------------------------------------------
 qtStatusSource::qtStatusSource(QObject* owner)
   : d_ptr(new qtStatusSourcePrivate(owner))
@@ -73,6 +148,35 @@ void qtStatusSource::setName(QObject* obj)
     }
 }
 
+//-----------------------------------------------------------------------------
+void qtStatusSource::postMessage(const QString& message)
+{
+  QTE_D(qtStatusSource);
+  d->postMessage(message);
+}
+
+//-----------------------------------------------------------------------------
+void qtStatusSource::postProgress(qreal progress)
+{
+  QTE_D(qtStatusSource);
+  d->postProgress(static_cast<int>(progress * 10000.0),
+                  qtStatusSourcePrivate::ProgressFraction);
+}
+
+//-----------------------------------------------------------------------------
+void qtStatusSource::postProgress(int value, int steps)
+{
+  QTE_D(qtStatusSource);
+  d->postProgress(value, qMax(0, steps));
+}
+
+//-----------------------------------------------------------------------------
+void qtStatusSource::clearProgress()
+{
+  QTE_D(qtStatusSource);
+  d->postProgress(-1, qtStatusSourcePrivate::ProgressUnavailable);
+}
+
 //-----------------------------------------------------------------------------
 qtStatusSource& qtStatusSource::operator=(const qtStatusSource& other)
 {
@@ -24,6 +24,28 @@ public:
 
   void setName(QObject*);
 
+  /// Post a status message through the source's shared status slot.
+  ///
+  /// The post methods write to a slot that is shared by all copies of the
+  /// source, and which is read by a qtStatusManager that is watching the
+  /// source (see qtStatusManager::watchSource). They may be called from any
+  /// thread, at any rate; posting progress costs only a few atomic
+  /// operations, and the manager is notified at most once each time it
+  /// consumes the posted values. Only the most recently posted message and
+  /// progress are retained.
+  ///
+  /// Posting an empty message clears the source's status.
+  void postMessage(const QString& message);
+
+  /// Post fractional progress (or busy, if \p progress is negative).
+  void postProgress(qreal progress);
+
+  /// Post progress as a number of completed steps.
+  void postProgress(int value, int steps);
+
+  /// Post that progress is not available.
+  void clearProgress();
+
   qtStatusSource& operator=(const qtStatusSource& other);
 
   bool operator==(const qtStatusSource& other) const;
@@ -6,6 +6,8 @@
 
 #include "qtEnableSharedFromThis.h"
 
+#include <QAtomicInteger>
+#include <QAtomicPointer>
 #include <QObject>
 #include <QPointer>
 
@@ -15,10 +17,31 @@ class qtStatusSourcePrivate
   Q_OBJECT
 
 public:
+  // Special values of the step count of the shared progress slot
+  enum
+    {
+    NoProgress = -3,
+    ProgressFraction = -2,
+    ProgressUnavailable = -1
+    };
+
   qtStatusSourcePrivate(QObject* owner);
+  ~qtStatusSourcePrivate();
+
+  // Shared status slot; the post methods may be called from any thread, and
+  // do not lock, while the take methods are used by qtStatusManager to
+  // consume the most recently posted values
+  void postProgress(int value, int steps);
+  void postMessage(const QString& message);
+
+  bool hasPosted() const;
+  bool takeProgress(int& value, int& steps);
+  QString* takeMessage();
+  void rearm();
 
 signals:
   void ownerDestroyed(qtStatusSource);
+  void statusPosted(qtStatusSource);
 
 protected slots:
   void ownerDestroyed();
@@ -33,4 +56,15 @@ private:
   QPointer<QObject> ownerRef;
   QString ownerIdentifier;
   QString displayIdentifier;
+
+  void notifyPosted();
+
+  // Progress step count (high word) and value (low word), stored together so
+  // that they are always read consistently
+  QAtomicInteger<quint64> progress;
+  QAtomicPointer<QString> message;
+
+  // Set when values have been posted, so that only the first post after the
+  // manager has taken the values emits statusPosted
+  QAtomicInt posted;
 };
@@ -6,8 +6,6 @@
 
 #include "../util/qtColorUtil.h"
 
-#include "../core/qtIndexRange.h"
-
 #include <QImage>
 #include <QPaintEvent>
 #include <QPainter>
@@ -109,26 +107,14 @@ void qtGradientWidget::paintEvent(QPaintEvent*)
   // Regenerate pixmap, if needed
   if (lastSize != currentSize || d->pixmap.isNull())
     {
-    QImage image(this->width(), 12, QImage::Format_RGB32);
     QColor c1 = this->palette().color(QPalette::Window);
     QColor c2 = this->palette().color(QPalette::WindowText);
     c2 = qtColorUtil::blend(c1, c2, 0.4);
 
-    const int k = this->width();
-    QList<QColor> g = d->gradient.render(k);
-
-    foreach (auto const i, qtIndexRange(k))
-      {
-      const QColor& color = g[i];
-      const qreal a = color.alphaF();
-      const QColor cg1 = qtColorUtil::blend(c1, color, a);
-      const QColor cg2 = qtColorUtil::blend(c2, color, a);
-      foreach (auto const j, qtIndexRange(12))
-        {
-        const QColor& cb = (((i % 12) > 5) != ((j % 12) > 5) ? cg1 : cg2);
-        image.setPixel(i, j, cb.rgb());
-        }
-      }
+    const QSize size = (d->orientation == Qt::Horizontal
+                        ? QSize(currentSize, 12) : QSize(12, currentSize));
+    const QImage image =
+      d->gradient.renderImage(size, d->orientation, c1, c2);
 
     d->pixmap = QPixmap::fromImage(image);
     }